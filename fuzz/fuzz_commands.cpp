@@ -0,0 +1,196 @@
+// Persistent-mode fuzz target for the command surface (processInput and every handler).
+//
+// One Game is created for the whole process and restored with Game::reset() before each input,
+// so an execution costs only the commands themselves. After every input the game's invariants
+// are checked; any violation aborts so the fuzzer records the input as a crash.
+//
+// Deep checks run on one input in kDeepEvery (chosen by a hash of the input, so a crash reproduces),
+// or on every input with --deep: each command that leaves an undo step is undone (which must return
+// the exact state it started from) and replayed, and at the end the game is saved and restored into
+// a second game that must end up identical. Replaying files always runs them.
+//
+// Input format: newline-separated commands, exactly as a player would type them (a line can hold a
+// ';'-separated batch).
+//
+// Builds:
+//   make fuzz                                        standalone driver (random inputs or files)
+//   make clean && make fuzz CXX=clang++ FUZZ=libfuzzer    libFuzzer build with ASan/UBSan
+
+#include "Game.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+namespace {
+
+// Inputs that get the deep checks: one in this many, or all of them with --deep
+constexpr uint32_t kDeepEvery = 16;
+bool alwaysDeep = false;
+
+std::ostream& discardStream() {
+    static std::ostream discard(nullptr);
+    return discard;
+}
+
+Game& fuzzGame() {
+    static Game game(discardStream(), 0);
+    return game;
+}
+
+// Target of the save/restore round trip
+Game& restoredGame() {
+    static Game game(discardStream(), 0);
+    return game;
+}
+
+// FNV-1a, so whether an input gets the deep checks depends only on the input
+uint32_t inputHash(const uint8_t* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i) hash = (hash ^ data[i]) * 16777619u;
+    return hash;
+}
+
+// Runs one command. With 'deep', checks that undoing it restores the state it started from and plays it again
+void runCommand(Game& game, const std::string& line, bool deep) {
+    if (!deep) {
+        game.processInput(line);
+        return;
+    }
+    static std::string before, after;
+    game.stateKey(before);
+    size_t depth = game.undoDepth();
+    game.processInput(line);
+    if (game.undoDepth() <= depth) return;
+
+    game.processInput("undo");
+    game.stateKey(after);
+    std::string problem;
+    if (after != before || !game.checkInvariants(&problem)) {
+        std::cerr << "Undo of '" << line << "' did not restore the previous state. " << problem << std::endl;
+        std::abort();
+    }
+    game.processInput(line);
+}
+
+void runInput(const uint8_t* data, size_t size) {
+    Game& game = fuzzGame();
+    game.reset();
+    bool deep = alwaysDeep || inputHash(data, size) % kDeepEvery == 0;
+
+    std::string line;
+    for (size_t i = 0; i <= size; ++i) {
+        if (i == size || data[i] == '\n') {
+            if (!line.empty()) {
+                runCommand(game, line, deep);
+                line.clear();
+            }
+            if (game.gameOver) break;
+        } else {
+            line.push_back(static_cast<char>(data[i]));
+        }
+    }
+
+    std::string problem;
+    if (!game.checkInvariants(&problem)) {
+        std::cerr << "Invariant violated: " << problem << std::endl;
+        std::abort();
+    }
+    if (!deep) return;
+
+    static std::vector<uint8_t> saved;
+    saved.clear();
+    game.saveState(saved);
+    Game& restored = restoredGame();
+    if (!restored.restoreState(saved.data(), saved.size()) || restored.stateKey() != game.stateKey() ||
+        restored.undoDepth() != game.undoDepth() || !restored.checkInvariants(&problem)) {
+        std::cerr << "Save/restore round trip differs: " << problem << std::endl;
+        std::abort();
+    }
+}
+
+} // namespace
+
+// libFuzzer leaves flags that start with "--" to the target
+extern "C" int LLVMFuzzerInitialize(int* argc, char*** argv) {
+    for (int i = 1; i < *argc; ++i) {
+        if (std::strcmp((*argv)[i], "--deep") == 0) alwaysDeep = true;
+    }
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    runInput(data, size);
+    return 0;
+}
+
+#ifndef VC_LIBFUZZER
+// Without libFuzzer: replay the files given on the command line, or, with none,
+// run random command sequences drawn from the game's vocabulary and report the execution rate.
+int main(int argc, char* argv[]) {
+    LLVMFuzzerInitialize(&argc, &argv);
+    std::vector<const char*> files;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--deep") != 0) files.push_back(argv[i]);
+    }
+    if (!files.empty()) {
+        alwaysDeep = true;
+        for (const char* path : files) {
+            struct stat info;
+            std::ifstream file(path, std::ios::binary);
+            if (stat(path, &info) != 0 || !S_ISREG(info.st_mode) || !file.is_open()) {
+                // A mistyped crash path must not pass as a clean replay
+                std::cerr << "Could not open " << path << std::endl;
+                return 1;
+            }
+            std::stringstream contents;
+            contents << file.rdbuf();
+            std::string input = contents.str();
+            runInput(reinterpret_cast<const uint8_t*>(input.data()), input.size());
+        }
+        std::cout << "Replayed " << files.size() << " input(s) without invariant violations." << std::endl;
+        return 0;
+    }
+
+    static const char* verbs[] = {
+        "go", "move", "look", "examine", "x", "get", "take", "inventory", "talk to", "talk", "help", "hint",
+        "use", "clean", "organize", "trim", "leave", "assist", "travel", "undo", "", "the", "quit"
+    };
+    static const char* nouns[] = {
+        "enter-center", "enter", "leave-center", "storage", "office", "west-wing", "exit-center", "hall",
+        "guide", "memorial", "archives", "garden", "figures", "music_box", "candle", "papers", "gas_can",
+        "spare_tire", "oil_fluid", "first_aid_kit", "surgical_item", "main_hall", "storage_room",
+        "west_wing", "car_breakdown", "vc_entrance", "reveal_spot", "", "xyzzy"
+    };
+
+    const size_t runs = 200000;
+    std::mt19937 rng(12345);
+    std::string input;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t run = 0; run < runs; ++run) {
+        input.clear();
+        size_t commands = 1 + rng() % 40;
+        for (size_t c = 0; c < commands; ++c) {
+            const char* verb = verbs[rng() % (sizeof(verbs) / sizeof(verbs[0]))];
+            if (std::string(verb) == "quit" && rng() % 8 != 0) continue;
+            input += verb;
+            input += ' ';
+            input += nouns[rng() % (sizeof(nouns) / sizeof(nouns[0]))];
+            input += rng() % 4 == 0 ? ';' : '\n'; // Some commands are joined into batches
+        }
+        runInput(reinterpret_cast<const uint8_t*>(input.data()), input.size());
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << runs << " executions in " << seconds << " s (" << static_cast<size_t>(runs / seconds)
+              << " exec/s, deep checks on " << (alwaysDeep ? "all" : "1 in " + std::to_string(kDeepEvery))
+              << "), no invariant violations." << std::endl;
+    return 0;
+}
+#endif
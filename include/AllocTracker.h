@@ -0,0 +1,84 @@
+#ifndef ALLOC_TRACKER_H
+#define ALLOC_TRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Heap allocations counted on one thread
+struct AllocCounts {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+};
+
+// Counts heap allocations per thread and attributes each to the innermost ALLOC_SCOPE open at the
+// time (e.g. the command handler that was running).
+//
+// A program opts in by replacing the global operator new with one that calls record(), as
+// tools/alloc_budget.cpp does; the game itself never replaces the allocator, so other tools keep
+// their own replacements. Build with 'make ALLOC=1' to compile the ALLOC_SCOPE probes in; otherwise
+// they vanish, kCompiledIn is false and every allocation counts only in the totals. The counters
+// live in plain thread-local storage, so counting never allocates or takes a lock.
+class AllocTracker {
+public:
+#ifdef VC_ALLOC_TRACKING
+    static constexpr bool kCompiledIn = true;
+#else
+    static constexpr bool kCompiledIn = false;
+#endif
+
+    // Distinct scope names tracked per thread; allocations under further names count only in the totals
+    static constexpr size_t kMaxScopes = 64;
+
+    // Everything the calling thread allocated since its last reset()
+    static AllocCounts totals();
+
+    // What the calling thread allocated while 'scope' was the innermost open scope
+    static AllocCounts scope(const char* name);
+
+    // Calls visit(name, counts) for every scope the calling thread has allocated under
+    template <typename Visit>
+    static void forEachScope(Visit visit) {
+        for (size_t i = 0; i < scopeCount(); ++i) {
+            if (scopeAt(i).allocations > 0) visit(scopeName(i), scopeAt(i));
+        }
+    }
+
+    // Zeroes the calling thread's counters (scope names are kept)
+    static void reset();
+
+    // Counts one allocation of 'bytes'; called by a counting operator new
+    static void record(size_t bytes);
+
+    // Makes the scope called 'name' the current one and returns the previous one's slot
+    static int enter(const char* name);
+    static void leave(int previous);
+
+private:
+    static size_t scopeCount();
+    static const char* scopeName(size_t slot);
+    static const AllocCounts& scopeAt(size_t slot);
+};
+
+// RAII helper: attributes the allocations of the enclosing scope to 'name'. Names must be string
+// literals or otherwise outlive the thread (they are stored by pointer)
+class AllocScope {
+public:
+    explicit AllocScope(const char* name) : previous(AllocTracker::enter(name)) {}
+    ~AllocScope() { AllocTracker::leave(previous); }
+
+    AllocScope(const AllocScope&) = delete;
+    AllocScope& operator=(const AllocScope&) = delete;
+
+private:
+    int previous;
+};
+
+#ifdef VC_ALLOC_TRACKING
+#define ALLOC_CONCAT_INNER(a, b) a##b
+#define ALLOC_CONCAT(a, b) ALLOC_CONCAT_INNER(a, b)
+#define ALLOC_SCOPE(name) AllocScope ALLOC_CONCAT(allocScope_, __LINE__)(name)
+#else
+#define ALLOC_SCOPE(name) ((void)0)
+#endif
+
+#endif // ALLOC_TRACKER_H
@@ -0,0 +1,45 @@
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <string>
+#include <cstdint>
+
+// Canonical verbs understood by Game::processInput. Several typed words can map to one verb
+// (e.g. "get", "take" and "pickup" are all Verb::Get).
+// The numeric values are stored in session transcripts, so only ever append new verbs.
+enum class Verb : uint8_t {
+    Unknown,
+    Quit,
+    Go,
+    Look,
+    Examine,
+    Get,
+    Inventory,
+    Talk,
+    Help,
+    Use,
+    Clean,
+    Organize,
+    Trim,
+    Leave,
+    Assist,
+    Travel,
+    Hint,
+    Ended, // Not typed: marks the ending a session reached in transcripts
+    Ack,   // Acknowledges a state delta (JSON clients with deltas enabled)
+    Undo,
+    EndingUndone, // Not typed: marks that undo took the session's ending back in transcripts
+    Count // Number of verbs, not a verb
+};
+
+// Maps a lowercase command word (including aliases) to its verb
+Verb verbFromWord(const std::string& word);
+
+// Typo-tolerant fallback for verbFromWord: the known command word closest to 'word'
+// (e.g. "examine" for "examin"), or nullptr if none is close enough or two are equally close
+const std::string* closestVerbWord(const std::string& word);
+
+// Canonical name of a verb, e.g. "examine" for Verb::Examine
+const char* verbName(Verb verb);
+
+#endif // COMMAND_H
@@ -0,0 +1,145 @@
+#ifndef CONTENT_STORE_H
+#define CONTENT_STORE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+
+class Game;
+enum class GameState; // Forward declaration
+
+// All text that can be changed while sessions are running: room names and descriptions, the
+// description of every element stage, the Guide's dialogue and the help texts.
+// A snapshot is never modified once it has been published to a ContentStore.
+struct ContentSnapshot {
+    struct RoomText {
+        std::string name;
+        std::string description;
+    };
+
+    uint64_t version = 0; // Assigned by ContentStore::publish
+    std::unordered_map<std::string, RoomText> rooms;                          // By room id
+    std::unordered_map<std::string, std::vector<std::string>> elementStages;  // By "room_id/element_name"
+    std::map<GameState, std::vector<std::string>> dialogueLines;              // Same layout as Guide
+    std::map<std::string, std::string> commandExplanations;                   // Same layout as Guide
+
+    // The built-in content of 'game'
+    static std::unique_ptr<ContentSnapshot> fromGame(const Game& game);
+
+    // Applies the overrides in a content file. Lines look like
+    //   room <room_id> name = <text>
+    //   room <room_id> description = <text>
+    //   element <room_id> <element_name> <stage> = <text>
+    //   dialogue <GAME_STATE> = <text>      (repeat for alternatives; replaces that state's lines)
+    //   help <topic> = <text>
+    // Blank lines and lines starting with '#' are ignored. Returns false and describes the first
+    // problem in 'error' if the file cannot be read or a line is malformed
+    bool loadFile(const std::string& path, std::string* error = nullptr);
+};
+
+// Publishes content snapshots to any number of reader threads (read-copy-update).
+//
+// Readers never lock: a ReadGuard claims a reader slot, records the current epoch in it and loads
+// the snapshot pointer, all with atomics. publish() swaps in the new snapshot and retires the old
+// one under the next epoch. A retired snapshot is deleted once no reader slot still holds an epoch
+// from before its retirement, so a reader can keep using what it loaded for as long as its guard lives.
+class ContentStore {
+public:
+    // Readers that can hold a guard at the same time; further readers wait for a free slot
+    static constexpr size_t kReaderSlots = 128;
+
+    // Constructor. 'initial' becomes version 1
+    explicit ContentStore(std::unique_ptr<ContentSnapshot> initial);
+    ~ContentStore();
+
+    ContentStore(const ContentStore&) = delete;
+    ContentStore& operator=(const ContentStore&) = delete;
+
+    // Version of the newest snapshot; a single atomic load, for cheap "anything new?" checks
+    uint64_t version() const { return publishedVersion.load(std::memory_order_acquire); }
+
+    // Makes 'next' the current snapshot and returns its version. Readers holding the previous one keep it
+    uint64_t publish(std::unique_ptr<ContentSnapshot> next);
+
+    // Old snapshots still waiting for readers to move on
+    size_t retiredCount() const;
+
+    // Pins the current snapshot for as long as the guard exists
+    class ReadGuard {
+    public:
+        explicit ReadGuard(const ContentStore& store);
+        ~ReadGuard();
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+        const ContentSnapshot& operator*() const { return *snapshot; }
+        const ContentSnapshot* operator->() const { return snapshot; }
+
+    private:
+        const ContentStore& store;
+        size_t slot;
+        const ContentSnapshot* snapshot;
+    };
+
+private:
+    // One cache line per slot so readers on different cores don't contend
+    struct alignas(64) ReaderSlot {
+        std::atomic<bool> claimed{false};
+        std::atomic<uint64_t> epoch{0}; // 0 while no snapshot is held
+    };
+
+    struct Retired {
+        uint64_t epoch; // Readers pinned before this epoch may still hold 'snapshot'
+        const ContentSnapshot* snapshot;
+    };
+
+    // Deletes retired snapshots no reader can reach any more. Caller holds writerMutex
+    void reclaimLocked();
+
+    mutable ReaderSlot slots[kReaderSlots];
+    std::atomic<const ContentSnapshot*> current;
+    std::atomic<uint64_t> globalEpoch;
+    std::atomic<uint64_t> publishedVersion;
+
+    mutable std::mutex writerMutex; // Serializes publishers only
+    std::vector<Retired> retired;
+};
+
+// Watches a content file and publishes it (on top of a base snapshot) whenever it changes
+class ContentWatcher {
+public:
+    // Constructor. Starts polling 'path' every 'interval' on a background thread
+    ContentWatcher(ContentStore& store, std::string path, const ContentSnapshot& base,
+                   std::chrono::milliseconds interval = std::chrono::milliseconds(500));
+    ~ContentWatcher();
+
+    ContentWatcher(const ContentWatcher&) = delete;
+    ContentWatcher& operator=(const ContentWatcher&) = delete;
+
+    // Loads and publishes the file right away. On error the current content stays in place
+    bool reloadNow(std::string* error = nullptr);
+
+private:
+    void watchLoop();
+
+    ContentStore& store;
+    std::string path;
+    ContentSnapshot base;
+    std::chrono::milliseconds interval;
+    std::atomic<int64_t> lastModified; // Also written by reloadNow() on the caller's thread
+
+    std::mutex stopMutex;
+    std::condition_variable stopSignal;
+    bool stopping;
+    std::thread worker;
+};
+
+#endif // CONTENT_STORE_H
@@ -0,0 +1,92 @@
+#ifndef COOP_GAME_H
+#define COOP_GAME_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <unordered_map>
+#include <iostream>
+#include "Game.h"
+
+// Several players sharing one world: the same rooms and items, one Guide and one story.
+//
+// Commands from different players may run at the same time on different threads:
+//  - look, examine, inventory, go and get only touch the acting player and the rooms involved. They
+//    run under a shared hold of the world lock plus the mutex of each room they use, so players in
+//    different rooms never wait for each other, and an item taken by one player is gone for everyone.
+//  - Everything that can move the story (talking, tasks, using items, choices, help and hints, travel)
+//    runs with the world lock held exclusively, with the acting player swapped into the Game.
+//    go and get take this path only when they actually set off a story beat.
+// Output a command produces goes to the acting player; story beats are also shown to everyone else.
+class CoopGame {
+public:
+    // Constructor. Sets up the story world
+    CoopGame();
+
+    CoopGame(const CoopGame&) = delete;
+    CoopGame& operator=(const CoopGame&) = delete;
+
+    // Replaces the world, e.g. with a generated one for load tests. Call before anyone joins
+    void loadWorld(std::vector<std::unique_ptr<Room>> rooms, const std::string& startRoomId);
+
+    // Adds a player at the starting location, shows them the room and returns their id.
+    // 'output' receives everything addressed to this player and must outlive their membership
+    size_t join(const std::string& name, std::ostream& output);
+
+    // Removes a player; whatever they carried is left in the room they were in
+    void leave(size_t playerId);
+
+    // Runs one command for a player. Commands of one player run one at a time, in call order
+    void processInput(size_t playerId, const std::string& rawInput);
+
+    // True once any player has reached an ending
+    bool isOver() const;
+    GameState state() const;
+    size_t playerCount() const;
+
+    // Like Game::checkInvariants, counting every player's inventory. Takes the world lock exclusively
+    bool checkInvariants(std::string* problem = nullptr) const;
+
+private:
+    struct Member {
+        std::string name;
+        Player player;
+        std::ostream* out;
+        std::mutex turnMutex;                  // One command at a time per player
+        std::mutex outputMutex;                // Guards writes to 'out' (story beats arrive from other threads)
+        std::atomic<const Room*> location;     // Mirrors player.currentLocation for other players to read
+        std::atomic<bool> active;
+
+        Member(std::string name, Room* start, std::ostream& output);
+    };
+
+    Member* member(size_t playerId) const;
+    void dropOut(Member& leaving);
+    std::mutex& roomMutex(const Room* room);
+    void indexRooms();
+
+    // Runs 'action' for 'actor' with the world to itself, capturing what the Game prints into 'os'.
+    // Returns true if the story moved on (a state change or a cutscene)
+    template <typename Action>
+    bool runExclusive(Member& actor, std::ostream& os, Action&& action);
+
+    // Names of the other players in the same room, e.g. "Also here: Ann, Bo"
+    void listOthersHere(const Member& viewer, std::ostream& os) const;
+    void deliver(Member& target, const std::string& text);
+    void broadcast(const Member& from, const std::string& text);
+
+    std::ostream discard;
+    Game world;
+
+    std::unordered_map<const Room*, size_t> roomIndex;
+    std::unique_ptr<std::mutex[]> roomLocks;
+    mutable std::shared_mutex worldLock;
+
+    mutable std::shared_mutex membersLock;  // Guards the vector; members are never removed, only deactivated
+    std::vector<std::unique_ptr<Member>> members;
+};
+
+#endif // COOP_GAME_H
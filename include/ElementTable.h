@@ -0,0 +1,97 @@
+#ifndef ELEMENT_TABLE_H
+#define ELEMENT_TABLE_H
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cstdint>
+#include "InteractiveElement.h"
+
+class ElementTable;
+
+// Refers to one element of an ElementTable; null when nothing was found.
+// Stays valid while the table does not gain or lose elements
+class ElementRef {
+public:
+    ElementRef() : table(nullptr), index(0) {}
+    ElementRef(ElementTable* table, uint32_t index) : table(table), index(index) {}
+
+    explicit operator bool() const { return table != nullptr; }
+
+    const std::string& name() const;
+    uint32_t state() const;
+
+    // Index of the element in its room's table
+    uint32_t position() const { return index; }
+
+    // Displays the current description of the element
+    void examine(std::ostream& os = std::cout) const;
+
+    // Advances the element to its next description, or to 'newState' if given and in range
+    void advanceState(int newState = -1);
+
+private:
+    ElementTable* table;
+    uint32_t index;
+};
+
+// The interactive elements of one room, stored as parallel arrays (one entry per element) instead
+// of one object per element. The state of every element is one contiguous array, so saving,
+// hashing or resetting a room's elements is a plain scan. All descriptions live in one table;
+// element i owns descriptionText[descriptionStart[i] .. descriptionStart[i + 1])
+class ElementTable {
+public:
+    size_t size() const { return names.size(); }
+    bool empty() const { return names.empty(); }
+
+    // Appends an element in its first state and returns its index
+    uint32_t add(const InteractiveElement& element);
+
+    const std::string& name(uint32_t i) const { return names[i]; }
+    const std::vector<std::string>& nouns(uint32_t i) const { return nounLists[i]; }
+
+    uint32_t state(uint32_t i) const { return stateIndex[i]; }
+    // Every element's state, in element order
+    const std::vector<uint32_t>& states() const { return stateIndex; }
+
+    // Sets element i to 'state'. Returns false (and changes nothing) if the element has
+    // descriptions and 'state' is past the last one
+    bool setState(uint32_t i, uint32_t state);
+
+    // Puts every element back in its first state
+    void resetStates();
+
+    // Number of descriptions (states) element i has
+    uint32_t stageCount(uint32_t i) const { return descriptionStart[i + 1] - descriptionStart[i]; }
+
+    // Description 'stage' of element i; the caller checks stage < stageCount(i)
+    const std::string& description(uint32_t i, uint32_t stage) const { return descriptionText[descriptionStart[i] + stage]; }
+
+    // A copy of element i's descriptions
+    std::vector<std::string> descriptions(uint32_t i) const;
+
+    // Replaces element i's descriptions, clamping its state to the new last one. 'stages' must not be empty.
+    // Counts a change in element i's text revision
+    void setDescriptions(uint32_t i, const std::vector<std::string>& stages);
+
+    // Every element's text revision, in element order
+    const std::vector<uint32_t>& textRevisions() const { return textRevision; }
+
+    // Index of the element called 'name', or -1
+    int find(const std::string& name) const;
+
+    void examine(uint32_t i, std::ostream& os) const;
+    void advanceState(uint32_t i, int newState);
+
+    ElementRef ref(uint32_t i) { return ElementRef(this, i); }
+
+private:
+    std::vector<std::string> names;
+    std::vector<std::vector<std::string>> nounLists;
+    std::vector<uint32_t> stateIndex;
+    std::vector<uint32_t> descriptionStart{0}; // size() + 1 offsets into descriptionText
+    std::vector<std::string> descriptionText;
+    std::vector<uint32_t> textRevision;
+};
+
+#endif // ELEMENT_TABLE_H
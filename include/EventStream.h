@@ -0,0 +1,101 @@
+#ifndef EVENT_STREAM_H
+#define EVENT_STREAM_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <cstdint>
+
+#include "StateSync.h"
+
+class Game;
+class Room;
+class Item;
+enum class GameState; // Forward declaration
+
+// Typed game events as JSON lines, for bots and other machine clients ('--json').
+//
+// Every line is one object with a "type" field:
+//   room_view         {"id", "name", "description", "items": [{"id", "name"}], "elements": [..], "exits": [..]}
+//   item_picked       {"id", "name"}
+//   dialogue          {"speaker", "text"}
+//   state_transition  {"from", "to"}                 state names as in GameState, e.g. "AWAITING_TASK_1"
+//   cutscene_line     {"text"}
+//   ending            {"ending", "number"}           number is 1, 2 or 3
+//   text              {"text"}                       any other response (errors, inventory, help, ...)
+//   prompt            {"room", "state"}              the game is waiting for the next command
+//
+// Clients that keep their own copy of the world can opt in to deltas (enableDeltas, '--json --deltas').
+// Before each prompt they then get what changed since the version they last acknowledged with
+// 'ack <version>' (see StateSync for the rules), and room_view carries only the room id:
+//   delta             {"version", "acked", "state"?, "location"?, "inventory"?: [{"id", "name"}],
+//                      "rooms": [{"id", "full", "name"?, "description"?, "exits"?: [..],
+//                                 "items"?: [{"id", "name"}], "elements": [{"name", "state", "description"}]}]}
+//
+// Events are serialized into one buffer that is reused for every event, so once it has grown to the
+// largest event nothing is allocated. Lines are flushed to the sink at each prompt, not per event.
+class EventWriter {
+public:
+    // Constructor. Events are written to 'sink'
+    explicit EventWriter(std::ostream& sink);
+
+    EventWriter(const EventWriter&) = delete;
+    EventWriter& operator=(const EventWriter&) = delete;
+
+    // Stream for prose that has no typed event. Whatever is written here is sent as a "text" event
+    // before the next event (or at the next flush)
+    std::ostream& narration() { return narrationStream; }
+
+    void roomView(const Room& room);
+    void itemPicked(const Item& item);
+    void dialogue(std::string_view speaker, std::string_view text);
+    void stateTransition(GameState from, GameState to);
+    void cutsceneLine(std::string_view text);
+    void ending(GameState ending);
+
+    // Sends the state delta (when enabled and something changed), then the prompt itself
+    void prompt(const Game& game);
+
+    // Switches this client to state deltas and compact room views
+    void enableDeltas();
+    bool deltasEnabled() const { return sync != nullptr; }
+
+    // Handles 'ack <version>'. Returns false if deltas are off or 'version' is not the latest
+    bool acknowledge(uint64_t version);
+
+    // Sends pending narration and pushes everything written so far to the sink
+    void flush();
+
+private:
+    // Collects narration into a string that keeps its capacity between events
+    class NarrationBuffer : public std::streambuf {
+    public:
+        std::string text;
+    protected:
+        int_type overflow(int_type ch) override;
+        std::streamsize xsputn(const char* s, std::streamsize count) override;
+    };
+
+    void begin(const char* type);
+    void key(const char* name);
+    void field(const char* name, std::string_view value);
+    void field(const char* name, const char* value);
+    void number(const char* name, uint64_t value);
+    void itemList(const char* name, const std::vector<std::unique_ptr<Item>>& items);
+    void exitList(const Room& room);
+    void delta(const Game& game);
+    void appendEscaped(const char* text, size_t length);
+    void end();
+    void emitNarration();
+
+    std::ostream& sink;
+    std::string line;
+    NarrationBuffer narrationBuffer;
+    std::ostream narrationStream;
+    std::unique_ptr<StateSync> sync;
+};
+
+#endif // EVENT_STREAM_H
@@ -0,0 +1,131 @@
+#ifndef FUZZY_INDEX_H
+#define FUZZY_INDEX_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+// Best candidate found by a fuzzy search. Words that name the same thing (e.g. "gas_can" and "gas can")
+// never make a match ambiguous; two different things at the same distance do.
+struct FuzzyMatch {
+    const std::string* word = nullptr;
+    const void* target = nullptr; // What the word refers to, used to tell real ties from synonyms
+    unsigned distance = ~0u;
+    bool ambiguous = false;
+
+    void offer(const std::string& candidate, unsigned candidateDistance, const void* candidateTarget) {
+        if (candidateDistance < distance) {
+            word = &candidate;
+            target = candidateTarget;
+            distance = candidateDistance;
+            ambiguous = false;
+        } else if (candidateDistance == distance && candidateTarget != target) {
+            ambiguous = true;
+        }
+    }
+
+    // A single clear winner
+    bool found() const { return word && !ambiguous; }
+};
+
+// Typo-tolerant lookup over a vocabulary: a character trie searched with a bounded edit-distance
+// automaton. The search carries one row of the edit-distance table per trie level and abandons a
+// branch as soon as every entry of its row exceeds the budget, so words sharing a prefix with the
+// query are compared once per shared character instead of once per word.
+//
+// Distance is optimal string alignment: insertions, deletions, substitutions and swaps of two
+// adjacent characters ("stroage" -> "storage") each count as one edit.
+//
+// Words are referenced, not copied: they must stay alive and unchanged while the index exists, which
+// holds for the keys of std::map and std::unordered_map entries that are never erased.
+class FuzzyIndex {
+public:
+    // Constructor
+    FuzzyIndex();
+
+    // Adds a word. Adding a word that is already present does nothing
+    void insert(const std::string& word);
+
+    // Calls fn(word, distance) for every word within 'maxDistance' edits of 'query'.
+    // 'fn' must not search another index: the scratch rows are shared per thread
+    template <typename Fn>
+    void search(const std::string& query, unsigned maxDistance, Fn&& fn) const;
+
+    size_t size() const { return wordCount; }
+
+    // How many typos a word of this length may contain and still be corrected
+    static unsigned typoBudget(size_t length) {
+        return length <= 2 ? 0 : (length <= 6 ? 1 : 2);
+    }
+
+private:
+    // Left-child/right-sibling trie; node 0 is the root
+    struct Node {
+        uint32_t firstChild;
+        uint32_t nextSibling;
+        const std::string* word; // Set on the node where a word ends
+        char ch;
+    };
+    std::vector<Node> nodes;
+    size_t wordCount;
+    size_t maxDepth;
+};
+
+template <typename Fn>
+void FuzzyIndex::search(const std::string& query, unsigned maxDistance, Fn&& fn) const {
+    if (query.empty()) return;
+    const size_t width = query.size() + 1;
+
+    // Row d holds the distances between the first d characters of the path and every prefix of the query
+    thread_local std::vector<unsigned> rows;
+    thread_local std::vector<char> path;
+    thread_local std::vector<std::pair<uint32_t, uint32_t>> pending; // (node, depth)
+    rows.resize((maxDepth + 1) * width);
+    path.resize(maxDepth + 1);
+    pending.clear();
+
+    for (size_t j = 0; j < width; ++j) rows[j] = static_cast<unsigned>(j);
+    for (uint32_t child = nodes[0].firstChild; child != 0; child = nodes[child].nextSibling) {
+        pending.emplace_back(child, 1);
+    }
+
+    while (!pending.empty()) {
+        uint32_t index = pending.back().first;
+        uint32_t depth = pending.back().second;
+        pending.pop_back();
+        const Node& node = nodes[index];
+        path[depth] = node.ch;
+
+        // Only cells within 'maxDistance' of the diagonal can stay within budget (Ukkonen's band);
+        // the cells just outside it are set to 'tooFar' so the next row can read them
+        const unsigned tooFar = maxDistance + 1;
+        size_t low = depth > maxDistance ? depth - maxDistance : 1;
+        size_t high = std::min(width - 1, static_cast<size_t>(depth) + maxDistance);
+        if (low > high) continue; // The path is already longer than the query plus the budget
+
+        const unsigned* previous = &rows[(depth - 1) * width];
+        unsigned* row = &rows[depth * width];
+        row[0] = std::min(depth, tooFar);
+        if (low > 1) row[low - 1] = tooFar;
+        unsigned rowMin = row[0];
+        for (size_t j = low; j <= high; ++j) {
+            unsigned cost = query[j - 1] == node.ch ? 0 : 1;
+            unsigned best = std::min(std::min(previous[j] + 1, row[j - 1] + 1), previous[j - 1] + cost);
+            if (depth > 1 && j > 1 && query[j - 1] == path[depth - 1] && query[j - 2] == node.ch) {
+                best = std::min(best, rows[(depth - 2) * width + j - 2] + 1); // Adjacent swap
+            }
+            row[j] = std::min(best, tooFar);
+            rowMin = std::min(rowMin, row[j]);
+        }
+        if (high + 1 < width) row[high + 1] = tooFar;
+
+        if (node.word && high == width - 1 && row[width - 1] <= maxDistance) fn(*node.word, row[width - 1]);
+        if (rowMin > maxDistance) continue; // No extension of this path can come back within budget
+        for (uint32_t child = node.firstChild; child != 0; child = nodes[child].nextSibling) {
+            pending.emplace_back(child, depth + 1);
+        }
+    }
+}
+
+#endif // FUZZY_INDEX_H
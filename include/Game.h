@@ -9,12 +9,24 @@
 #include <algorithm>
 #include <thread>
 #include <chrono>
+#include <string_view>
 
 #include "Room.h"
 #include "Player.h"
 #include "Item.h"
 #include "Guide.h"
 #include "InteractiveElement.h"
+#include "NavigationTable.h"
+#include "Command.h"
+#include "UndoLog.h"
+#include "WorldDefinition.h"
+#include "MessageCatalog.h"
+
+class HintEngine;
+class TranscriptWriter;
+class EventWriter;
+class ContentStore;
+struct ContentSnapshot;
 
 // GameState enum to manage distinct game phases and narrative progression
 // This acts as a state machine, ensuring events happen in the correct sequence
@@ -54,6 +66,9 @@ enum class GameState {
     GAME_OVER                       // Terminal state
 };
 
+// Name of a state as spelled in the enum, e.g. "AWAITING_TASK_1"
+const char* gameStateName(GameState state);
+
 // Manages the overall game state, objects, and game loop
 class Game {
 public: 
@@ -69,24 +84,220 @@ public:
     GameState currentGameState;
     bool gameOver;
 
+    // The ending the player reached; stays INTRO until one of the three endings is displayed
+    GameState endingReached;
+
+    // Delay between narrated characters at the console
+    static constexpr int kTypewriterDelayMs = 35;
+
     // Constructor
-    Game();
+    // All narration goes to 'output'. A typewriter delay of 0 prints each line at once,
+    // which is what headless drivers (bots, the vectorized environment) want.
+    Game(std::ostream& output = std::cout, int typewriterDelayMs = kTypewriterDelayMs);
+
+    // Deep copy: rooms, items and the player are duplicated and every pointer (exits, the
+    // player's location) is re-aimed at the copies. The hint cache is shared with the original.
+    Game(const Game& other);
+    Game& operator=(const Game& other);
+    Game(Game&&) = default;
+    Game& operator=(Game&&) = default;
 
     // Main game loop
     void run();
 
+    // Processes player input. A line of several commands separated by ';' runs as one batch: the
+    // commands run in order until one fails or starts a cutscene, all of their output is written in
+    // one piece (without the typewriter effect), and a single 'undo' takes the whole batch back
+    void processInput(const std::string& rawInput);
+
+    // Dispatches an already-tokenized (lowercase) command to its handler
+    void executeCommand(const std::vector<std::string>& words);
+
+    // @brief Returns the message shown when an exit is still locked by the story, or an empty view if it is open
+    std::string_view exitLockMessage(const std::string& exitKey) const;
+
+    // @brief Bit mask of the story-locked exits that are currently closed (see NavigationTable)
+    uint32_t lockedExitMask() const;
+
+    // @brief Sends all further output to 'output' with the given typewriter delay
+    void redirectOutput(std::ostream& output, int typewriterDelayMs);
+
+    // @brief Encodes everything that can change during play into a compact byte string.
+    // Two games with equal keys behave identically from here on (up to dialogue randomness).
+    std::string stateKey() const;
+    void stateKey(std::string& key) const;
+
+    // @brief Appends everything that can change during play to 'out' in a compact binary form (about
+    // 40 bytes for the story world, plus a few bytes per change in the undo history). Output, recorder,
+    // events and content attachments are not included.
+    void saveState(std::vector<uint8_t>& out) const;
+
+    // @brief Resets the game and applies a state written by saveState on a game of the same world.
+    // Returns false, leaving the game reset, if the data is malformed or belongs to another world.
+    bool restoreState(const uint8_t* data, size_t size);
+
+    // @brief The command the hint engine recommends next, or an empty string if nothing helps.
+    // Valid until the next call
+    const std::string& suggestNextAction();
+
+    // @brief Records every command this session processes to 'writer' under 'sessionId' (nullptr stops recording).
+    // Copies of a game never inherit its recorder.
+    void attachRecorder(TranscriptWriter* writer, uint64_t sessionId);
+
+    // @brief Reports the session as typed events to 'writer' instead of prose (nullptr stops).
+    // All remaining prose goes to the writer's narration stream, without the typewriter effect;
+    // call redirectOutput after detaching. Copies of a game never inherit the writer.
+    void attachEvents(EventWriter* writer);
+
+    // @brief Takes room, element, dialogue and help text from 'store' (nullptr stops). Whenever a
+    // newer version has been published, the session copies it in before its next command, so a
+    // command never sees a mix of two versions. Copies of a game share the store.
+    void attachContent(const ContentStore* store);
+
+    // @brief Narrates in the language of 'catalog' (nullptr returns to the built-in text), reloading the
+    // Guide's dialogue and the text of the built-in rooms, items and elements. The catalog must outlive
+    // the game and its copies, which share it. Attach it before attachContent, so published content
+    // starts from the translated text.
+    void attachMessages(const MessageCatalog* catalog);
+
+    // @brief Number of commands 'undo' can currently take back. Only commands that changed something
+    // count, and only those that came through processInput (the history is not copied with the game)
+    size_t undoDepth() const;
+
+    // @brief Restores the initial game state in place, without allocating.
+    // Items are moved back to their starting rooms, elements return to their first description,
+    // and the player, Guide and story state start over. Unlike the constructor, nothing is printed.
+    void reset();
+
+    // @brief Verifies internal consistency: every item exists exactly once (in a room, the inventory
+    // or held back for spawning), item flags match the inventory, and all pointers are valid.
+    // Returns false and describes the first violation in 'problem' if one is found.
+    bool checkInvariants(std::string* problem = nullptr) const;
+
+    // @brief Replaces the whole world with 'rooms' (e.g. from WorldGenerator) and starts the player in
+    // 'startRoomId', or the first room if there is no such room. The inventory is emptied and reset()
+    // restores this world from now on. The story still refers to its own rooms by id, so this is meant
+    // for benchmarks and tools rather than for playing the story.
+    void loadWorld(std::vector<std::unique_ptr<Room>> rooms, const std::string& startRoomId);
+
+    // @brief Finds a room by its unique ID
+    Room* findRoomById(const std::string& roomId);
+
 private:
+    // --- Reset members ---
+    // Where each item starts the game, in the order it was placed
+    struct ItemHome {
+        std::string itemId;
+        Room* room;
+    };
+    std::vector<ItemHome> itemHomes;
+    Room* startLocation;
+
+    // Scratch space for reset(), sized once so resetting never allocates
+    std::vector<std::unique_ptr<Item>> resetScratch;
+
+    // Reused by processInput and typeGuideHeading so a warm session does not allocate for them
+    std::vector<std::string> inputWords;
+    std::string headingScratch;
+    std::string hintScratch;
+
+    // --- Output members ---
+    // Destination for all narration, prompts and command responses
+    std::ostream* out;
+
+    // Milliseconds per character in typeOut (0 disables the effect)
+    int typewriterDelayMs;
+
     // --- State-tracking members ---
     // Flag to track if the surgical item has been spawned into the game world
     bool surgicalItemSpawned;
 
+    // The surgical item, created up front and held here until it is spawned into the office
+    std::unique_ptr<Item> reservedSurgicalItem;
+
     // --- Cutscene and Typing Effect members ---
 
     // Flag to suppress the command prompt during narrative sequences
     bool isInCutscene;
 
+    // Number of cutscenes started so far; lets multi-step actions notice when the story interrupts them
+    size_t cutscenesPlayed;
+
+    // Set when autoCorrect changed the command about to run; executeCommand says so under its separator
+    bool correctionPending;
+
+    // --- Navigation ---
+    // All-pairs next-hop routing over the exits, used by 'travel'
+    NavigationTable navigation;
+
+    // --- Recording ---
+    TranscriptWriter* recorder;
+    uint64_t recorderSessionId;
+
+    // --- Machine clients ---
+    // Receives typed events when set; see attachEvents
+    EventWriter* events;
+
+    // --- Content ---
+    // Published text this session follows, and the version it last copied in
+    const ContentStore* content;
+    uint64_t contentVersion;
+
+    // --- Messages ---
+    // Where narrated lines come from; the built-in catalog unless a locale is attached
+    const MessageCatalog* messages;
+
+    // --- Hints ---
+    // Memoized solver behind 'hint' and 'help'; shared by copies of this game
+    std::shared_ptr<HintEngine> hints;
+
+    // --- Undo ---
+    // What processInput's recent commands changed; see UndoLog. Changes are only recorded while
+    // recordingUndo is set, so solver copies and co-op players never fill it
+    UndoLog undoLog;
+    bool recordingUndo;
+
+    // What the recorded command started from; compared with the outcome when it finishes
+    struct UndoScalars {
+        GameState state;
+        GameState ending;
+        uint16_t flags;
+        int location;
+        size_t cutscenes;
+    };
+    UndoScalars undoBefore;
+
+    // @brief Opens and closes the undo step of one command
+    void beginUndoStep();
+    void endUndoStep();
+
+    // @brief Adds a change to the open undo step, if one is being recorded
+    void recordChange(const UndoRecord& change);
+
+    // @brief Reverts one recorded change
+    void revertChange(const UndoRecord& change);
+
+    // @brief Player and story flags packed into bits, in the order stateKey uses
+    uint16_t undoFlags() const;
+    void restoreUndoFlags(uint16_t flags);
+
+    // @brief Advances an element of 'room' like ElementRef::advanceState, recording its previous stage
+    void advanceElement(Room& room, ElementRef element, int newState = -1);
+
+    // @brief Story triggers (see TriggerTable.h and the world definition)
+    bool triggerPending(TriggerEvent event, const Room& room, std::string_view subject) const;
+    bool fireTriggers(TriggerEvent event, Room& room, std::string_view subject);
+    bool triggerConditionsHold(const WorldTrigger& rule, const Room& room, bool checkCarried) const;
+    void runTrigger(const WorldTrigger& rule, Room& room);
+
+    // @brief The line for 'id' in the attached language
+    std::string_view message(MessageId id) const { return messages->text(id); }
+
     // @brief Prints text to the console with a typewriter effect
-    void typeOut(const std::string& text, bool isDialogue = false);
+    void typeOut(std::string_view text, bool isDialogue = false);
+
+    // @brief Prints the "--- <guide name> ---" line that opens a conversation, after a blank line if 'spaced'
+    void typeGuideHeading(bool spaced = false);
 
     // @brief Enters cutscene mode, hiding the input prompt
     void enterCutscene();
@@ -94,6 +305,9 @@ private:
     // @brief Exits cutscene mode, showing the input prompt again 
     void exitCutscene();
 
+    // @brief Shows the player's current room, as prose or as a room_view event
+    void describeLocation();
+
     // Initializes game objects and orchestrates the setup of the entire game world 
     void setupGame();
     void setupRoomsAndExits();
@@ -103,9 +317,36 @@ private:
 
     // --- Input and State Management ---
 
-    // Processes player input
-    void processInput(const std::string& rawInput);
-    std::vector<std::string> parseCommand(const std::string& rawInput);
+    // @brief Splits 'rawInput' into lowercase words, reusing the strings already in 'words'
+    static void parseCommand(const std::string& rawInput, std::vector<std::string>& words);
+
+    // @brief Runs the ';'-separated commands of 'rawInput' as one batch (see processInput)
+    void processBatch(const std::string& rawInput);
+
+    // @brief Records (if a recorder is attached) and executes one parsed command
+    void runCommand(const std::vector<std::string>& words);
+
+    // @brief Copies in the latest published content if it is newer than what this session has
+    void refreshContent();
+    void applyContent(const ContentSnapshot& snapshot);
+
+    // @brief Rewrites the text of the built-in world's rooms, items and elements from 'messages'
+    void applyWorldText();
+
+    // @brief Corrects small typos in a typed command: the verb, and for go/examine/get the noun (as seen
+    // from where 'actor' stands). Returns true if anything was changed. Ambiguous near misses are left alone
+    bool autoCorrect(std::vector<std::string>& words, const Player& actor);
+
+    // @brief Tells the player which command a corrected one was taken for
+    static void describeCorrection(const std::vector<std::string>& words, std::ostream& os);
+
+    // @brief Joins up to 'count' words after the verb into one noun ("examine the gas can" -> "gas can")
+    static std::string nounFrom(const std::vector<std::string>& words, size_t count = SIZE_MAX);
+
+    // @brief The noun 'actor' means: the longest leading run of the words after the verb that names something
+    // they can examine (or, with 'takeOnly', pick up where they stand), else the first of those words
+    // ("examine figures closely" -> "figures")
+    static std::string resolveNounFor(const Player& actor, const std::vector<std::string>& words, bool takeOnly);
 
     // Updates game state based on input and current conditions
     void updateGame();
@@ -128,14 +369,29 @@ private:
     void handleCleanCommand(const std::vector<std::string>& words);
     void handleOrganizeCommand(const std::vector<std::string>& words);
     void handleTrimCommand(const std::vector<std::string>& words);
+    void handleTravelCommand(const std::vector<std::string>& words);
+    void handleHintCommand(const std::vector<std::string>& words);
+    void handleAckCommand(const std::vector<std::string>& words);
+    void handleUndoCommand(const std::vector<std::string>& words);
 
+    // --- Room-local actions ---
+    // The parts of look/examine/go/get that only touch the acting player and the rooms they stand in
+    // or walk into. They take the player and output explicitly so CoopGame can run them for any of
+    // its players; the story beats they can set off are separate (onPlayerEntered, onItemTaken).
+    void lookAround(const Player& actor, std::ostream& os) const;
+    void examineFor(const Player& actor, const std::vector<std::string>& words, std::ostream& os) const;
+    Room* walk(Player& actor, const std::string& exitKey, std::ostream& os);
+    Item* take(Player& actor, const std::string& noun, std::ostream& os);
 
-    // Utility
-    // @brief Finds a room by its unique ID
-    Room* findRoomById(const std::string& roomId);
-
-
+    // --- Story triggers ---
+    // The *Pending checks only read state, so a caller can decide whether it needs exclusive access
+    bool entryTriggerPending(const Room* room) const;
+    void onPlayerEntered(Room* room);
+    bool itemTriggerPending(const Room* room, const Item& item) const;
+    void onItemTaken(Room* room, const Item& item);
 
+    // Shared-world mode drives one Game for several players (see CoopGame.h)
+    friend class CoopGame;
 };
 
 
@@ -0,0 +1,124 @@
+#ifndef GAME_SERVER_H
+#define GAME_SERVER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include "SessionManager.h"
+
+// Serves one game session per TCP connection, for load tests and local multi-player setups.
+//
+// The protocol is line based: the client sends one command per line, exactly as typed at the
+// prompt. Every response (including the opening room description sent on connect) is the
+// session's prose followed by the end-of-response marker "\x1e\n", so a client always knows when
+// a command has finished. The response that ends the game offers to take the last move back when
+// the session can; the server closes the connection after the next line unless it was an undo, or
+// right away when there is nothing to undo.
+//
+// One thread runs everything with poll(): accepting, reading, running commands and writing.
+// Sessions come from a SessionManager, so idle connections are spilled to disk.
+//
+// Output is never written with blocking calls. What a client has not taken yet waits in its
+// connection's send queue, and that queue is bounded by backpressure: once it holds
+// kHighWatermark bytes the connection is paused. Its socket is not read and its buffered
+// commands are not run until the client has taken the queue down to kLowWatermark. A stalled
+// client therefore costs at most about kHighWatermark + one response + kMaxInputBytes of memory
+// and no server time, and other players are not slowed down. Sessions run without the typewriter
+// delay, so every response is produced in whole lines at once.
+class GameServer {
+public:
+    // Ends every response; 0x1E is the ASCII record separator and never occurs in game text
+    static constexpr const char* kEndOfResponse = "\x1e\n";
+
+    // Longer lines are cut off at this length
+    static constexpr size_t kMaxLineBytes = 4096;
+
+    // Send-queue sizes at which a connection is paused and resumed
+    static constexpr size_t kHighWatermark = 64 * 1024;
+    static constexpr size_t kLowWatermark = 16 * 1024;
+
+    // Received bytes held per connection; a paused connection stops reading once this is full
+    static constexpr size_t kMaxInputBytes = 16 * 1024;
+
+    // Commands one connection may run per poll round, so a client that pipelines many cannot starve the rest
+    static constexpr size_t kCommandsPerRound = 8;
+
+    // Constructor
+    explicit GameServer(SessionManager& sessions);
+    ~GameServer();
+
+    GameServer(const GameServer&) = delete;
+    GameServer& operator=(const GameServer&) = delete;
+
+    // Binds to 127.0.0.1:'port' (0 picks a free port). Returns false and describes why in 'error'
+    bool listen(uint16_t port, std::string* error = nullptr);
+
+    // The port actually bound
+    uint16_t port() const { return boundPort; }
+
+    // Serves connections until stop() is called
+    void run();
+
+    // Makes run() return. Safe to call from another thread or a signal handler
+    void stop();
+
+    // Commands processed so far; may be read from any thread
+    uint64_t commandCount() const { return commands.load(std::memory_order_relaxed); }
+
+    // Times a connection was paused because its client did not keep up; may be read from any thread
+    uint64_t pauseCount() const { return pauses.load(std::memory_order_relaxed); }
+
+private:
+    // Appends a session's prose to the connection's outgoing bytes
+    class ResponseBuffer : public std::streambuf {
+    public:
+        explicit ResponseBuffer(std::string& target) : target(target) {}
+    protected:
+        int_type overflow(int_type ch) override;
+        std::streamsize xsputn(const char* s, std::streamsize count) override;
+    private:
+        std::string& target;
+    };
+
+    struct Connection {
+        int fd;
+        uint64_t session;
+        std::string input;      // Received bytes whose commands have not run yet
+        std::string pending;    // Send queue: responses not yet written to the socket
+        size_t sent;            // Prefix of 'pending' already written
+        bool paused;            // The send queue passed kHighWatermark and has not drained to kLowWatermark
+        bool backlog;           // Complete lines were left for the next round (see kCommandsPerRound)
+        bool closing;           // Close once 'pending' has been written
+        bool endingOffered;     // The game is over and the client was offered an undo
+        ResponseBuffer response;
+        std::ostream out;
+
+        explicit Connection(int fd);
+        size_t queued() const { return pending.size() - sent; }
+        bool wantsInput() const { return !closing && !paused && input.size() < kMaxInputBytes; }
+    };
+
+    void acceptAll();
+    // These return false when the connection should be dropped
+    bool readFrom(Connection& connection);
+    bool writeTo(Connection& connection);
+    // Runs buffered commands until the input holds no complete line, the connection pauses or
+    // its share of the round is used up
+    void runQueued(Connection& connection);
+    void handleLine(Connection& connection, const std::string& line);
+    void drop(size_t index);
+
+    SessionManager& sessions;
+    int listenFd;
+    int wakeFds[2];          // stop() writes to [1]; run() polls [0]
+    uint16_t boundPort;
+    std::atomic<bool> stopping;
+    std::atomic<uint64_t> commands;
+    std::atomic<uint64_t> pauses;
+    std::vector<std::unique_ptr<Connection>> connections;
+};
+
+#endif // GAME_SERVER_H
@@ -5,6 +5,8 @@
 #include <vector>
 #include <map>
 #include <iostream>
+#include <random>
+#include "MessageCatalog.h"
 
 enum class GameState; // Forward declaration
 
@@ -21,20 +23,39 @@ public:
     std::map<std::string, std::string> commandExplanations;
     std::map<GameState, std::vector<std::string>> dialogueLines;
 
+    // What getDialogue returns for a state without lines
+    std::string silence;
+
+    // Hint lines: with nothing left to do, as the player's thought, and spoken. '{hint}' marks the command
+    std::string noHint;
+    std::string hintThought;
+    std::string hintSpoken;
+
+    // Picks between alternative dialogue lines. Kept per Guide so each game can be seeded independently
+    mutable std::minstd_rand rng;
+
     // Constructor
     Guide(std::string name = "The Visitor Guide");
 
-    // Interact with the Guide (returns the dialogue string instead of printing it)
-   std::string getDialogue(GameState currentState) const; 
+    // Interact with the Guide (returns the dialogue string instead of printing it).
+    // The reference stays valid until the dialogue lines are replaced
+    const std::string& getDialogue(GameState currentState) const; 
+
+    // Provide help based on player's query or general help.
+    // A non-empty 'hint' (the next useful command) is added to general help, voiced according to 'currentState'
+    void provideHelp(const std::string& commandTopic = "general", GameState currentState = static_cast<GameState>(0), std::ostream& os = std::cout, const std::string& hint = "");
+
+    // Prints a single hint, voiced by the player's own thoughts before meeting the Guide and by the Guide after
+    void giveHint(const std::string& hint, GameState currentState, std::ostream& os = std::cout) const;
 
-    // Provide help based on player's query or general help
-    void provideHelp(const std::string& commandTopic = "general", GameState currentState = static_cast<GameState>(0));
+    // Reseeds the dialogue picker
+    void seed(unsigned int value);
 
     // Method for the Guide to change their state 
     void setFeigningInjury(bool feigning);
 
-    // Load dialogue and help messages
-    void initializeDialogue();
+    // Load dialogue and help messages, replacing any loaded before
+    void initializeDialogue(const MessageCatalog& messages = MessageCatalog::builtIn());
 
 };
 
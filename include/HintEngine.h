@@ -0,0 +1,43 @@
+#ifndef HINT_ENGINE_H
+#define HINT_ENGINE_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <unordered_map>
+
+class Game;
+
+// Suggests the next command on a shortest path toward story progress.
+//
+// "Progress" means reaching a different GameState than the one the player is in now.
+// The solver runs a breadth-first search over copies of the live Game, trying every
+// command that could matter from each state. States are deduplicated by Game::stateKey().
+// Once a path is found, every state on it is memoized with its next command. Later queries
+// from any of those states are answered with one hash lookup, so hints stay cheap no matter
+// how often they are asked for.
+class HintEngine {
+public:
+    // Upper bound on game states explored by a single search
+    static constexpr size_t kMaxSearchStates = 20000;
+
+    // Stores the recommended next command for the game's current state in 'action',
+    // or an empty string when no command leads anywhere new. A memoized answer costs no allocation
+    // once 'action' has grown to fit it
+    void nextAction(const Game& game, std::string& action);
+
+    // Number of memoized states
+    size_t cachedStates() const;
+
+private:
+    // Runs the search from 'game' and memoizes the result for every state on the found path
+    std::string solve(const Game& game, const std::string& rootKey);
+
+    // Commands worth trying from a state: exits, items, task verbs and story choices
+    static std::vector<std::vector<std::string>> candidateCommands(const Game& game);
+
+    mutable std::mutex memoMutex;
+    std::unordered_map<std::string, std::string> memo;
+};
+
+#endif // HINT_ENGINE_H
@@ -3,24 +3,21 @@
 
 #include <string>
 #include <vector>
-#include <iostream> 
 
-// Represents an element in a room that the player can interact with
-// Its description might change based on game events 
+// Describes an element in a room that the player can interact with: its name, the descriptions it
+// steps through as game events change it, and the words that refer to it.
+// Rooms keep their elements (and the state each one is in) in an ElementTable
 class InteractiveElement {
 public:
     std::string name; 
     std::vector<std::string> descriptions; 
-    size_t currentState;
 
-    // Constructor 
-    InteractiveElement(std::string name, const std::vector<std::string>& descs);
-
-    // Displays the current description of the element
-    void examine() const; 
+    // Words the player can use for this element: its name, the name with underscores and spaces
+    // swapped ("music_box", "music box"), and any aliases
+    std::vector<std::string> nouns;
 
-    // Advances the element to its next description/state
-    void advanceState(int newState = -1);
+    // Constructor 
+    InteractiveElement(std::string name, const std::vector<std::string>& descs, const std::vector<std::string>& aliases = {});
 
 };
 
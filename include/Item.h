@@ -3,28 +3,51 @@
 
 #include <string>
 #include <iostream>
+#include <memory>
+#include <vector>
 
 // Represents an item that can be found, picked up, and used by the player
-class Item {
+class Item final {
 public: 
     std::string id;
     std::string name;
     std::string description;
 
+    // Every word or phrase the player can use for this item: its id, its lowercase name written with
+    // spaces and with underscores ("gas can", "gas_can"), and any aliases. Rooms and the inventory index these
+    std::vector<std::string> nouns;
+
     // Constructor 
-    Item(std::string id, std::string name, std::string description);
+    Item(std::string id, std::string name, std::string description, const std::vector<std::string>& aliases = {});
 
-    // --- The "virtual" keyword means that Item is a base class that could have derived (child) classes (inheritance and polymorphism)
+    // Adds another noun for this item. Call before the item is placed in a room or inventory
+    void addAlias(const std::string& alias);
 
-    // Virtual destructor for potential future inheritance
-    virtual ~Item() = default; 
+    // Items are plain data: what an item does is decided by the Game's command handlers, so nothing
+    // here is virtual and an item carries no vtable pointer
 
     // Displays the item's description
-    virtual void examine() const; 
+    void examine(std::ostream& os = std::cout) const; 
 
     // Placeholder for using an item 
-    virtual void use() const; 
+    void use(std::ostream& os = std::cout) const; 
+
+    // Returns a copy of this item, used when a whole game is copied
+    std::unique_ptr<Item> clone() const;
+
+};
 
+// Index entry for the items known under one noun. 'count' items share the noun; 'item' is one of them
+struct ItemSlot {
+    Item* item = nullptr;
+    uint32_t count = 0;
 };
 
+// Called when 'leaving' is taken out of 'items': drops it from the slot for 'noun' and, if other items
+// share that noun, points the slot at one of them
+void releaseItemSlot(ItemSlot& slot, const std::string& noun, const Item* leaving, const std::vector<std::unique_ptr<Item>>& items);
+
+// Lowercases 'text' and adds it to 'nouns', plus its variant with spaces and underscores swapped, skipping duplicates
+void addNounForms(std::vector<std::string>& nouns, const std::string& text);
+
 #endif // ITEM_H
\ No newline at end of file
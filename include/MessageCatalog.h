@@ -0,0 +1,70 @@
+#ifndef MESSAGE_CATALOG_H
+#define MESSAGE_CATALOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// IDs of the narrated lines, generated from the world definition with the other world tables
+// (MessageId::INTRO_1, ... in WorldTables.h)
+enum class MessageId : uint16_t;
+
+// Narrated text by message ID, in one locale.
+//
+// The built-in catalog is the world definition's own text, compiled into the executable. A locale
+// catalog is a binary file written by 'world_codegen --catalog' (see "Translations" in README.md) that is
+// memory-mapped read-only: opening one only checks its header, and a line is looked up and viewed in
+// place the first time it is displayed, so the pages of lines nobody reads are never loaded. Every
+// session in a process can share one catalog, and languages that are not opened cost nothing.
+//
+// File layout (native byte order): a Header, then uint32_t offsets[count + 1] into the text block,
+// then the text block. Message i is text[offsets[i] .. offsets[i + 1]); an empty message means
+// "not translated" and falls back to the built-in text.
+class MessageCatalog {
+public:
+    static constexpr char kMagic[4] = {'V', 'C', 'M', 'C'};
+    static constexpr uint16_t kFormatVersion = 1;
+
+    struct Header {
+        char magic[4];
+        uint16_t version;
+        uint16_t reserved;
+        char locale[8];     // Locale tag such as "es", NUL-padded
+        uint64_t schema;    // Fingerprint of the message IDs the catalog was built for (kMessageSchema)
+        uint32_t count;     // Number of messages (kMessageCount)
+        uint32_t textBytes; // Size of the text block
+    };
+
+    // The text compiled into the game
+    static const MessageCatalog& builtIn();
+
+    // Maps the catalog at 'path'. Returns nullptr and describes the problem in 'error' if the file
+    // can't be read or was built for another version of the world's messages
+    static std::unique_ptr<MessageCatalog> open(const std::string& path, std::string* error = nullptr);
+
+    ~MessageCatalog();
+    MessageCatalog(const MessageCatalog&) = delete;
+    MessageCatalog& operator=(const MessageCatalog&) = delete;
+
+    // The line for 'id', viewed in place; valid for as long as the catalog
+    std::string_view text(MessageId id) const;
+
+    // Tag of the catalog's locale; empty for the built-in text
+    std::string_view locale() const { return localeTag; }
+
+private:
+    // Constructor
+    MessageCatalog() = default;
+
+    const uint8_t* mapped = nullptr;
+    size_t mappedSize = 0;
+    const uint32_t* offsets = nullptr;
+    const char* textBlock = nullptr;
+    uint32_t count = 0;
+    uint32_t textBytes = 0;
+    std::string_view localeTag;
+};
+
+#endif // MESSAGE_CATALOG_H
@@ -0,0 +1,97 @@
+#ifndef NAVIGATION_TABLE_H
+#define NAVIGATION_TABLE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <list>
+#include <cstdint>
+#include "Room.h"
+
+// Precomputed next-hop routing over the exit graph of a world.
+//
+// For every destination room, one reverse breadth-first search yields the first exit to take
+// from every other room (a column of the next-hop matrix). Columns are stored densely, one
+// uint16_t exit slot per source room, and are computed on first use. They live in a cache bounded
+// by a byte budget (kDefaultColumnBudget unless changed) and the least recently used column is
+// recomputed if it is needed again, so small worlds end up with the full matrix while a large
+// generated world keeps only its most visited destinations.
+//
+// Some exits are locked by the story. Each combination of locked exits ("blocked mask")
+// gets its own columns, so routes never lead through a door that is currently closed.
+class NavigationTable {
+public:
+    // Exit slot meaning "no route"
+    static constexpr uint16_t kNoRoute = 0xFFFF;
+
+    // Bytes of cached columns per table: the whole matrix of a world up to about 2800 rooms, or 8
+    // columns of a 10^6-room world
+    static constexpr size_t kDefaultColumnBudget = 16u << 20;
+
+    // The cache index points into the cache, so a table is moved but never copied (copies build their own)
+    NavigationTable() = default;
+    NavigationTable(const NavigationTable&) = delete;
+    NavigationTable& operator=(const NavigationTable&) = delete;
+    NavigationTable(NavigationTable&&) = default;
+    NavigationTable& operator=(NavigationTable&&) = default;
+
+    // Indexes the rooms and their exits. 'lockableExits' lists the exit keys that can be locked;
+    // bit i of a blocked mask refers to lockableExits[i]. Discards any previously computed routes.
+    void build(const std::vector<std::unique_ptr<Room>>& rooms, const std::vector<std::string>& lockableExits);
+
+    // Returns the index of a room, or -1 if it is not part of the table
+    int roomIndex(const std::string& roomId) const;
+    int roomIndex(const Room* room) const;
+
+    // Returns the exit key to take from 'from' to move one step closer to room 'target',
+    // or nullptr if 'target' cannot be reached (or 'from' already is the target)
+    const std::string* nextExit(const Room* from, int target, uint32_t blockedMask);
+
+    size_t roomCount() const { return rooms.size(); }
+
+    // Caps the memory used by cached columns (at least one column is always kept). Evicts as needed
+    void setColumnBudget(size_t bytes);
+
+    // Number of columns the budget holds for this world
+    size_t columnCapacity() const;
+
+private:
+    struct Exit {
+        std::string key;
+        uint32_t target;  // Destination room index
+        uint32_t lockBit; // Bit in the blocked mask that closes this exit (0 if it never locks)
+    };
+
+    // Routes towards one target under one blocked mask
+    struct Column {
+        uint64_t key; // Blocked mask in the high half, target in the low half
+        std::vector<uint16_t> nextHop;
+    };
+
+    const std::vector<uint16_t>& column(uint32_t target, uint32_t blockedMask);
+    void computeColumn(uint32_t target, uint32_t blockedMask, std::vector<uint16_t>& nextHop);
+
+    std::vector<const Room*> rooms;
+    std::unordered_map<std::string, uint32_t> indexById;
+    std::unordered_map<const Room*, uint32_t> indexByRoom;
+
+    // Outgoing exits in compressed-row form: room r owns exits[exitOffsets[r] .. exitOffsets[r + 1])
+    std::vector<Exit> exits;
+    std::vector<uint32_t> exitOffsets;
+
+    // Incoming edges as (source room, global exit index), in compressed-row form
+    std::vector<std::pair<uint32_t, uint32_t>> incoming;
+    std::vector<uint32_t> incomingOffsets;
+
+    // Cached columns, most recently used first, and where to find each one
+    std::list<Column> columns;
+    std::unordered_map<uint64_t, std::list<Column>::iterator> columnByKey;
+    size_t columnBudget = kDefaultColumnBudget;
+
+    // Reused by every search
+    std::vector<uint32_t> queue;
+    std::vector<bool> visited;
+};
+
+#endif // NAVIGATION_TABLE_H
@@ -4,9 +4,11 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <unordered_map>
 #include <iostream>
 #include "Room.h"
 #include "Item.h"
+#include "FuzzyIndex.h"
 
 // Represents the player in the game
 class Player {
@@ -29,31 +31,60 @@ public:
     bool hasOrganizedArchives; 
     bool hasTrimmedGarden; 
 
+    // Incremented whenever an item enters or leaves the inventory
+    uint64_t inventoryRevision;
+
     // Constructor
     Player(Room* startLocation);
 
+    // Copies flags and clones the inventory. The location pointer is copied as-is;
+    // the owner of the rooms is responsible for pointing it at its own copy
+    Player(const Player& other);
+    Player(Player&&) = default;
+    Player& operator=(Player&&) = default;
+
     // Moves the player to a new location
-    void moveTo(Room* newLocation);
+    void moveTo(Room* newLocation, std::ostream& os = std::cout);
 
     // Adds an item to the player's inventory
-    void pickUpItem(std::unique_ptr<Item> item);
+    void pickUpItem(std::unique_ptr<Item> item, std::ostream& os = std::cout);
+
+    // Removes and returns an item from inventory; 'noun' can be anything in Item::nouns
+    std::unique_ptr<Item> dropItem(const std::string& noun, std::ostream& os = std::cout);
+
+    // Indexes the nouns of an item the player may pick up later, so picking it up does not allocate
+    void expectItem(const Item& item);
 
-    // Removes and returns an item from inventory
-    std::unique_ptr<Item> dropItem(const std::string& itemId);
+    // Moves every carried item into 'out' and empties the inventory, silently and without touching the flags
+    void takeAllItems(std::vector<std::unique_ptr<Item>>& out);
 
     // Checks if the player has a specific item by its ID
     bool hasItem(const std::string& itemId) const;
 
-    // Gets a raw pointer to an item in inventory
-    Item* getItemFromInventory(const std::string& itemId) const;
+    // Gets a raw pointer to an item in inventory, by any of its nouns
+    Item* getItemFromInventory(const std::string& noun) const;
+
+    // Offers 'match' the nouns of carried items within a few typos of 'noun'
+    void fuzzyMatchItem(const std::string& noun, FuzzyMatch& match) const;
 
     // Displays the player's inventory
-    void showInventory() const; 
+    void showInventory(std::ostream& os = std::cout) const; 
 
     // Check if player has all "means to leave" items
     bool hasAllMeansToLeave() const;
     void updateItemFlags(const std::string& itemId, bool acquired);
 
+private:
+    // Nouns of everything carried now or before (entries are kept so picking an item up again doesn't allocate).
+    // Items must enter and leave the inventory through the member functions for this to stay current
+    std::unordered_map<std::string, ItemSlot> inventoryIndex;
+
+    // Typo-tolerant index over the keys of inventoryIndex
+    FuzzyIndex inventoryTree;
+
+    ItemSlot& indexNoun(const std::string& noun);
+    void indexItem(Item* item);
+    void unindexItem(const Item* item);
 };
 
 
@@ -4,14 +4,24 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <memory>
 #include <iostream>
+#include <cstdint>
 #include "Item.h"
-#include "InteractiveElement.h"
+#include "ElementTable.h"
+#include "FuzzyIndex.h"
+
+// What a noun refers to in a room; either pointer may be null
+struct NounMatch {
+    Item* item;
+    ElementRef element;
+};
 
 // Represents a location in the game
 // Rooms are owned by the Game class (via std::unique_ptr)
 // Exits are raw pointers as they don't imply ownership
+// Items and elements must be added and removed through the member functions so the noun index stays current
 class Room {
 public:
     std::string id;
@@ -24,14 +34,27 @@ public:
     // Items currently in this room. The Room owns these items via unique_ptr
     std::vector<std::unique_ptr<Item>> items;
 
-    // Interactive elements in this room
-    std::vector<InteractiveElement> interactive_elements;
+    // Interactive elements in this room and the state each is in
+    ElementTable elements;
+
+    // Incremented whenever an item enters or leaves, so observers can notice changes without comparing contents
+    uint64_t contentRevision;
+
+    // Incremented whenever setText replaces the name or description (element text has its own, see ElementTable)
+    uint64_t textRevision;
 
     // Constructor
     Room(std::string id, std::string name, std::string description);
 
+    // Rooms are referred to by pointer everywhere, and their indexes point into themselves
+    Room(const Room&) = delete;
+    Room& operator=(const Room&) = delete;
+
     // Displays room information (name, description, items, interactive elements, exits)
-    void look() const; 
+    void look(std::ostream& os = std::cout) const; 
+
+    // Replaces the name and description; counts a change in textRevision
+    void setText(const std::string& newName, const std::string& newDescription);
 
     // Add an exit to another room
     void addExit(const std::string& direction, Room* room);
@@ -40,18 +63,54 @@ public:
     void addItem(std::unique_ptr<Item> item);
 
     // Remove an item from the room (e.g., when player picks it up)
-    // Returns the item or nullptr if not found
-    std::unique_ptr<Item> removeItem(const std::string& itemId);
+    // 'noun' can be anything in Item::nouns. Returns the item or nullptr if not found
+    std::unique_ptr<Item> removeItem(const std::string& noun);
+
+    // Puts an item back at 'position' in the item list (at the end if the list is shorter), e.g. on undo
+    void insertItem(std::unique_ptr<Item> item, size_t position);
+
+    // Moves every item into 'out' and empties the room, keeping the index entries for when they come back
+    void takeAllItems(std::vector<std::unique_ptr<Item>>& out);
 
     // Add an interactive element to the room
     void addInteractiveElement(const InteractiveElement& element);
 
-    // Get a pointer to an interactive element in the room 
-    InteractiveElement* getInteractiveElement(const std::string& elementName);
+    // Gives this room a copy of 'other's elements, states included. The room must not have elements yet
+    void copyElementsFrom(const Room& other);
+
+    // Get an interactive element in the room by any of its nouns; null if there is none
+    ElementRef getInteractiveElement(const std::string& noun);
+
+    // Get a pointer to an item in the room (without removing it), by any of its nouns
+    Item* getItem(const std::string& noun);
+
+    // Resolves a noun to the item and/or element it names here, with a single index lookup
+    NounMatch resolveNoun(const std::string& noun);
+
+    // Offers 'match' the nouns of items (and, unless 'itemsOnly', elements) currently here that are
+    // within a few typos of 'noun'
+    void fuzzyMatchNoun(const std::string& noun, bool itemsOnly, FuzzyMatch& match);
+
+    // Offers 'match' the exit keys within a few typos of 'direction'
+    void fuzzyMatchExit(const std::string& direction, FuzzyMatch& match) const;
+
+private:
+    struct NounEntry {
+        ItemSlot item;
+        int element = -1; // Index into elements
+    };
+
+    // Every noun of every item and element that is or was in this room. Entries are kept when an item
+    // leaves, so an item returning (e.g. on Game::reset) does not allocate
+    std::unordered_map<std::string, NounEntry> nounIndex;
 
-    // Get a pointer to an item in the room (without removing it)
-    Item* getItem(const std::string& itemId);
+    // Typo-tolerant indexes over the keys of nounIndex and exits, for correcting typos
+    FuzzyIndex nounTree;
+    FuzzyIndex exitTree;
 
+    void indexElement(uint32_t index);
+    void indexItem(Item* item);
+    void unindexItem(const Item* item);
 };
 
 
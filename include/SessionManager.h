@@ -0,0 +1,120 @@
+#ifndef SESSION_MANAGER_H
+#define SESSION_MANAGER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include "SessionPool.h"
+
+// Keeps many connected sessions while holding only the active ones in memory.
+//
+// A session that has not had input for 'idleAfter' is spilled: its state (Game::saveState, a few
+// dozen bytes plus its undo history) is appended to a spill file and the Game goes back to the pool. The next input for
+// that session takes a game from the pool, restores the state from the file and carries on, so
+// resident memory follows the number of active players rather than connected ones.
+//
+// Spilled records are never rewritten in place. Once superseded records take up more than half of
+// the file (and at least kCompactBytes), the live records are copied to a fresh file.
+//
+// Sessions may be driven from different threads; each session runs one command at a time.
+// Only the output stream and typewriter delay survive a spill (the pool supplies the content store),
+// so sessions managed here should not have a recorder or event writer attached.
+class SessionManager {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Garbage in the spill file that triggers compaction
+    static constexpr uint64_t kCompactBytes = 1 << 20;
+
+    // Constructor. Spills to 'spillPath' (created or truncated). With a non-zero 'sweepInterval' a
+    // background thread calls evictIdle() that often; otherwise the owner calls it
+    SessionManager(SessionPool& pool, std::string spillPath, std::chrono::milliseconds idleAfter,
+                   std::chrono::milliseconds sweepInterval = std::chrono::milliseconds(0));
+    ~SessionManager();
+
+    SessionManager(const SessionManager&) = delete;
+    SessionManager& operator=(const SessionManager&) = delete;
+
+    // False if the spill file could not be opened; sessions then simply stay in memory
+    bool canSpill() const;
+
+    // Starts a session writing to 'output' and returns its id. Like SessionPool::acquire, nothing is printed yet
+    uint64_t open(std::ostream& output, int typewriterDelayMs = 0);
+
+    // Ends a session, spilled or not
+    void close(uint64_t id);
+
+    // Runs one command, bringing the session back into memory first if it was spilled.
+    // Returns false for an unknown id or if the spilled state could not be read back
+    bool processInput(uint64_t id, const std::string& rawInput);
+
+    // True once the session's game has ended (spilled sessions are never over: finished games are not spilled)
+    bool isOver(uint64_t id) const;
+
+    // Commands the session can still take back (0 for unknown or spilled sessions)
+    size_t undoDepth(uint64_t id) const;
+
+    // Spills every resident session idle for at least 'idleAfter' as of 'now'; returns how many
+    size_t evictIdle(Clock::time_point now = Clock::now());
+
+    size_t residentCount() const;
+    size_t spilledCount() const;
+    uint64_t spillFileBytes() const;
+
+private:
+    struct Session {
+        std::mutex mutex;                 // Held while the session runs a command, is spilled or restored
+        std::unique_ptr<Game> game;       // Null while spilled
+        std::ostream* out;
+        int typewriterDelayMs;
+        Clock::time_point lastActive;
+    };
+
+    // Where a spilled session's state lies in the spill file
+    struct Record {
+        uint64_t offset;
+        uint32_t length;
+    };
+
+    std::shared_ptr<Session> find(uint64_t id) const;
+
+    // Writes the session's state to the spill file and returns its game to the pool. Caller holds session.mutex
+    bool spill(uint64_t id, Session& session);
+    // Reads the state back into a game from the pool. Caller holds session.mutex
+    bool rehydrate(uint64_t id, Session& session);
+    // Drops the session's record, if any
+    void forget(uint64_t id);
+
+    // Rewrites the live records into a fresh file. Caller holds fileMutex
+    void compactLocked();
+    void sweepLoop();
+
+    SessionPool& pool;
+    std::string spillPath;
+    std::chrono::milliseconds idleAfter;
+
+    mutable std::mutex sessionsMutex; // Guards the table, not the sessions
+    std::unordered_map<uint64_t, std::shared_ptr<Session>> sessions;
+    uint64_t nextId;
+
+    mutable std::mutex fileMutex;     // Guards the spill file, the records and the counters below
+    std::unordered_map<uint64_t, Record> records;
+    int spillFd;
+    uint64_t fileBytes;
+    uint64_t liveBytes;
+
+    std::mutex stopMutex;
+    std::condition_variable stopSignal;
+    bool stopping;
+    std::chrono::milliseconds sweepInterval;
+    std::thread sweeper;
+};
+
+#endif // SESSION_MANAGER_H
@@ -0,0 +1,60 @@
+#ifndef SESSION_POOL_H
+#define SESSION_POOL_H
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <iostream>
+#include "Game.h"
+
+// Hands out ready-to-play Game sessions without rebuilding the world each time.
+//
+// A prototype Game is set up once. New sessions are either recycled from finished ones
+// (restored with Game::reset(), which does not allocate) or, when none are idle, copied from
+// the prototype. prewarm() fills the idle list ahead of time so a burst of new players
+// is served from memory that already exists.
+//
+// Sessions handed out by acquire() have not printed anything yet; show the opening room
+// with processInput("look") or start them with run(). Every session follows the pool's content
+// store, if it has one, and nothing else a client attached survives release().
+class SessionPool {
+public:
+    // Constructor
+    // 'maxIdle' caps how many released sessions are kept for reuse. Sessions narrate from 'messages'
+    // (the built-in text if nullptr) and take published text from 'content' (see Game::attachContent);
+    // both must outlive the pool
+    explicit SessionPool(size_t prewarmCount = 0, size_t maxIdle = 1024, const MessageCatalog* messages = nullptr,
+                         const ContentStore* content = nullptr);
+
+    // Returns a fresh session that writes to 'output'. Its Guide gets a seed of its own
+    std::unique_ptr<Game> acquire(std::ostream& output, int typewriterDelayMs = 0);
+
+    // Takes back a session (finished or abandoned) and keeps it for reuse
+    void release(std::unique_ptr<Game> game);
+
+    // Makes sure at least 'count' sessions are idle and ready
+    void prewarm(size_t count);
+
+    // Number of sessions waiting to be handed out
+    size_t idleCount() const;
+
+private:
+    // Output of idle sessions goes nowhere
+    std::ostream discard;
+
+    // Followed by every session; may be null
+    const ContentStore* content;
+
+    // Set up once, never played; copies of it share its hint cache
+    const Game prototype;
+
+    // Source of the per-session dialogue seeds; copies of the prototype would otherwise all pick the same lines
+    std::atomic<uint32_t> nextSeed;
+
+    mutable std::mutex idleMutex;
+    std::vector<std::unique_ptr<Game>> idle;
+    size_t maxIdle;
+};
+
+#endif // SESSION_POOL_H
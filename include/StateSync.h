@@ -0,0 +1,91 @@
+#ifndef STATE_SYNC_H
+#define STATE_SYNC_H
+
+#include <vector>
+#include <cstdint>
+
+class Game;
+
+// Tracks what a client has been told about a session, so only changes need to be sent.
+//
+// Each call to update() compares the game with the last version sent. When something changed it
+// starts a new version and works out what to send relative to the last version the client
+// acknowledged. That covers rooms the player has visited: a room the client has not acknowledged
+// yet is sent in full, while a known room sends only its items (if any entered or left), its name and
+// description (if a content reload replaced them) and the elements whose state advanced or whose text
+// was replaced. The inventory, game state and location are sent when they changed.
+//
+// A field is included if it differs from either the acknowledged or the last sent version. Every
+// field is an absolute value, so a client can apply a delta on top of either of those and ends up
+// with the current state, even if it missed the deltas in between.
+//
+// Change detection uses Room::contentRevision, Room::textRevision and Player::inventoryRevision plus
+// the element states and text revisions, so an update costs a few integer comparisons per room and allocates nothing once the
+// snapshots are sized.
+class StateSync {
+public:
+    // What the latest version sends
+    struct RoomChange {
+        uint32_t room; // Index into Game::allRooms
+        bool full;     // The client does not know this room yet: send everything about it
+        bool items;    // The room's item list changed
+        bool text;     // The room's name or description was replaced
+    };
+
+    // Constructor
+    StateSync();
+
+    // Starts a new version if the game changed since the last one. Returns true if there is
+    // something to send; the details are then available through the accessors below
+    bool update(const Game& game);
+
+    // Records that the client has applied 'version'. Only the latest version can be acknowledged;
+    // returns false for any other
+    bool acknowledge(uint64_t version);
+
+    uint64_t version() const { return sentVersion; }
+    uint64_t acknowledgedVersion() const { return ackedVersion; }
+
+    bool stateChanged() const { return changedState; }
+    bool locationChanged() const { return changedLocation; }
+    bool inventoryChanged() const { return changedInventory; }
+    const std::vector<RoomChange>& roomChanges() const { return changes; }
+
+    // True if element 'element' of room 'room' must be sent (always true for full rooms)
+    bool elementChanged(uint32_t room, uint32_t element) const;
+
+private:
+    struct Snapshot {
+        int state = -1;
+        int location = -1;
+        uint64_t inventoryRevision = ~0ull;
+        std::vector<uint8_t> known;             // Per room: the client has been sent this room
+        std::vector<uint64_t> revisions;        // Per room: Room::contentRevision
+        std::vector<uint64_t> textRevisions;    // Per room: Room::textRevision
+        std::vector<uint32_t> elementStates;    // Per element, rooms laid out one after another
+        std::vector<uint32_t> elementTexts;     // Per element: its text revision, laid out like elementStates
+    };
+
+    // Sizes the snapshots for the game's rooms; a different world starts the client over
+    void prepare(const Game& game);
+    void capture(const Game& game);
+    bool sameAsSent() const;
+    void collectChanges();
+
+    // Offset of each room's elements within Snapshot::elementStates (one extra entry at the end)
+    std::vector<uint32_t> elementOffsets;
+
+    Snapshot current;
+    Snapshot sent;
+    Snapshot acked;
+    uint64_t sentVersion;
+    uint64_t ackedVersion;
+
+    bool changedState;
+    bool changedLocation;
+    bool changedInventory;
+    std::vector<RoomChange> changes;
+    std::vector<uint8_t> elementsToSend; // Per element, laid out like Snapshot::elementStates
+};
+
+#endif // STATE_SYNC_H
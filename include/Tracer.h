@@ -0,0 +1,90 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// A single completed span. Names must be string literals (they are stored by pointer)
+struct TraceEvent {
+    const char* name;
+    uint64_t startNs;
+    uint64_t durationNs;
+};
+
+// Records timing spans into per-thread ring buffers and dumps them as Chrome
+// trace-event JSON, which can be opened in Perfetto (ui.perfetto.dev) or chrome://tracing.
+//
+// Each thread writes only to its own buffer, so recording never takes a lock.
+// When the buffer wraps, the oldest spans are overwritten.
+// Build with 'make TRACE=1' to compile the TRACE_SCOPE probes in; otherwise they vanish entirely.
+class Tracer {
+public:
+    // Number of spans kept per thread before the oldest are overwritten
+    static constexpr size_t kBufferCapacity = 1 << 16;
+
+    // The process-wide tracer
+    static Tracer& instance();
+
+    // Turns recording on or off at runtime
+    void enable();
+    void disable();
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    // Appends a span to the calling thread's ring buffer
+    void record(const char* name, uint64_t startNs, uint64_t endNs);
+
+    // Writes every buffered span to 'path' as trace-event JSON. Returns false on I/O failure
+    bool dump(const std::string& path) const;
+
+    // Monotonic clock in nanoseconds
+    static uint64_t nowNs() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+private:
+    struct ThreadBuffer;
+
+    Tracer() = default;
+
+    // Returns (registering on first use) the buffer owned by the calling thread
+    ThreadBuffer& localBuffer();
+
+    std::atomic<bool> enabled{false};
+
+    // Intrusive, push-only list of every thread's buffer. Registration uses a CAS, so it is lock-free too
+    std::atomic<ThreadBuffer*> buffers{nullptr};
+    std::atomic<uint32_t> nextThreadId{1};
+};
+
+// RAII helper: measures the lifetime of the enclosing scope
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name)
+        : name(name), startNs(Tracer::instance().isEnabled() ? Tracer::nowNs() : 0) {}
+
+    ~TraceSpan() {
+        if (startNs != 0) {
+            Tracer::instance().record(name, startNs, Tracer::nowNs());
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* name;
+    uint64_t startNs;
+};
+
+#ifdef VC_TRACE
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceSpan TRACE_CONCAT(traceSpan_, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#endif
+
+#endif // TRACER_H
@@ -0,0 +1,188 @@
+#ifndef TRANSCRIPT_H
+#define TRANSCRIPT_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <fstream>
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+
+#include "Command.h"
+
+enum class GameState; // Forward declaration
+
+// Compact binary archive of every command issued in every session.
+//
+// File layout (all integers little-endian):
+//   File header   "VCTR", version byte, 3 reserved bytes
+//   Block*        appended one after another; a file can be reopened and extended
+//
+// Block layout:
+//   BlockHeader   fixed 32 bytes: "VCBK", then record count, symbol bytes, record bytes, index bytes
+//                 and a reserved word as uint32, then the base timestamp as uint64
+//   Symbols       symbolCount x (varint length, bytes): the nouns used in this block
+//   Records       recordCount x (zigzag varint session delta, varint timestamp delta in ms,
+//                 state byte, varint verb, varint noun) where noun 0 means "none" and
+//                 n > 0 refers to symbol n - 1
+//   Index         varint sessionCount, then per session (varint session id,
+//                 varint offset of its first record within Records, varint record count)
+//
+// Every block carries its own symbol table and base timestamp, so blocks can be decoded
+// independently and in parallel, and a torn block at the end of a file is simply ignored.
+// The recorded state is the GameState *before* the command ran. When a command ends the game,
+// it is followed by a Verb::Ended record whose state is the ending reached. When an undo takes the
+// ending back, it is followed by a Verb::EndingUndone record whose state is the one play resumes in.
+// (Archives written before EndingUndone existed mark that with an Ended record in state INTRO.)
+
+// Decoded block header. It is read and written field by field, so its layout in memory doesn't matter
+struct TranscriptBlockHeader {
+    static constexpr size_t kEncodedSize = 32;
+
+    char magic[4];            // "VCBK"
+    uint32_t recordCount;
+    uint32_t symbolBytes;
+    uint32_t recordBytes;
+    uint32_t indexBytes;
+    uint32_t reserved;
+    uint64_t baseTimestampMs; // Timestamp the first record's delta is relative to
+};
+
+// One decoded command
+struct TranscriptRecord {
+    uint64_t sessionId;
+    uint64_t timestampMs;
+    GameState state;
+    Verb verb;
+    const char* noun;   // Points into the block's symbol table; nullptr when the command had no noun
+    uint32_t nounLength;
+};
+
+// Appends records to a transcript file, buffering one block in memory at a time.
+// Safe to share between sessions on different threads.
+class TranscriptWriter {
+public:
+    static constexpr uint32_t kMaxBlockRecords = 16384;
+    static constexpr size_t kMaxBlockBytes = 256 * 1024;
+
+    // Opens (creating if needed) the archive at 'path' for appending
+    explicit TranscriptWriter(const std::string& path);
+    ~TranscriptWriter();
+
+    TranscriptWriter(const TranscriptWriter&) = delete;
+    TranscriptWriter& operator=(const TranscriptWriter&) = delete;
+
+    bool isOpen() const { return file.is_open(); }
+
+    // Records one tokenized command. 'words[0]' is the typed verb, the rest forms the noun
+    void record(uint64_t sessionId, uint64_t timestampMs, GameState state, const std::vector<std::string>& words);
+
+    // Records that a session reached 'ending'
+    void recordEnding(uint64_t sessionId, uint64_t timestampMs, GameState ending);
+
+    // Records that undo took a session's ending back, resuming play in 'state'
+    void recordEndingUndone(uint64_t sessionId, uint64_t timestampMs, GameState state);
+
+    // Writes the buffered block to disk
+    void flush();
+
+private:
+    void appendLocked(uint64_t sessionId, uint64_t timestampMs, GameState state, Verb verb, uint32_t noun);
+    void flushLocked();
+
+    std::mutex mutex;
+    std::ofstream file;
+
+    // Block being built
+    std::vector<uint8_t> records;
+    std::vector<std::string> symbols;
+    size_t symbolBytes;
+    std::unordered_map<std::string, uint32_t> symbolIds;
+    std::unordered_map<uint64_t, std::pair<uint32_t, uint32_t>> sessionIndex; // id -> (first offset, count)
+    std::vector<uint64_t> sessionOrder;
+    uint32_t recordCount;
+    uint64_t baseTimestampMs;
+    uint64_t lastTimestampMs;
+    uint64_t lastSessionId;
+    std::string nounScratch;
+};
+
+// Walks the blocks of a transcript held in memory (for example a memory-mapped file)
+class TranscriptReader {
+public:
+    // A complete block inside the buffer
+    struct Block {
+        TranscriptBlockHeader header; // Decoded from the file
+        const uint8_t* symbols;
+        const uint8_t* records;
+        const uint8_t* index;
+        uint64_t fileOffset;
+    };
+
+    // Constructor. Does not copy the data; the buffer must outlive the reader
+    TranscriptReader(const uint8_t* data, size_t size);
+
+    // False if the buffer does not start with a transcript file header
+    bool isValid() const { return valid; }
+
+    // Advances to the next complete block. Returns false at the end (or at a truncated block)
+    bool nextBlock(Block& block);
+
+    // Calls fn(const TranscriptRecord&) for every record in a block, in order
+    template <typename Fn>
+    static bool decodeBlock(const Block& block, Fn&& fn);
+
+    // Varint helpers shared with the writer and tools. They return false on malformed input
+    static bool readVarint(const uint8_t*& p, const uint8_t* end, uint64_t& value);
+    static void writeVarint(std::vector<uint8_t>& out, uint64_t value);
+
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t offset;
+    bool valid;
+};
+
+template <typename Fn>
+bool TranscriptReader::decodeBlock(const Block& block, Fn&& fn) {
+    // Resolve the block's symbol table
+    std::vector<std::pair<const char*, uint32_t>> symbols;
+    const uint8_t* p = block.symbols;
+    const uint8_t* end = block.symbols + block.header.symbolBytes;
+    while (p < end) {
+        uint64_t length = 0;
+        if (!readVarint(p, end, length) || length > static_cast<uint64_t>(end - p)) return false;
+        symbols.emplace_back(reinterpret_cast<const char*>(p), static_cast<uint32_t>(length));
+        p += length;
+    }
+
+    p = block.records;
+    end = block.records + block.header.recordBytes;
+    TranscriptRecord record{};
+    record.timestampMs = block.header.baseTimestampMs;
+    int64_t sessionId = 0;
+    for (uint32_t i = 0; i < block.header.recordCount; ++i) {
+        uint64_t sessionDelta = 0, timeDelta = 0, verb = 0, noun = 0;
+        if (!readVarint(p, end, sessionDelta) || !readVarint(p, end, timeDelta) || p >= end) return false;
+        uint8_t state = *p++;
+        if (!readVarint(p, end, verb) || !readVarint(p, end, noun)) return false;
+
+        sessionId += static_cast<int64_t>(sessionDelta >> 1) ^ -static_cast<int64_t>(sessionDelta & 1);
+        record.sessionId = static_cast<uint64_t>(sessionId);
+        record.timestampMs += timeDelta;
+        record.state = static_cast<GameState>(state);
+        record.verb = verb < static_cast<uint64_t>(Verb::Count) ? static_cast<Verb>(verb) : Verb::Unknown;
+        if (noun == 0 || noun > symbols.size()) {
+            record.noun = nullptr;
+            record.nounLength = 0;
+        } else {
+            record.noun = symbols[noun - 1].first;
+            record.nounLength = symbols[noun - 1].second;
+        }
+        fn(static_cast<const TranscriptRecord&>(record));
+    }
+    return true;
+}
+
+#endif // TRANSCRIPT_H
@@ -0,0 +1,81 @@
+#ifndef TRIGGER_TABLE_H
+#define TRIGGER_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "WorldDefinition.h"
+
+// Index over the story triggers of a world (see WorldTrigger).
+//
+// Each rule is filed under one bucket keyed by its event, room, subject and game state, where any
+// of the last three can be a wildcard. An event looks up the (at most 8) buckets its own room,
+// subject and state could have been filed under, so finding the rules that may fire costs the
+// same however many rules the world has. Lookups never allocate.
+class TriggerTable {
+public:
+    // Constructor
+    // Indexes 'count' rules; the rows must outlive the table
+    TriggerTable(const WorldTrigger* rules, size_t count);
+
+    // Calls visit(rule) for every rule whose event, room, subject and state match, in the order
+    // the rules were defined, until visit returns false. Conditions ('if' lines) are not checked
+    template <typename Visit>
+    void forEachCandidate(TriggerEvent event, std::string_view room, std::string_view subject, GameState state,
+                          Visit visit) const;
+
+    // True if some 'use' rule is about 'subject' without requiring the player to carry it, i.e. it
+    // is something in a room (like the candle) rather than an item
+    bool usedInPlace(std::string_view subject) const { return inPlace.count(subject) > 0; }
+
+    size_t size() const { return count; }
+
+private:
+    static constexpr size_t kProbes = 8;
+
+    static uint64_t key(TriggerEvent event, std::string_view room, std::string_view subject, bool anyState,
+                        GameState state);
+    static bool matches(const WorldTrigger& rule, TriggerEvent event, std::string_view room,
+                        std::string_view subject, GameState state);
+
+    const WorldTrigger* rules;
+    size_t count;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> buckets; // Rule indexes, ascending
+    std::unordered_set<std::string_view> inPlace;
+};
+
+template <typename Visit>
+void TriggerTable::forEachCandidate(TriggerEvent event, std::string_view room, std::string_view subject,
+                                    GameState state, Visit visit) const {
+    // The buckets this event can hit, without duplicates (hash collisions share a bucket)
+    const std::vector<uint32_t>* found[kProbes];
+    size_t foundCount = 0;
+    for (size_t probe = 0; probe < kProbes; ++probe) {
+        auto it = buckets.find(key(event, probe & 1 ? std::string_view() : room,
+                                   probe & 2 ? std::string_view() : subject, probe & 4, state));
+        if (it == buckets.end()) continue;
+        bool seen = false;
+        for (size_t i = 0; i < foundCount; ++i) seen = seen || found[i] == &it->second;
+        if (!seen) found[foundCount++] = &it->second;
+    }
+
+    // Merge the buckets so rules fire in definition order
+    size_t cursor[kProbes] = {};
+    while (true) {
+        size_t next = kProbes;
+        for (size_t i = 0; i < foundCount; ++i) {
+            if (cursor[i] < found[i]->size() &&
+                (next == kProbes || (*found[i])[cursor[i]] < (*found[next])[cursor[next]])) {
+                next = i;
+            }
+        }
+        if (next == kProbes) return;
+        const WorldTrigger& rule = rules[(*found[next])[cursor[next]++]];
+        if (matches(rule, event, room, subject, state) && !visit(rule)) return;
+    }
+}
+
+#endif // TRIGGER_TABLE_H
@@ -0,0 +1,93 @@
+#ifndef UNDO_LOG_H
+#define UNDO_LOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// What an UndoRecord reverts
+enum class UndoKind : uint8_t {
+    Step,      // Closes the records of one command
+    State,     // 'value' = previous GameState, 'slot' = previous ending
+    Flags,     // 'value' = previous flag bits (see Game::undoFlags)
+    Location,  // 'value' = index of the room the player was in
+    Cutscenes, // 'value' = previous number of cutscenes played
+    Element,   // Element 'slot' of room 'place' was in stage 'value'
+    ItemMove   // An item went from position 'slot' of 'place' to the end of 'value'
+};
+
+// One change made by a command, holding just what is needed to revert it. Places are room indexes
+// or one of UndoLog::kInventory and UndoLog::kReserve
+struct UndoRecord {
+    UndoKind kind;
+    uint16_t slot;
+    uint32_t place;
+    uint32_t value;
+};
+
+// Fixed-size ring buffer of the changes made by the last few commands.
+//
+// A command pushes one record per thing it changed and then closes its step, so the memory a
+// command costs (and the time to undo it) is proportional to what it changed, not to the size of
+// the world. Commands that change nothing leave no step. When the ring is full the oldest steps are
+// dropped whole; a single command that changes more than the ring holds cannot be undone and clears
+// the history. The ring is allocated on the first push, so copies that never record cost nothing.
+class UndoLog {
+public:
+    // Places that are not rooms
+    static constexpr uint32_t kInventory = UINT32_MAX;
+    static constexpr uint32_t kReserve = UINT32_MAX - 1;
+
+    // Constructor
+    explicit UndoLog(size_t capacity = 0);
+
+    size_t capacity() const { return ringCapacity; }
+
+    // Number of closed steps that can be undone
+    size_t steps() const { return stepCount; }
+
+    // True if a change has been pushed since the last step was closed
+    bool stepOpen() const { return openRecords > 0; }
+
+    // Adds a change to the open step
+    void push(const UndoRecord& record);
+
+    // Closes the open step; does nothing if no change was pushed since the last one
+    void endStep();
+
+    // Removes the newest closed step, calling revert(record) for each of its changes, newest first.
+    // Returns false if there is no step to undo
+    template <typename Revert>
+    bool undoStep(Revert revert) {
+        if (stepCount == 0 || openRecords > 0) return false;
+        pop(); // The step marker
+        while (count > 0 && at(count - 1).kind != UndoKind::Step) revert(pop());
+        --stepCount;
+        return true;
+    }
+
+    // Forgets every step, keeping the ring's storage
+    void clear();
+
+    // Calls fn(record) for every record of the closed steps, oldest first and step markers included.
+    // Pushing them again in this order (ending a step at each marker) rebuilds the same history
+    template <typename Fn>
+    void forEachRecord(Fn fn) const {
+        for (size_t i = 0; i + openRecords < count; ++i) fn(ring[(head + i) % ringCapacity]);
+    }
+
+private:
+    std::vector<UndoRecord> ring;
+    size_t ringCapacity;
+    size_t head;        // Slot of the oldest record
+    size_t count;       // Records in the ring
+    size_t openRecords; // Records of the step still being recorded
+    size_t stepCount;
+    bool overflowed;    // The open step no longer fits; it is discarded when closed
+
+    UndoRecord& at(size_t i) { return ring[(head + i) % ringCapacity]; }
+    UndoRecord pop();
+    void dropOldestStep();
+};
+
+#endif // UNDO_LOG_H
@@ -0,0 +1,116 @@
+#ifndef VECTOR_ENV_H
+#define VECTOR_ENV_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+
+#include "Game.h"
+
+// Compact, per-step view of one environment
+struct EnvObservation {
+    GameState state;        // Current narrative state
+    int32_t roomIndex;      // Index of the player's room in Game::allRooms (-1 if nowhere)
+    uint32_t inventoryMask; // Bit i set when the player carries VectorEnv::itemIds()[i]
+    GameState ending;       // Ending reached this episode (INTRO while still playing)
+};
+
+// A gym-style, in-process driver for many independent games at once.
+//
+// Games are stored contiguously and stepped in parallel across a small worker pool.
+// They run headless: the typewriter effect is off and narration goes to a discarded stream
+// unless 'captureText' is set, in which case each step's output is available from text().
+//
+// Actions are indices into a fixed table of commands (see actionNames()).
+// A game that reaches an ending reports terminal = 1 with its reward, and is reset
+// automatically on the following step (the action given for it that step is ignored).
+class VectorEnv {
+public:
+    // Reward given on the step an ending is reached
+    static constexpr float kRewardEscaped = 1.0f;     // Ending 2
+    static constexpr float kRewardNotWorthy = -0.5f;  // Ending 1
+    static constexpr float kRewardVictim = -1.0f;     // Ending 3
+
+    // Constructor
+    // numThreads = 0 uses every hardware thread
+    VectorEnv(size_t numEnvs, size_t numThreads = 0, bool captureText = false);
+    ~VectorEnv();
+
+    VectorEnv(const VectorEnv&) = delete;
+    VectorEnv& operator=(const VectorEnv&) = delete;
+
+    // Starts a fresh episode in every environment. Environment i seeds its Guide with seed + i
+    void reset(uint32_t seed);
+
+    // Applies actions[i] to environment i. 'actions' must hold size() entries
+    void step(const std::vector<int>& actions);
+
+    size_t size() const { return games.size(); }
+    size_t numActions() const { return actions.size(); }
+
+    // The command text of every action, e.g. "go storage" or "clean memorial"
+    const std::vector<std::string>& actionNames() const { return actionTexts; }
+
+    // Item IDs that make up the bits of EnvObservation::inventoryMask
+    const std::vector<std::string>& itemIds() const { return trackedItems; }
+
+    // --- Results of the last reset()/step(), indexed by environment ---
+    const std::vector<EnvObservation>& observations() const { return obs; }
+    const std::vector<float>& rewards() const { return rewardBuf; }
+    const std::vector<uint8_t>& terminals() const { return terminalBuf; }
+
+    // Row-major [size() x numActions()] mask; 1 marks an action that currently does something
+    const std::vector<uint8_t>& actionMasks() const { return maskBuf; }
+
+    // Narration produced by environment i during the last step (empty unless captureText)
+    std::string text(size_t env) const;
+
+private:
+    // A pre-tokenized command and what it needs to be meaningful
+    struct Action {
+        enum class Kind { Look, Inventory, Go, Get, Examine, Talk, Clean, Organize, Trim, UseCandle, Leave, Assist };
+        Kind kind;
+        std::vector<std::string> words;
+    };
+
+    void buildActionTable(const Game& prototype);
+    void resetEnv(size_t env);
+    void observe(size_t env);
+    bool isLegal(const Game& game, const Action& action) const;
+
+    // Runs fn(begin, end) over [0, size()) split across the worker pool, and waits for completion
+    void parallelFor(const std::function<void(size_t, size_t)>& fn);
+    void workerLoop(size_t workerIndex);
+
+    std::vector<Game> games;
+    std::vector<std::unique_ptr<std::ostream>> streams;
+    bool captureText;
+    uint32_t baseSeed;
+
+    std::vector<Action> actions;
+    std::vector<std::string> actionTexts;
+    std::vector<std::string> trackedItems;
+
+    std::vector<EnvObservation> obs;
+    std::vector<float> rewardBuf;
+    std::vector<uint8_t> terminalBuf;
+    std::vector<uint8_t> maskBuf;
+
+    // --- Worker pool ---
+    std::vector<std::thread> workers;
+    size_t numParts; // Worker threads plus the calling thread
+    std::mutex poolMutex;
+    std::condition_variable workReady;
+    std::condition_variable workDone;
+    const std::function<void(size_t, size_t)>* currentJob;
+    uint64_t jobGeneration;
+    size_t workersPending;
+    bool shuttingDown;
+};
+
+#endif // VECTOR_ENV_H
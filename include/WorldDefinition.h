@@ -0,0 +1,102 @@
+#ifndef WORLD_DEFINITION_H
+#define WORLD_DEFINITION_H
+
+#include <string_view>
+#include <cstdint>
+
+enum class GameState; // Forward declaration
+enum class MessageId : uint16_t; // Generated with the tables (see MessageCatalog.h)
+
+// Row types of the built-in world tables. world_codegen generates the tables themselves (kWorldRooms,
+// kWorldExits, ... in WorldTables.h) from world/visitor_center.world at build time, so all of the
+// world's text is read-only data in the executable and setting up a game only copies it into rooms.
+//
+// Rows refer to each other by index: 'room' and 'target' index kWorldRooms, and aliases and
+// element stages are ranges of kWorldAliases and kWorldStages. Triggers name rooms, items and
+// elements by id, since they are matched against whatever world is loaded. Displayed text (room, item
+// and element text, dialogue, help, trigger lines) is a message ID, so a locale catalog can replace it
+struct WorldRoom {
+    std::string_view id;
+    MessageId name;
+    MessageId description;
+};
+
+struct WorldExit {
+    uint16_t room;
+    std::string_view key;
+    uint16_t target;
+};
+
+struct WorldItem {
+    std::string_view id;
+    MessageId name;
+    MessageId description;
+    uint16_t room;        // kNotPlaced for an item that only appears during the story
+    uint16_t firstAlias;
+    uint16_t aliasCount;
+};
+
+struct WorldElement {
+    uint16_t room;
+    std::string_view name;
+    uint16_t firstStage;
+    uint16_t stageCount;
+    uint16_t firstAlias;
+    uint16_t aliasCount;
+};
+
+struct WorldDialogue {
+    GameState state;
+    MessageId message;
+};
+
+struct WorldHelp {
+    std::string_view topic;
+    MessageId message;
+};
+
+// What sets a story trigger off
+enum class TriggerEvent : uint8_t {
+    Enter, // The player walks into a room
+    Take,  // The player picks an item up
+    Use    // The player uses an item or an element
+};
+
+// One step of what a trigger does
+enum class TriggerAction : uint8_t {
+    Say,     // Plays line 'message' as a cutscene; consecutive lines form one cutscene
+    State,   // Moves the story to 'state'
+    Advance, // Advances element 'text' of the event's room (to 'stage' if it is not negative)
+    Spawn    // Places the held-back item in room 'text'
+};
+
+// A story rule: when 'event' happens in 'room' about 'subject' (an item or element) while the story
+// is in 'state', and the conditions hold, its steps run in order. An empty room or subject, or
+// 'anyState', matches anything. Steps are a range of kWorldTriggerSteps
+struct WorldTrigger {
+    std::string_view name;
+    TriggerEvent event;
+    std::string_view room;
+    std::string_view subject;
+    bool anyState;
+    GameState state;
+    std::string_view element;  // If set, this element of the room must be in stage 'elementStage'
+    uint16_t elementStage;
+    bool needsCarried;         // The player must be carrying 'subject'
+    bool needsUnspawned;       // The held-back item must not have appeared yet
+    uint16_t firstStep;
+    uint16_t stepCount;
+};
+
+struct WorldTriggerStep {
+    TriggerAction action;
+    GameState state;
+    std::string_view text;
+    int16_t stage;
+    MessageId message;
+};
+
+// WorldItem::room of an item that is not in any room when the game starts
+constexpr uint16_t kNotPlaced = 0xFFFF;
+
+#endif // WORLD_DEFINITION_H
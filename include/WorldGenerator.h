@@ -0,0 +1,44 @@
+#ifndef WORLD_GENERATOR_H
+#define WORLD_GENERATOR_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "Room.h"
+
+// Shape of a procedurally generated world
+struct WorldSpec {
+    size_t roomCount = 1000;
+    size_t exitsPerRoom = 4;           // Includes the 'forward'/'back' corridor that keeps every room reachable
+    size_t itemsPerRoom = 2;
+    size_t elementsPerRoom = 2;
+    size_t descriptionsPerElement = 2;
+    uint32_t seed = 1;
+};
+
+// Builds large worlds out of the ordinary Room, Item and InteractiveElement types, for benchmarks
+// and stress tests of code that only ever saw the six hand-made rooms.
+//
+// Room i has id "room_<i>". Its exits are 'forward' (to room i+1), 'back' (to room i-1), both
+// wrapping around, plus 'passage_<k>' exits to random rooms. Its items have ids "item_<i>_<k>"
+// and its elements are named "element_<k>". The same spec always produces the same world.
+class WorldGenerator {
+public:
+    // Constructor
+    explicit WorldGenerator(const WorldSpec& spec);
+
+    // Creates the rooms of a new world
+    std::vector<std::unique_ptr<Room>> generate() const;
+
+    // Names used by generated worlds, so callers can address rooms, items and elements directly
+    static std::string roomId(size_t roomIndex);
+    static std::string itemId(size_t roomIndex, size_t itemIndex);
+    static std::string elementName(size_t elementIndex);
+    static std::string passageExit(size_t passageIndex);
+
+private:
+    WorldSpec spec;
+};
+
+#endif // WORLD_GENERATOR_H
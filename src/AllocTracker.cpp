@@ -0,0 +1,86 @@
+#include "AllocTracker.h"
+#include <cstring>
+
+namespace {
+
+// Plain data in thread-local storage, so recording never touches the heap
+struct ThreadCounts {
+    AllocCounts total;
+    const char* names[AllocTracker::kMaxScopes];
+    AllocCounts scopes[AllocTracker::kMaxScopes];
+    size_t used;
+    int current; // Slot of the innermost open scope, or -1
+    bool started;
+};
+
+thread_local ThreadCounts counts;
+
+ThreadCounts& local() {
+    if (!counts.started) {
+        counts.current = -1;
+        counts.started = true;
+    }
+    return counts;
+}
+
+} // namespace
+
+AllocCounts AllocTracker::totals() {
+    return local().total;
+}
+
+AllocCounts AllocTracker::scope(const char* name) {
+    ThreadCounts& c = local();
+    for (size_t i = 0; i < c.used; ++i) {
+        if (std::strcmp(c.names[i], name) == 0) return c.scopes[i];
+    }
+    return AllocCounts();
+}
+
+void AllocTracker::reset() {
+    ThreadCounts& c = local();
+    c.total = AllocCounts();
+    for (size_t i = 0; i < c.used; ++i) c.scopes[i] = AllocCounts();
+}
+
+void AllocTracker::record(size_t bytes) {
+    ThreadCounts& c = local();
+    ++c.total.allocations;
+    c.total.bytes += bytes;
+    if (c.current >= 0) {
+        ++c.scopes[c.current].allocations;
+        c.scopes[c.current].bytes += bytes;
+    }
+}
+
+int AllocTracker::enter(const char* name) {
+    ThreadCounts& c = local();
+    int previous = c.current;
+    size_t slot = 0;
+    while (slot < c.used && c.names[slot] != name && std::strcmp(c.names[slot], name) != 0) ++slot;
+    if (slot == c.used) {
+        if (c.used == kMaxScopes) {
+            c.current = -1;
+            return previous;
+        }
+        c.names[c.used++] = name;
+    }
+    c.current = static_cast<int>(slot);
+    return previous;
+}
+
+void AllocTracker::leave(int previous) {
+    local().current = previous;
+}
+
+size_t AllocTracker::scopeCount() {
+    return local().used;
+}
+
+const char* AllocTracker::scopeName(size_t slot) {
+    return local().names[slot];
+}
+
+const AllocCounts& AllocTracker::scopeAt(size_t slot) {
+    return local().scopes[slot];
+}
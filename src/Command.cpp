@@ -0,0 +1,65 @@
+#include "Command.h"
+#include "FuzzyIndex.h"
+#include <unordered_map>
+
+namespace {
+
+const std::unordered_map<std::string, Verb>& verbTable() {
+    static const std::unordered_map<std::string, Verb> verbs = {
+        {"quit", Verb::Quit},
+        {"go", Verb::Go}, {"move", Verb::Go},
+        {"look", Verb::Look}, {"l", Verb::Look},
+        {"examine", Verb::Examine}, {"x", Verb::Examine}, {"inspect", Verb::Examine},
+        {"get", Verb::Get}, {"take", Verb::Get}, {"pickup", Verb::Get},
+        {"inventory", Verb::Inventory}, {"i", Verb::Inventory}, {"inv", Verb::Inventory},
+        {"talk", Verb::Talk},
+        {"help", Verb::Help}, {"?", Verb::Help},
+        {"use", Verb::Use},
+        {"clean", Verb::Clean},
+        {"organize", Verb::Organize},
+        {"trim", Verb::Trim},
+        {"leave", Verb::Leave},
+        {"assist", Verb::Assist},
+        {"travel", Verb::Travel}, {"goto", Verb::Travel},
+        {"hint", Verb::Hint},
+        {"ack", Verb::Ack},
+        {"undo", Verb::Undo}
+    };
+    return verbs;
+}
+
+} // namespace
+
+// Maps a command word to its verb
+Verb verbFromWord(const std::string& word) {
+    const auto& verbs = verbTable();
+    auto it = verbs.find(word);
+    return it != verbs.end() ? it->second : Verb::Unknown;
+}
+
+// Closest command word by edit distance
+const std::string* closestVerbWord(const std::string& word) {
+    static const FuzzyIndex tree = [] {
+        FuzzyIndex built;
+        for (const auto& entry : verbTable()) built.insert(entry.first);
+        return built;
+    }();
+    FuzzyMatch match;
+    tree.search(word, FuzzyIndex::typoBudget(word.size()), [&](const std::string& candidate, unsigned distance) {
+        // Aliases of one verb share its name, so "l" vs "look" is not a tie
+        match.offer(candidate, distance, verbName(verbFromWord(candidate)));
+    });
+    return match.found() ? match.word : nullptr;
+}
+
+// Canonical name of a verb
+const char* verbName(Verb verb) {
+    static const char* const names[] = {
+        "unknown", "quit", "go", "look", "examine", "get", "inventory", "talk", "help",
+        "use", "clean", "organize", "trim", "leave", "assist", "travel", "hint", "ended", "ack", "undo",
+        "ending undone"
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) == static_cast<size_t>(Verb::Count), "verb names out of sync");
+    size_t index = static_cast<size_t>(verb);
+    return index < static_cast<size_t>(Verb::Count) ? names[index] : "unknown";
+}
@@ -0,0 +1,216 @@
+#include "ContentStore.h"
+#include "Game.h"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <functional>
+#include <sys/stat.h>
+
+// Collects the text of the game as it was set up
+std::unique_ptr<ContentSnapshot> ContentSnapshot::fromGame(const Game& game) {
+    auto snapshot = std::make_unique<ContentSnapshot>();
+    for (const auto& room : game.allRooms) {
+        snapshot->rooms[room->id] = RoomText{room->name, room->description};
+        for (uint32_t e = 0; e < room->elements.size(); ++e) {
+            snapshot->elementStages[room->id + "/" + room->elements.name(e)] = room->elements.descriptions(e);
+        }
+    }
+    snapshot->dialogueLines = game.guide.dialogueLines;
+    snapshot->commandExplanations = game.guide.commandExplanations;
+    return snapshot;
+}
+
+// Parses a content file line by line, overriding what is already in the snapshot
+bool ContentSnapshot::loadFile(const std::string& path, std::string* error) {
+    auto fail = [error, &path](size_t lineNumber, const std::string& message) {
+        if (error) *error = path + (lineNumber ? ":" + std::to_string(lineNumber) : "") + ": " + message;
+        return false;
+    };
+
+    std::ifstream file(path);
+    if (!file) return fail(0, "cannot open file");
+
+    std::map<GameState, bool> replacedDialogue;
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line[start] == '#') continue;
+
+        size_t separator = line.find(" = ");
+        if (separator == std::string::npos) return fail(lineNumber, "expected '<key> = <text>'");
+        std::string text = line.substr(separator + 3);
+        std::istringstream keyStream(line.substr(0, separator));
+        std::vector<std::string> key;
+        for (std::string word; keyStream >> word;) key.push_back(word);
+        if (key.empty()) return fail(lineNumber, "missing key before '='");
+
+        if (key[0] == "room" && key.size() == 3) {
+            auto room = rooms.find(key[1]);
+            if (room == rooms.end()) return fail(lineNumber, "unknown room '" + key[1] + "'");
+            if (key[2] == "name") room->second.name = text;
+            else if (key[2] == "description") room->second.description = text;
+            else return fail(lineNumber, "rooms only have a 'name' and a 'description'");
+        } else if (key[0] == "element" && key.size() == 4) {
+            auto stages = elementStages.find(key[1] + "/" + key[2]);
+            if (stages == elementStages.end()) return fail(lineNumber, "unknown element '" + key[2] + "' in room '" + key[1] + "'");
+            bool numeric = key[3].size() <= 4 && key[3].find_first_not_of("0123456789") == std::string::npos;
+            size_t stage = numeric ? std::stoul(key[3]) : 0;
+            if (!numeric || stage > stages->second.size()) {
+                return fail(lineNumber, "stage must be a number no larger than the number of existing stages");
+            }
+            if (stage == stages->second.size()) stages->second.push_back(text);
+            else stages->second[stage] = text;
+        } else if (key[0] == "dialogue" && key.size() == 2) {
+            bool known = false;
+            for (int i = 0; i <= static_cast<int>(GameState::GAME_OVER); ++i) {
+                GameState state = static_cast<GameState>(i);
+                if (key[1] != gameStateName(state)) continue;
+                known = true;
+                // The first line for a state in this file replaces the built-in lines
+                if (!replacedDialogue[state]) {
+                    replacedDialogue[state] = true;
+                    dialogueLines[state].clear();
+                }
+                dialogueLines[state].push_back(text);
+                break;
+            }
+            if (!known) return fail(lineNumber, "unknown game state '" + key[1] + "'");
+        } else if (key[0] == "help" && key.size() == 2) {
+            commandExplanations[key[1]] = text;
+        } else {
+            return fail(lineNumber, "unknown key '" + line.substr(start, separator > start ? separator - start : 0) + "'");
+        }
+    }
+    return true;
+}
+
+// Constructor
+ContentStore::ContentStore(std::unique_ptr<ContentSnapshot> initial)
+    : current(nullptr), globalEpoch(1), publishedVersion(0) {
+    publish(std::move(initial));
+}
+
+ContentStore::~ContentStore() {
+    // No reader may outlive the store, so everything can go
+    delete current.load();
+    for (const Retired& old : retired) delete old.snapshot;
+}
+
+uint64_t ContentStore::publish(std::unique_ptr<ContentSnapshot> next) {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    uint64_t version = publishedVersion.load(std::memory_order_relaxed) + 1;
+    next->version = version;
+
+    const ContentSnapshot* previous = current.exchange(next.release());
+    // Readers that pin from now on see the new pointer; earlier ones may still hold 'previous'
+    uint64_t epoch = globalEpoch.fetch_add(1) + 1;
+    publishedVersion.store(version, std::memory_order_release);
+    if (previous) retired.push_back(Retired{epoch, previous});
+    reclaimLocked();
+    return version;
+}
+
+size_t ContentStore::retiredCount() const {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    return retired.size();
+}
+
+void ContentStore::reclaimLocked() {
+    uint64_t oldestPinned = UINT64_MAX;
+    for (const ReaderSlot& slot : slots) {
+        uint64_t epoch = slot.epoch.load();
+        if (epoch != 0 && epoch < oldestPinned) oldestPinned = epoch;
+    }
+    size_t kept = 0;
+    for (const Retired& old : retired) {
+        if (old.epoch <= oldestPinned) {
+            delete old.snapshot;
+        } else {
+            retired[kept++] = old;
+        }
+    }
+    retired.resize(kept);
+}
+
+// Claims a free slot (starting at a per-thread position to spread threads out), then pins the epoch.
+// The epoch is published before the pointer is loaded, so a publisher that does not see the pin
+// has already swapped the pointer, and this reader loads the new snapshot
+ContentStore::ReadGuard::ReadGuard(const ContentStore& store) : store(store), slot(0), snapshot(nullptr) {
+    size_t start = std::hash<std::thread::id>()(std::this_thread::get_id()) % kReaderSlots;
+    for (size_t attempt = 0;; ++attempt) {
+        size_t candidate = (start + attempt) % kReaderSlots;
+        bool expected = false;
+        if (!store.slots[candidate].claimed.load(std::memory_order_relaxed) &&
+            store.slots[candidate].claimed.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            slot = candidate;
+            break;
+        }
+        if (attempt % kReaderSlots == kReaderSlots - 1) std::this_thread::yield();
+    }
+    store.slots[slot].epoch.store(store.globalEpoch.load());
+    snapshot = store.current.load();
+}
+
+ContentStore::ReadGuard::~ReadGuard() {
+    store.slots[slot].epoch.store(0, std::memory_order_release);
+    store.slots[slot].claimed.store(false, std::memory_order_release);
+}
+
+namespace {
+
+// Modification time in nanoseconds, or -1 if the file cannot be read
+int64_t modificationTime(const std::string& path) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) return -1;
+    return static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+}
+
+} // namespace
+
+// Constructor
+ContentWatcher::ContentWatcher(ContentStore& store, std::string path, const ContentSnapshot& base,
+                               std::chrono::milliseconds interval)
+    : store(store),
+    path(std::move(path)),
+    base(base),
+    interval(interval),
+    lastModified(modificationTime(this->path)),
+    stopping(false) {
+    worker = std::thread(&ContentWatcher::watchLoop, this);
+}
+
+ContentWatcher::~ContentWatcher() {
+    {
+        std::lock_guard<std::mutex> lock(stopMutex);
+        stopping = true;
+    }
+    stopSignal.notify_all();
+    worker.join();
+}
+
+// Every reload starts from the base, so removing a line from the file restores the built-in text
+bool ContentWatcher::reloadNow(std::string* error) {
+    lastModified = modificationTime(path);
+    auto next = std::make_unique<ContentSnapshot>(base);
+    if (!next->loadFile(path, error)) return false;
+    store.publish(std::move(next));
+    return true;
+}
+
+void ContentWatcher::watchLoop() {
+    std::unique_lock<std::mutex> lock(stopMutex);
+    while (!stopSignal.wait_for(lock, interval, [this] { return stopping; })) {
+        int64_t modified = modificationTime(path);
+        if (modified < 0 || modified == lastModified) continue;
+
+        std::string error;
+        if (reloadNow(&error)) {
+            std::cerr << "Reloaded " << path << " (content version " << store.version() << ")" << std::endl;
+        } else {
+            std::cerr << "Keeping current content: " << error << std::endl;
+        }
+    }
+}
@@ -0,0 +1,307 @@
+#include "CoopGame.h"
+#include "Tracer.h"
+#include <unordered_set>
+
+// Constructor
+CoopGame::Member::Member(std::string name, Room* start, std::ostream& output)
+    : name(std::move(name)), player(start), out(&output), location(start), active(true) {}
+
+// Constructor
+// The world narrates into the void; each command points it at a buffer for the player who typed it
+CoopGame::CoopGame() : discard(nullptr), world(discard, 0) {
+    indexRooms();
+}
+
+void CoopGame::loadWorld(std::vector<std::unique_ptr<Room>> rooms, const std::string& startRoomId) {
+    std::unique_lock<std::shared_mutex> exclusive(worldLock);
+    world.loadWorld(std::move(rooms), startRoomId);
+    indexRooms();
+}
+
+void CoopGame::indexRooms() {
+    roomIndex.clear();
+    for (size_t i = 0; i < world.allRooms.size(); ++i) roomIndex[world.allRooms[i].get()] = i;
+    roomLocks = std::make_unique<std::mutex[]>(world.allRooms.size() + 1);
+}
+
+// Rooms are never added or removed while players are in, so the index is read without locking.
+// The extra mutex at the end stands in for "nowhere"
+std::mutex& CoopGame::roomMutex(const Room* room) {
+    auto it = roomIndex.find(room);
+    return roomLocks[it != roomIndex.end() ? it->second : roomIndex.size()];
+}
+
+size_t CoopGame::join(const std::string& name, std::ostream& output) {
+    Member* joined;
+    size_t id;
+    {
+        std::unique_lock<std::shared_mutex> lock(membersLock);
+        members.push_back(std::make_unique<Member>(name, world.startLocation, output));
+        joined = members.back().get();
+        id = members.size() - 1;
+    }
+
+    std::ostringstream os;
+    {
+        std::shared_lock<std::shared_mutex> shared(worldLock);
+        std::lock_guard<std::mutex> room(roomMutex(joined->player.currentLocation));
+        world.lookAround(joined->player, os);
+    }
+    listOthersHere(*joined, os);
+    deliver(*joined, os.str());
+    broadcast(*joined, name + " has joined the visit.\n");
+    return id;
+}
+
+void CoopGame::leave(size_t playerId) {
+    Member* leaving = member(playerId);
+    if (!leaving) return;
+    std::lock_guard<std::mutex> turn(leaving->turnMutex);
+    dropOut(*leaving);
+}
+
+// Caller holds the member's turn mutex
+void CoopGame::dropOut(Member& leaving) {
+    if (!leaving.active) return;
+    {
+        std::unique_lock<std::shared_mutex> exclusive(worldLock);
+        std::vector<std::unique_ptr<Item>> carried;
+        leaving.player.takeAllItems(carried);
+        for (auto& item : carried) {
+            leaving.player.updateItemFlags(item->id, false);
+            if (leaving.player.currentLocation) leaving.player.currentLocation->addItem(std::move(item));
+        }
+        leaving.active = false;
+    }
+    broadcast(leaving, leaving.name + " has left the visit.\n");
+}
+
+void CoopGame::processInput(size_t playerId, const std::string& rawInput) {
+    TRACE_SCOPE("CoopGame::processInput");
+    Member* actor = member(playerId);
+    if (!actor || !actor->active) return;
+    std::lock_guard<std::mutex> turn(actor->turnMutex);
+
+    std::vector<std::string> words;
+    Game::parseCommand(rawInput, words);
+    if (words.empty()) return;
+
+    std::ostringstream os;
+    Verb verb;
+    Room* entered = nullptr;    // Set by a 'go' that walked into a room with a pending story beat
+    Item* taken = nullptr;      // Set by a 'get' whose item has a pending story beat
+    {
+        std::shared_lock<std::shared_mutex> shared(worldLock);
+        if (world.gameOver) {
+            deliver(*actor, "The visit is over.\n");
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> room(roomMutex(actor->player.currentLocation));
+            if (world.autoCorrect(words, actor->player)) Game::describeCorrection(words, os);
+        }
+        verb = verbFromWord(words[0]);
+
+        switch (verb) {
+            case Verb::Look: {
+                {
+                    std::lock_guard<std::mutex> room(roomMutex(actor->player.currentLocation));
+                    world.lookAround(actor->player, os);
+                }
+                listOthersHere(*actor, os);
+                break;
+            }
+            case Verb::Examine: {
+                std::lock_guard<std::mutex> room(roomMutex(actor->player.currentLocation));
+                world.examineFor(actor->player, words, os);
+                break;
+            }
+            case Verb::Inventory:
+                actor->player.showInventory(os);
+                break;
+            case Verb::Go: {
+                if (words.size() < 2) {
+                    os << "Go where?" << std::endl;
+                    break;
+                }
+                // Exits never change during play, so the destination can be looked up before locking
+                Room* from = actor->player.currentLocation;
+                Room* to = from;
+                if (from) {
+                    auto exit = from->exits.find(words[1]);
+                    if (exit != from->exits.end()) to = exit->second;
+                }
+                std::mutex& fromLock = roomMutex(from);
+                std::mutex& toLock = roomMutex(to);
+                std::unique_lock<std::mutex> first(fromLock, std::defer_lock);
+                std::unique_lock<std::mutex> second(toLock, std::defer_lock);
+                if (&fromLock == &toLock) first.lock();
+                else std::lock(first, second);
+
+                if (Room* next = world.walk(actor->player, words[1], os)) {
+                    actor->location = next;
+                    if (world.entryTriggerPending(next)) entered = next;
+                }
+                if (second.owns_lock()) second.unlock();
+                first.unlock();
+                if (!entered) listOthersHere(*actor, os);
+                break;
+            }
+            case Verb::Get: {
+                if (words.size() < 2) {
+                    os << "Get what?" << std::endl;
+                    break;
+                }
+                std::lock_guard<std::mutex> room(roomMutex(actor->player.currentLocation));
+                Item* item = world.take(actor->player, Game::resolveNounFor(actor->player, words, true), os);
+                if (item && world.itemTriggerPending(actor->player.currentLocation, *item)) taken = item;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    bool local = verb == Verb::Look || verb == Verb::Examine || verb == Verb::Inventory ||
+        verb == Verb::Go || verb == Verb::Get;
+    if (verb == Verb::Quit) {
+        deliver(*actor, "You leave the others to it.\n");
+        dropOut(*actor);
+        return;
+    }
+    if (local && !entered && !taken) {
+        deliver(*actor, os.str());
+        return;
+    }
+
+    // Story beat: the world is ours alone. Triggers are checked again, since another player may
+    // have set them off between releasing the shared lock and getting here
+    std::ostringstream story;
+    bool advanced = runExclusive(*actor, story, [&] {
+        if (entered) {
+            if (world.entryTriggerPending(entered)) world.onPlayerEntered(entered);
+        } else if (taken) {
+            if (world.itemTriggerPending(world.player.currentLocation, *taken)) {
+                world.onItemTaken(world.player.currentLocation, *taken);
+            }
+        } else {
+            world.executeCommand(words);
+        }
+    });
+    os << story.str();
+    if (entered) listOthersHere(*actor, os);
+    deliver(*actor, os.str());
+    if (advanced) broadcast(*actor, "\n[" + actor->name + "]" + story.str());
+}
+
+template <typename Action>
+bool CoopGame::runExclusive(Member& actor, std::ostream& os, Action&& action) {
+    std::unique_lock<std::shared_mutex> exclusive(worldLock);
+    if (world.gameOver) {
+        os << "The visit is over." << std::endl;
+        return false;
+    }
+    GameState stateBefore = world.currentGameState;
+    size_t cutscenesBefore = world.cutscenesPlayed;
+
+    std::swap(world.player, actor.player);
+    world.out = &os;
+    action();
+    world.out = &discard;
+    std::swap(world.player, actor.player);
+    actor.location = actor.player.currentLocation;
+
+    return world.currentGameState != stateBefore || world.cutscenesPlayed != cutscenesBefore;
+}
+
+void CoopGame::listOthersHere(const Member& viewer, std::ostream& os) const {
+    const Room* here = viewer.location;
+    bool any = false;
+    std::shared_lock<std::shared_mutex> lock(membersLock);
+    for (const auto& other : members) {
+        if (other.get() == &viewer || !other->active || other->location != here) continue;
+        os << (any ? ", " : "Also here: ") << other->name;
+        any = true;
+    }
+    if (any) os << std::endl;
+}
+
+void CoopGame::deliver(Member& target, const std::string& text) {
+    if (text.empty()) return;
+    std::lock_guard<std::mutex> lock(target.outputMutex);
+    *target.out << text << std::flush;
+}
+
+void CoopGame::broadcast(const Member& from, const std::string& text) {
+    std::shared_lock<std::shared_mutex> lock(membersLock);
+    for (const auto& other : members) {
+        if (other.get() != &from && other->active) deliver(*other, text);
+    }
+}
+
+CoopGame::Member* CoopGame::member(size_t playerId) const {
+    std::shared_lock<std::shared_mutex> lock(membersLock);
+    return playerId < members.size() ? members[playerId].get() : nullptr;
+}
+
+bool CoopGame::isOver() const {
+    std::shared_lock<std::shared_mutex> shared(worldLock);
+    return world.gameOver;
+}
+
+GameState CoopGame::state() const {
+    std::shared_lock<std::shared_mutex> shared(worldLock);
+    return world.currentGameState;
+}
+
+size_t CoopGame::playerCount() const {
+    std::shared_lock<std::shared_mutex> lock(membersLock);
+    size_t count = 0;
+    for (const auto& other : members) count += other->active ? 1 : 0;
+    return count;
+}
+
+// Every item must be in exactly one place: a room, the reserve, or one player's inventory (the
+// Game's own stand-in player included), and every player must stand in a room of this world
+bool CoopGame::checkInvariants(std::string* problem) const {
+    auto fail = [problem](const std::string& message) {
+        if (problem) *problem = message;
+        return false;
+    };
+    std::unique_lock<std::shared_mutex> exclusive(worldLock);
+    std::shared_lock<std::shared_mutex> lock(membersLock);
+
+    // Hashed, since shared worlds are often generated ones with many thousands of items
+    std::unordered_set<const Item*> seen;
+    std::unordered_set<std::string> seenIds;
+    auto track = [&](const Item* item) {
+        return seen.insert(item).second && seenIds.insert(item->id).second;
+    };
+
+    for (const auto& room : world.allRooms) {
+        for (const auto& item : room->items) {
+            if (!item || !track(item.get())) return fail("item in '" + room->id + "' is null or duplicated");
+        }
+    }
+    if (world.reservedSurgicalItem && !track(world.reservedSurgicalItem.get())) {
+        return fail("reserved surgical item is duplicated");
+    }
+    std::vector<const Player*> players{&world.player};
+    for (const auto& other : members) players.push_back(&other->player);
+    for (const Player* player : players) {
+        if (!roomIndex.count(player->currentLocation)) return fail("a player is not in any room of this game");
+        for (const auto& item : player->inventory) {
+            if (!item || !track(item.get())) return fail("an inventory holds a null or duplicated item");
+            if (!player->getItemFromInventory(item->id)) return fail("item '" + item->id + "' is missing from an inventory index");
+        }
+    }
+    for (size_t i = 0; i < members.size(); ++i) {
+        if (members[i]->location != members[i]->player.currentLocation) {
+            return fail("the location of " + members[i]->name + " is out of date");
+        }
+    }
+    if (seen.size() != world.itemHomes.size() + 1) {
+        return fail("expected " + std::to_string(world.itemHomes.size() + 1) + " items but found " + std::to_string(seen.size()));
+    }
+    return true;
+}
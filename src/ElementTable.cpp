@@ -0,0 +1,88 @@
+#include "ElementTable.h"
+#include <algorithm>
+
+const std::string& ElementRef::name() const {
+    return table->name(index);
+}
+
+uint32_t ElementRef::state() const {
+    return table->state(index);
+}
+
+void ElementRef::examine(std::ostream& os) const {
+    table->examine(index, os);
+}
+
+void ElementRef::advanceState(int newState) {
+    table->advanceState(index, newState);
+}
+
+uint32_t ElementTable::add(const InteractiveElement& element) {
+    uint32_t index = static_cast<uint32_t>(names.size());
+    names.push_back(element.name);
+    nounLists.push_back(element.nouns);
+    stateIndex.push_back(0);
+    textRevision.push_back(0);
+    descriptionText.insert(descriptionText.end(), element.descriptions.begin(), element.descriptions.end());
+    descriptionStart.push_back(static_cast<uint32_t>(descriptionText.size()));
+    return index;
+}
+
+bool ElementTable::setState(uint32_t i, uint32_t state) {
+    uint32_t stages = stageCount(i);
+    if (stages > 0 && state >= stages) return false;
+    stateIndex[i] = state;
+    return true;
+}
+
+void ElementTable::resetStates() {
+    std::fill(stateIndex.begin(), stateIndex.end(), 0u);
+}
+
+std::vector<std::string> ElementTable::descriptions(uint32_t i) const {
+    return std::vector<std::string>(descriptionText.begin() + descriptionStart[i], descriptionText.begin() + descriptionStart[i + 1]);
+}
+
+void ElementTable::setDescriptions(uint32_t i, const std::vector<std::string>& stages) {
+    auto first = descriptionText.begin() + descriptionStart[i];
+    auto last = descriptionText.begin() + descriptionStart[i + 1];
+    if (std::equal(first, last, stages.begin(), stages.end())) return;
+    ++textRevision[i];
+    // Overwrite in place where the counts match, so a text fix does not move the rest of the table
+    size_t common = std::min(static_cast<size_t>(last - first), stages.size());
+    std::copy(stages.begin(), stages.begin() + common, first);
+    if (stages.size() > common) {
+        descriptionText.insert(first + common, stages.begin() + common, stages.end());
+    } else {
+        descriptionText.erase(first + common, last);
+    }
+
+    int64_t shift = static_cast<int64_t>(stages.size()) - stageCount(i);
+    for (size_t k = i + 1; k < descriptionStart.size(); ++k) {
+        descriptionStart[k] = static_cast<uint32_t>(descriptionStart[k] + shift);
+    }
+    if (stateIndex[i] >= stages.size()) stateIndex[i] = static_cast<uint32_t>(stages.size() - 1);
+}
+
+int ElementTable::find(const std::string& name) const {
+    auto it = std::find(names.begin(), names.end(), name);
+    return it != names.end() ? static_cast<int>(it - names.begin()) : -1;
+}
+
+// Displays the current description of element i
+void ElementTable::examine(uint32_t i, std::ostream& os) const {
+    if (stateIndex[i] < stageCount(i)) {
+        os << description(i, stateIndex[i]) << std::endl;
+    } else {
+        os << "You look at the " << names[i] << ", but nothing seems out of the ordinary." << std::endl;
+    }
+}
+
+// Advances element i to its next description, or to 'newState' if that is one of its descriptions
+void ElementTable::advanceState(uint32_t i, int newState) {
+    if (newState == -1) {
+        if (stateIndex[i] + 1 < stageCount(i)) stateIndex[i]++;
+    } else if (static_cast<uint32_t>(newState) < stageCount(i)) {
+        stateIndex[i] = static_cast<uint32_t>(newState);
+    }
+}
@@ -0,0 +1,277 @@
+#include "EventStream.h"
+#include "Game.h"
+#include "Room.h"
+#include "Item.h"
+#include <cstdio>
+#include <charconv>
+
+// Constructor
+EventWriter::EventWriter(std::ostream& sink) : sink(sink), narrationStream(&narrationBuffer) {
+    line.reserve(4096);
+    narrationBuffer.text.reserve(4096);
+}
+
+EventWriter::NarrationBuffer::int_type EventWriter::NarrationBuffer::overflow(int_type ch) {
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) text.push_back(traits_type::to_char_type(ch));
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize EventWriter::NarrationBuffer::xsputn(const char* s, std::streamsize count) {
+    text.append(s, static_cast<size_t>(count));
+    return count;
+}
+
+// With deltas on, the client already has the room's contents, so only the id is sent
+void EventWriter::roomView(const Room& room) {
+    begin("room_view");
+    field("id", room.id);
+    if (sync) {
+        end();
+        return;
+    }
+    field("name", room.name);
+    field("description", room.description);
+    itemList("items", room.items);
+
+    key("elements");
+    line.push_back('[');
+    for (uint32_t i = 0; i < room.elements.size(); ++i) {
+        if (i > 0) line.push_back(',');
+        line.push_back('"');
+        const std::string& name = room.elements.name(i);
+        appendEscaped(name.data(), name.size());
+        line.push_back('"');
+    }
+    line.push_back(']');
+    exitList(room);
+    end();
+}
+
+void EventWriter::itemPicked(const Item& item) {
+    begin("item_picked");
+    field("id", item.id);
+    field("name", item.name);
+    end();
+}
+
+void EventWriter::dialogue(std::string_view speaker, std::string_view text) {
+    begin("dialogue");
+    field("speaker", speaker);
+    field("text", text);
+    end();
+}
+
+void EventWriter::stateTransition(GameState from, GameState to) {
+    begin("state_transition");
+    field("from", gameStateName(from));
+    field("to", gameStateName(to));
+    end();
+}
+
+// Leading blank lines only space out the prose version, so they are dropped
+void EventWriter::cutsceneLine(std::string_view text) {
+    size_t first = text.find_first_not_of('\n');
+    if (first == std::string_view::npos) return;
+    begin("cutscene_line");
+    key("text");
+    line.push_back('"');
+    appendEscaped(text.data() + first, text.size() - first);
+    line.push_back('"');
+    end();
+}
+
+void EventWriter::ending(GameState ending) {
+    begin("ending");
+    field("ending", gameStateName(ending));
+    key("number");
+    line.push_back(static_cast<char>('1' + (static_cast<int>(ending) - static_cast<int>(GameState::ENDING_NOT_WORTHY))));
+    end();
+}
+
+void EventWriter::prompt(const Game& game) {
+    if (sync && sync->update(game)) delta(game);
+    begin("prompt");
+    field("room", game.player.currentLocation ? game.player.currentLocation->id.c_str() : "");
+    field("state", gameStateName(game.currentGameState));
+    end();
+    sink.flush();
+}
+
+void EventWriter::enableDeltas() {
+    if (!sync) sync = std::make_unique<StateSync>();
+}
+
+bool EventWriter::acknowledge(uint64_t version) {
+    return sync && sync->acknowledge(version);
+}
+
+// Serializes what StateSync decided the new version carries
+void EventWriter::delta(const Game& game) {
+    begin("delta");
+    number("version", sync->version());
+    number("acked", sync->acknowledgedVersion());
+    if (sync->stateChanged()) field("state", gameStateName(game.currentGameState));
+    if (sync->locationChanged()) field("location", game.player.currentLocation ? game.player.currentLocation->id.c_str() : "");
+    if (sync->inventoryChanged()) itemList("inventory", game.player.inventory);
+
+    key("rooms");
+    line.push_back('[');
+    bool firstRoom = true;
+    for (const StateSync::RoomChange& change : sync->roomChanges()) {
+        const Room& room = *game.allRooms[change.room];
+        if (!firstRoom) line.push_back(',');
+        firstRoom = false;
+        line += "{\"id\":\"";
+        appendEscaped(room.id.data(), room.id.size());
+        line += "\",\"full\":";
+        line += change.full ? "true" : "false";
+        if (change.full || change.text) {
+            field("name", room.name);
+            field("description", room.description);
+        }
+        if (change.full) exitList(room);
+        if (change.items) itemList("items", room.items);
+
+        key("elements");
+        line.push_back('[');
+        bool firstElement = true;
+        const ElementTable& elements = room.elements;
+        for (uint32_t e = 0; e < elements.size(); ++e) {
+            if (!sync->elementChanged(change.room, e)) continue;
+            if (!firstElement) line.push_back(',');
+            firstElement = false;
+            line += "{\"name\":\"";
+            appendEscaped(elements.name(e).data(), elements.name(e).size());
+            line.push_back('"');
+            uint32_t state = elements.state(e);
+            number("state", state);
+            if (state < elements.stageCount(e)) {
+                field("description", elements.description(e, state));
+            }
+            line.push_back('}');
+        }
+        line += "]}";
+    }
+    line.push_back(']');
+    end();
+}
+
+void EventWriter::flush() {
+    emitNarration();
+    sink.flush();
+}
+
+// Opens an event, first sending any narration written before it so the order is kept
+void EventWriter::begin(const char* type) {
+    emitNarration();
+    line.clear();
+    line += "{\"type\":\"";
+    line += type;
+    line.push_back('"');
+}
+
+void EventWriter::key(const char* name) {
+    line += ",\"";
+    line += name;
+    line += "\":";
+}
+
+void EventWriter::field(const char* name, std::string_view value) {
+    key(name);
+    line.push_back('"');
+    appendEscaped(value.data(), value.size());
+    line.push_back('"');
+}
+
+void EventWriter::field(const char* name, const char* value) {
+    key(name);
+    line.push_back('"');
+    appendEscaped(value, std::char_traits<char>::length(value));
+    line.push_back('"');
+}
+
+void EventWriter::number(const char* name, uint64_t value) {
+    key(name);
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    line.append(digits, result.ptr);
+}
+
+// [{"id", "name"}, ...]
+void EventWriter::itemList(const char* name, const std::vector<std::unique_ptr<Item>>& items) {
+    key(name);
+    line.push_back('[');
+    bool first = true;
+    for (const auto& item : items) {
+        if (!item) continue;
+        if (!first) line.push_back(',');
+        first = false;
+        line += "{\"id\":\"";
+        appendEscaped(item->id.data(), item->id.size());
+        line += "\",\"name\":\"";
+        appendEscaped(item->name.data(), item->name.size());
+        line += "\"}";
+    }
+    line.push_back(']');
+}
+
+void EventWriter::exitList(const Room& room) {
+    key("exits");
+    line.push_back('[');
+    bool first = true;
+    for (const auto& exit : room.exits) {
+        if (!first) line.push_back(',');
+        first = false;
+        line.push_back('"');
+        appendEscaped(exit.first.data(), exit.first.size());
+        line.push_back('"');
+    }
+    line.push_back(']');
+}
+
+// JSON string escaping; bytes >= 0x80 are passed through, so UTF-8 text stays as it is
+void EventWriter::appendEscaped(const char* text, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        char c = text[i];
+        switch (c) {
+            case '"': line += "\\\""; break;
+            case '\\': line += "\\\\"; break;
+            case '\n': line += "\\n"; break;
+            case '\r': line += "\\r"; break;
+            case '\t': line += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escape[8];
+                    std::snprintf(escape, sizeof(escape), "\\u%04x", static_cast<unsigned>(c));
+                    line += escape;
+                } else {
+                    line.push_back(c);
+                }
+                break;
+        }
+    }
+}
+
+void EventWriter::end() {
+    line += "}\n";
+    sink.write(line.data(), static_cast<std::streamsize>(line.size()));
+}
+
+// Sends the collected narration as one "text" event, without the blank lines around it
+void EventWriter::emitNarration() {
+    std::string& text = narrationBuffer.text;
+    size_t first = text.find_first_not_of(" \n\r\t");
+    if (first == std::string::npos) {
+        text.clear();
+        return;
+    }
+    size_t last = text.find_last_not_of(" \n\r\t");
+    line.clear();
+    line += "{\"type\":\"text\"";
+    key("text");
+    line.push_back('"');
+    appendEscaped(text.data() + first, last - first + 1);
+    line.push_back('"');
+    text.clear();
+    end();
+}
@@ -0,0 +1,28 @@
+#include "FuzzyIndex.h"
+
+// Constructor
+FuzzyIndex::FuzzyIndex() : wordCount(0), maxDepth(0) {
+    nodes.push_back(Node{0, 0, nullptr, '\0'});
+}
+
+// Walks the trie along 'word', adding the missing nodes
+void FuzzyIndex::insert(const std::string& word) {
+    uint32_t current = 0;
+    for (char ch : word) {
+        uint32_t child = nodes[current].firstChild;
+        while (child != 0 && nodes[child].ch != ch) {
+            child = nodes[child].nextSibling;
+        }
+        if (child == 0) {
+            child = static_cast<uint32_t>(nodes.size());
+            nodes.push_back(Node{0, nodes[current].firstChild, nullptr, ch});
+            nodes[current].firstChild = child;
+        }
+        current = child;
+    }
+    if (!nodes[current].word) {
+        nodes[current].word = &word;
+        ++wordCount;
+        if (word.size() > maxDepth) maxDepth = word.size();
+    }
+}
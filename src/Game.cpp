@@ -1,166 +1,243 @@
 #include "Game.h"
+#include "Tracer.h"
+#include "AllocTracker.h"
+#include "HintEngine.h"
+#include "Transcript.h"
+#include "EventStream.h"
+#include "ContentStore.h"
+#include "WorldTables.h"
+#include "TriggerTable.h"
+#include <unordered_map>
 #include <iostream>
 #include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <iterator>
+
+// Exit keys that the story keeps locked for a while; bit i of lockedExitMask() refers to entry i
+static const std::vector<std::string> kLockableExits = {"storage", "west-wing", "office"};
+
+// Changes the undo history holds (about 12 bytes each); a typical command records two to five
+static constexpr size_t kUndoRecords = 256;
+
+// Swallows prose that a typed event already covers
+static std::ostream& discardStream() {
+    thread_local std::ostream discard(nullptr);
+    return discard;
+}
+
+// The story triggers of the built-in world, indexed once; the rules never change during play
+static const TriggerTable& storyTriggers() {
+    static const TriggerTable table(kWorldTriggers, std::size(kWorldTriggers));
+    return table;
+}
+
+const char* gameStateName(GameState state) {
+    static const char* const names[] = {
+        "INTRO", "FIRST_ENCOUNTER_WITH_GUIDE",
+        "AWAITING_TASK_1", "TASK_1_COMPLETE", "AWAITING_TASK_2", "TASK_2_COMPLETE",
+        "AWAITING_TASK_3", "TASK_3_COMPLETE_FALSE_HOPE", "MENACING_TABLEAU", "AWAITING_TASK_4",
+        "VIGIL_MISTAKE", "GUIDE_FACES_VENGEANCE",
+        "CHOICE_POINT_LEAVE_OR_HELP",
+        "PLAYER_CHOOSES_LEAVE_ENDING1_PRE",
+        "PLAYER_CHOOSES_HELP_SEARCH_MEDKIT", "PLAYER_FOUND_MEDKIT", "PLAYER_RETURNS_GUIDE_UNHARMED_REVEAL",
+        "FIGURES_REVEALED",
+        "FINAL_CONFRONTATION_IMMINENT", "PLAYER_USES_SURGICAL_ITEM_ENDING2_PRE", "PLAYER_FAILS_DEFENSE_ENDING3_PRE",
+        "ENDING_NOT_WORTHY", "ENDING_GOOD_ESCAPED", "ENDING_BAD_VICTIM",
+        "GAME_OVER"
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) == static_cast<size_t>(GameState::GAME_OVER) + 1, "state names out of sync");
+    size_t index = static_cast<size_t>(state);
+    return index <= static_cast<size_t>(GameState::GAME_OVER) ? names[index] : "UNKNOWN";
+}
 
 // Constructor
-Game::Game()
+Game::Game(std::ostream& output, int typewriterDelayMs)
     : player(nullptr), // Player needs a starting room, will be set in setupGame
     guide("The Visitor Guide"),
     currentGameState(GameState::INTRO),
     gameOver(false),
-    surgicalItemSpawned(false) {
+    endingReached(GameState::INTRO),
+    startLocation(nullptr),
+    out(&output),
+    typewriterDelayMs(typewriterDelayMs),
+    surgicalItemSpawned(false),
+    isInCutscene(false),
+    cutscenesPlayed(0),
+    correctionPending(false),
+    recorder(nullptr),
+    recorderSessionId(0),
+    events(nullptr),
+    content(nullptr),
+    contentVersion(0),
+    messages(&MessageCatalog::builtIn()),
+    hints(std::make_shared<HintEngine>()),
+    undoLog(kUndoRecords),
+    recordingUndo(false),
+    undoBefore() {
         setupGame();
 }
 
+// Copy constructor
+Game::Game(const Game& other)
+    : player(other.player),
+    guide(other.guide),
+    currentGameState(other.currentGameState),
+    gameOver(other.gameOver),
+    endingReached(other.endingReached),
+    startLocation(nullptr),
+    out(other.out),
+    typewriterDelayMs(other.typewriterDelayMs),
+    surgicalItemSpawned(other.surgicalItemSpawned),
+    isInCutscene(other.isInCutscene),
+    cutscenesPlayed(other.cutscenesPlayed),
+    correctionPending(false),
+    recorder(nullptr),
+    recorderSessionId(0),
+    events(nullptr),
+    content(other.content),
+    contentVersion(other.contentVersion),
+    messages(other.messages),
+    hints(other.hints),
+    undoLog(other.undoLog.capacity()),
+    recordingUndo(false),
+    undoBefore() {
+    // Copy the rooms first, then re-aim exits and the player's location at the copies
+    std::unordered_map<const Room*, Room*> copies;
+    allRooms.reserve(other.allRooms.size());
+    for (const auto& room : other.allRooms) {
+        auto copy = std::make_unique<Room>(room->id, room->name, room->description);
+        copy->copyElementsFrom(*room);
+        copy->items.reserve(room->items.size());
+        for (const auto& item : room->items) {
+            if (item) copy->addItem(item->clone());
+        }
+        copies[room.get()] = copy.get();
+        allRooms.push_back(std::move(copy));
+    }
+    for (const auto& room : other.allRooms) {
+        Room* copy = copies[room.get()];
+        for (const auto& exit : room->exits) {
+            auto target = copies.find(exit.second);
+            copy->addExit(exit.first, target != copies.end() ? target->second : nullptr);
+        }
+    }
+    auto location = copies.find(other.player.currentLocation);
+    player.currentLocation = location != copies.end() ? location->second : nullptr;
+    auto start = copies.find(other.startLocation);
+    startLocation = start != copies.end() ? start->second : nullptr;
+
+    if (other.reservedSurgicalItem) {
+        reservedSurgicalItem = other.reservedSurgicalItem->clone();
+    }
+    for (const auto& home : other.itemHomes) {
+        itemHomes.push_back(ItemHome{home.itemId, copies[home.room]});
+    }
+    resetScratch.reserve(other.resetScratch.capacity());
+
+    navigation.build(allRooms, kLockableExits);
+}
+
+// Copy assignment
+Game& Game::operator=(const Game& other) {
+    if (this != &other) {
+        Game copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
 // Initializes game objects
 void Game::setupGame() {
     setupRoomsAndExits();
     setupItems();
     setupInteractiveElements();
     // Player needs a stating room, find it after rooms are created
-    Room* startRoom = findRoomById("car_breakdown");
+    Room* startRoom = findRoomById(std::string(kWorldRooms[kWorldStartRoom].id));
     if (!startRoom) {
         allRooms.push_back(std::make_unique<Room>("default_start", "Default Start Room", "Something went wrong, starting in a default room."));
         startRoom = allRooms[0].get();
-        std::cerr << "Error: Start room 'car_breakdown' not found. Using default." << std::endl;
+        std::cerr << "Error: Start room '" << kWorldRooms[kWorldStartRoom].id << "' not found. Using default." << std::endl;
     }
     player.currentLocation = startRoom; // Initialize player's location
+    startLocation = startRoom;
+
+    // Remember where everything starts, for reset(), and prepare the inventory to hold all of it
+    for (const auto& room : allRooms) {
+        for (const auto& item : room->items) {
+            if (!item) continue;
+            itemHomes.push_back(ItemHome{item->id, room.get()});
+            player.expectItem(*item);
+        }
+    }
+    if (reservedSurgicalItem) player.expectItem(*reservedSurgicalItem);
+    player.inventory.reserve(itemHomes.size() + 1);
+    resetScratch.reserve(itemHomes.size() + 1);
+
+    navigation.build(allRooms, kLockableExits);
+    storyTriggers(); // Index the rules now rather than during the first command
 
     setupGuide();
 
     // Initial look for the player
     if (player.currentLocation) {
-        player.currentLocation->look();
+        player.currentLocation->look(*out);
     }
 }
 
-// @brief Creates all the Room objects and links them together with exits 
+// @brief Creates all the Room objects and links them together with exits
+// The rooms and exits come from the generated world tables (see world/visitor_center.world)
 void Game::setupRoomsAndExits() {
-    // Create rooms
-    allRooms.push_back(std::make_unique<Room>("car_breakdown", "Car Breakdown Site", "Your car has sputtered to a halt beside a desolate road. The imposing Oakhaven Visitor Center is your only visible shelter."));
-    allRooms.push_back(std::make_unique<Room>("vc_entrance", "Visitor Center Entrance", "You stand at the threshold of the Oakhaven Visitor Center. The air is unnervingly still, and shadows cast by the setting sun seem to twist and writhe at the edges of your vision. It feels less like a building and more like a tomb holding its breath."));
-    allRooms.push_back(std::make_unique<Room>("main_hall", "Main Hall", "A large, dusty main hall stretches before you. Lifelike figures stand in silent watch from shadowy alcoves. An older man, the Guide, is here. He eyes you curiously. A small, ornate music box sits on a high shelf."));
-    allRooms.push_back(std::make_unique<Room>("storage_room", "Storage Room", "A cluttered storage area, filled with forgotten supplies and cobwebs. It smells of dust and decay."));
-    allRooms.push_back(std::make_unique<Room>("office", "Office", "An old, neglected office. A large wooden desk sits in the center, covered in yellowed papers. There's a filing cabinet in the corner."));
-    allRooms.push_back(std::make_unique<Room>("west_wing", "West Wing Corridor", "A dim corridor in what seems to be a less-used part of the center. The Guide mentioned investigating a noise from this direction. It feels colder here.")); 
-    allRooms.push_back(std::make_unique<Room>("reveal_spot", "Main Hall - Collection Display", "You are back in the Main Hall. The Guide stands near one of the alcoves, a strange calm about him. The figures seem more prominent now."));
-
-    // Get raw pointers for exits 
-    Room* car = findRoomById("car_breakdown");
-    Room* entrance = findRoomById("vc_entrance");
-    Room* hall = findRoomById("main_hall");
-    Room* storage = findRoomById("storage_room");
-    Room* office = findRoomById("office");
-    Room* west_wing = findRoomById("west_wing"); 
-
-    // Define exits with hyphenated keys
-    if (car && entrance) car->addExit("enter-center", entrance); 
-    if (entrance && hall && car) {
-        entrance->addExit("enter", hall); // "enter" can remain if it's a single word action into the hall
-        entrance->addExit("leave-center", car); // Or just "leave" if context is clear
-    }
-    if (hall && storage && office && west_wing && entrance) {
-        hall->addExit("storage", storage); // Assuming "storage" is a direct, single-word exit
-        hall->addExit("office", office);   // Assuming "office" is a direct, single-word exit
-        hall->addExit("west-wing", west_wing); 
-        hall->addExit("exit-center", entrance);
-    }
-    if (storage && hall) storage->addExit("hall", hall);
-    if (office && hall) office->addExit("hall", hall);
-    if (west_wing && hall) west_wing->addExit("hall", hall); 
+    allRooms.reserve(std::size(kWorldRooms));
+    for (const WorldRoom& room : kWorldRooms) {
+        allRooms.push_back(std::make_unique<Room>(std::string(room.id), std::string(message(room.name)),
+                                                  std::string(message(room.description))));
+    }
+    for (const WorldExit& exit : kWorldExits) {
+        allRooms[exit.room]->addExit(std::string(exit.key), allRooms[exit.target].get());
+    }
+}
+
+// Copies a range of the generated alias table into strings
+static std::vector<std::string> worldStrings(const std::string_view* table, uint16_t first, uint16_t count) {
+    return std::vector<std::string>(table + first, table + first + count);
+}
+
+// Looks a range of the generated stage table up in 'messages'
+static std::vector<std::string> worldStages(const MessageCatalog& messages, uint16_t first, uint16_t count) {
+    std::vector<std::string> stages;
+    stages.reserve(count);
+    for (uint16_t i = first; i < first + count; ++i) stages.emplace_back(messages.text(kWorldStages[i]));
+    return stages;
 }
 
 // @brief Creates all initial items and places them in their respective rooms 
 // Items are also managed by unique_ptr. The Room that contains an item "owns" it 
 // until the player picks it up, at which point ownership is transferred to the player.
 void Game::setupItems() {
-    // "Means to leave" items - Placed for sequential pickup
-    // Item 1: Gas Can (Storage Room)
-    Room* storage = findRoomById("storage_room");
-    if (storage) {
-        storage->addItem(std::make_unique<Item>("gas_can", "Gas Can", "A red, slightly rusted gas can. It feels like it has some fuel in it. This looks like the first thing you'll need."));
-        
-    }
-
-    Room* west_wing = findRoomById("west_wing");
-    if (west_wing) {
-        // Item 2: Spare Tire (Storage Room - will be gettable after Gas Can)
-        west_wing->addItem(std::make_unique<Item>("spare_tire", "Spare Tire", "A dusty but seemingly usable spare tire."));
-    }
-
-    // Item 3: Oil Fluid (Office - will be gettable after Spare Tire)
-    // This is also the room where the surgical_item will appear.
-    Room* office = findRoomById("office");
-    if (office) {
-        office->addItem(std::make_unique<Item>("oil_fluid", "Oil Fluid", "A sealed container of motor oil. The last piece of the puzzle for the car."));
-        // First Aid Kit - available without sequence
-        office->addItem(std::make_unique<Item>("first_aid_kit", "First Aid Kit", "A standard first aid kit. Looks relatively well-stocked."));
+    for (const WorldItem& world : kWorldItems) {
+        auto item = std::make_unique<Item>(std::string(world.id), std::string(message(world.name)), std::string(message(world.description)),
+                                           worldStrings(kWorldAliases, world.firstAlias, world.aliasCount));
+        if (world.room != kNotPlaced) {
+            allRooms[world.room]->addItem(std::move(item));
+        } else {
+            // The Surgical Defensive Item is NOT placed initially; it appears in the office when
+            // "oil_fluid" is picked up. It is created now, though, so spawning it (and resetting
+            // the game) never allocates.
+            reservedSurgicalItem = std::move(item);
+        }
     }
-
-    // Surgical Defensive Item is NOT placed here initially.
-    // It will be dynamically added to the "office" when "oil_fluid" is picked up.
 }
 
 // @brief Creates all interactive elements and places them in their rooms.
 // Interactive elements are objects in the world that have descriptions that can change as 
 // the story progresses, creating a dynamic and reactive environment.
 void Game::setupInteractiveElements() {
-    Room* hall = findRoomById("main_hall");
-    if (hall) {
-        // The Figures: Now with multiple descriptions for the scares.
-        hall->addInteractiveElement(InteractiveElement("figures", {
-            /* State 0: Initial */ "The 'exhibits' are figures depicting scenes from Oakhaven's history. From a distance, they look like wax, but up close, the detail is unnerving. The texture of the skin is too porous, the hair seems too fine, and the eyes have a glassy, wet-looking sheen that makes you want to look away.",
-            /* State 1: Scare 1 */ "You look at the figures again. Your blood runs cold. You could swear one of the heads is tilted slightly, its glassy eyes now aimed directly at the entrance to the storage room. It must be a trick of the light.",
-            /* State 2: Scare 2 */ "It's not your imagination. The figures have definitely moved. They are now clustered together, forming a menacing tableau aimed at the center of the room. Their silent judgment is suffocating.",
-            /* State 3: Revealed */ "The 'figures' are no exhibits. They are horrifyingly preserved human bodies, skin like leather, eyes fixed in a moment of past terror. The Guide's 'collection'."
-        }));
-        
-        // The Guide
-        hall->addInteractiveElement(InteractiveElement("guide", {
-            "The Visitor Guide is an older man, with eyes that dart nervously around the room. He carries the weight of this place on his shoulders, an air of profound fear about him.",
-            "The Guide's fear is gone, replaced by a triumphant, predatory smile. He is the master of this macabre gallery, the hunter who has successfully lured his prey."
-        }));
-
-        // The Music Box (Task 1 Scare)
-        hall->addInteractiveElement(InteractiveElement("music_box", {
-            "A small, ornate music box sits on a high shelf, covered in a thin layer of dust.",
-            "Shards of wood and metal litter the floor where the music box used to be. It's completely destroyed."
-        }));
-
-        // Task 1 Object
-        hall->addInteractiveElement(InteractiveElement("memorial", {
-            "A dusty memorial plaque dedicated to the 'Pioneers of Oakhaven'. It's hard to read the names under the grime.",
-            "The memorial plaque is now clean, the names of the lost gleaming faintly in the dim light."
-        }));
-    }
-
-    Room* storage = findRoomById("storage_room");
-    if (storage) {
-        storage->addInteractiveElement(InteractiveElement("archives", {
-            "A collection of dusty photo albums and records, scattered chaotically across a table.",
-            "The archives are now neatly stacked. A lingering sense of order has been restored."
-        }));
-    }
-
-    Room* west_wing = findRoomById("west_wing");
-    if (west_wing) {
-        west_wing->addInteractiveElement(InteractiveElement("garden", {
-            "Thorny, overgrown vines choke the memorial stones in the garden area, obscuring them from view.",
-            "The thorny vines have been trimmed back, revealing the names on the stones beneath."
-        }));
-    }
-
-    Room* office = findRoomById("office");
-    if(office) {
-        office->addInteractiveElement(InteractiveElement("papers", {"A stack of yellowed papers sits on the corner of the desk."}));
-        // The candle is now an interactive element in the office.
-        office->addInteractiveElement(InteractiveElement("candle", {
-            /* State 0 */ "A simple white wax candle sits on the desk, unlit. The Guide mentioned this was for the vigil.",
-            /* State 1 */ "The candle has been knocked over, its flame extinguished. A wisp of smoke curls from the wick."
-        }));
+    for (const WorldElement& element : kWorldElements) {
+        allRooms[element.room]->addInteractiveElement(InteractiveElement(std::string(element.name),
+            worldStages(*messages, element.firstStage, element.stageCount),
+            worldStrings(kWorldAliases, element.firstAlias, element.aliasCount)));
     }
-
-    
 }
 
 void Game::setupGuide() {
@@ -178,63 +255,569 @@ Room* Game::findRoomById(const std::string& roomId) {
     return nullptr;
 }
 
-void Game::typeOut(const std::string& text, bool isDialogue) {
-    if (isDialogue) std::cout << "\"";
-    for (const char c : text) {
-        std::cout << c << std::flush;
-        std::this_thread::sleep_for(std::chrono::milliseconds(35));
+// @brief Swaps in a different world, e.g. a generated one
+void Game::loadWorld(std::vector<std::unique_ptr<Room>> rooms, const std::string& startRoomId) {
+    if (rooms.empty()) return;
+    allRooms = std::move(rooms);
+    std::vector<std::unique_ptr<Item>> carried;
+    player.takeAllItems(carried);
+
+    Room* startRoom = findRoomById(startRoomId);
+    if (!startRoom) startRoom = allRooms[0].get();
+    player.currentLocation = startRoom;
+    startLocation = startRoom;
+
+    itemHomes.clear();
+    for (const auto& room : allRooms) {
+        for (const auto& item : room->items) {
+            if (item) itemHomes.push_back(ItemHome{item->id, room.get()});
+        }
     }
-    if (isDialogue) std::cout << "\"";
-    std::cout << std::endl;
+    resetScratch.clear();
+    resetScratch.reserve(itemHomes.size() + 1);
+
+    navigation.build(allRooms, kLockableExits);
+    hints = std::make_shared<HintEngine>(); // Cached hints were computed for the old world
+    undoLog.clear();
+}
+
+// @brief Returns the message for an exit that the story has not unlocked yet, or nullptr if it is open
+std::string_view Game::exitLockMessage(const std::string& exitKey) const {
+    if (exitKey == "storage" && currentGameState < GameState::TASK_1_COMPLETE) {
+        return message(MessageId::LOCKED_STORAGE);
+    }
+    if (exitKey == "west-wing" && currentGameState < GameState::AWAITING_TASK_3) {
+        return message(MessageId::LOCKED_WEST_WING);
+    }
+    if (exitKey == "office" && currentGameState < GameState::TASK_3_COMPLETE_FALSE_HOPE) {
+        return message(MessageId::LOCKED_OFFICE);
+    }
+    return std::string_view();
+}
+
+// @brief Sends all further output to another stream
+void Game::redirectOutput(std::ostream& output, int delayMs) {
+    out = &output;
+    typewriterDelayMs = delayMs;
+}
+
+// @brief Encodes the mutable state of the game into a compact byte string
+// Items only ever leave rooms for the inventory (or appear in the office), so per-room item counts
+// plus the inventory contents pin down where every item is.
+std::string Game::stateKey() const {
+    std::string key;
+    stateKey(key);
+    return key;
+}
+
+// Fills 'key' in place, so a caller that keeps the string around does not allocate
+void Game::stateKey(std::string& key) const {
+    key.clear();
+    key.reserve(16 + allRooms.size() * 2);
+    key.push_back(static_cast<char>(currentGameState));
+    key.push_back(static_cast<char>(endingReached));
+
+    int32_t room = navigation.roomIndex(player.currentLocation);
+    key.append(reinterpret_cast<const char*>(&room), sizeof(room));
+
+    uint16_t flags = 0;
+    const bool bits[] = {
+        player.hasGasCan, player.hasSpareTire, player.hasOilFluid, player.hasSurgicalDefensiveItem,
+        player.hasFirstAidKit, player.hasCleanedMemorial, player.hasOrganizedArchives, player.hasTrimmedGarden,
+        surgicalItemSpawned, guide.isFeigningInjury, gameOver
+    };
+    for (size_t i = 0; i < sizeof(bits) / sizeof(bits[0]); ++i) {
+        if (bits[i]) flags |= static_cast<uint16_t>(1u << i);
+    }
+    key.append(reinterpret_cast<const char*>(&flags), sizeof(flags));
+
+    for (const auto& roomPtr : allRooms) {
+        key.push_back(static_cast<char>(roomPtr->items.size()));
+        for (uint32_t state : roomPtr->elements.states()) {
+            key.push_back(static_cast<char>(state));
+        }
+    }
+    for (const auto& item : player.inventory) {
+        if (!item) continue;
+        key.append(item->id);
+        key.push_back('\0');
+    }
+}
+
+// Saved-state layout, all numbers varints unless noted:
+//   format byte, state byte, ending byte, flags, room count, location, cutscenes played, dialogue rng state,
+//   per room (item count, item ordinals, element states), inventory count, inventory ordinals,
+//   undo record count, per undo record (kind, slot, place, value), oldest first.
+// An item ordinal is its index in itemHomes; the surgical item, which has no home, is itemHomes.size()
+namespace {
+constexpr uint8_t kSavedStateFormat = 2;
+}
+
+// @brief Writes the changeable part of the session; the world itself comes from a fresh game on restore
+void Game::saveState(std::vector<uint8_t>& out) const {
+    auto ordinalOf = [this](const Item& item) {
+        size_t ordinal = 0;
+        while (ordinal < itemHomes.size() && itemHomes[ordinal].itemId != item.id) ++ordinal;
+        return ordinal;
+    };
+
+    out.push_back(kSavedStateFormat);
+    out.push_back(static_cast<uint8_t>(currentGameState));
+    out.push_back(static_cast<uint8_t>(endingReached));
+    uint64_t flags = 0;
+    const bool bits[] = {
+        player.hasCleanedMemorial, player.hasOrganizedArchives, player.hasTrimmedGarden,
+        guide.isFeigningInjury, gameOver
+    };
+    for (size_t i = 0; i < sizeof(bits) / sizeof(bits[0]); ++i) {
+        if (bits[i]) flags |= 1ull << i;
+    }
+    TranscriptReader::writeVarint(out, flags);
+    TranscriptReader::writeVarint(out, allRooms.size());
+    TranscriptReader::writeVarint(out, static_cast<uint64_t>(navigation.roomIndex(player.currentLocation) + 1));
+    TranscriptReader::writeVarint(out, cutscenesPlayed);
+    std::ostringstream rngState;
+    rngState << guide.rng;
+    TranscriptReader::writeVarint(out, std::stoull(rngState.str()));
+
+    for (const auto& room : allRooms) {
+        TranscriptReader::writeVarint(out, room->items.size());
+        for (const auto& item : room->items) TranscriptReader::writeVarint(out, ordinalOf(*item));
+        for (uint32_t state : room->elements.states()) TranscriptReader::writeVarint(out, state);
+    }
+    TranscriptReader::writeVarint(out, player.inventory.size());
+    for (const auto& item : player.inventory) TranscriptReader::writeVarint(out, ordinalOf(*item));
+
+    // The undo history, so a restored session can still take its commands back
+    size_t records = 0;
+    undoLog.forEachRecord([&records](const UndoRecord&) { ++records; });
+    TranscriptReader::writeVarint(out, records);
+    undoLog.forEachRecord([&out](const UndoRecord& record) {
+        TranscriptReader::writeVarint(out, static_cast<uint64_t>(record.kind));
+        TranscriptReader::writeVarint(out, record.slot);
+        TranscriptReader::writeVarint(out, record.place);
+        TranscriptReader::writeVarint(out, record.value);
+    });
+}
+
+// @brief Starts over, then moves every item and element to where the saved session had it
+bool Game::restoreState(const uint8_t* data, size_t size) {
+    reset();
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+    auto fail = [this] {
+        reset();
+        return false;
+    };
+
+    uint64_t flags = 0, roomCount = 0, location = 0, cutscenes = 0, rngState = 0;
+    if (size < 3 || *p++ != kSavedStateFormat) return fail();
+    uint8_t state = *p++;
+    uint8_t ending = *p++;
+    if (state > static_cast<uint8_t>(GameState::GAME_OVER) || ending > static_cast<uint8_t>(GameState::GAME_OVER)) return fail();
+    if (!TranscriptReader::readVarint(p, end, flags) || !TranscriptReader::readVarint(p, end, roomCount) ||
+        !TranscriptReader::readVarint(p, end, location) || !TranscriptReader::readVarint(p, end, cutscenes) ||
+        !TranscriptReader::readVarint(p, end, rngState)) {
+        return fail();
+    }
+    if (roomCount != allRooms.size() || location == 0 || location > roomCount) return fail();
+    if (((flags & 16) != 0) != (state == static_cast<uint8_t>(GameState::GAME_OVER))) return fail();
+
+    // Everything is gathered into the scratch vector (the surgical item stays in reserve) and handed out by ordinal
+    for (auto& room : allRooms) room->takeAllItems(resetScratch);
+    auto claim = [this](uint64_t ordinal) -> std::unique_ptr<Item> {
+        if (ordinal == itemHomes.size()) return std::move(reservedSurgicalItem);
+        if (ordinal > itemHomes.size()) return nullptr;
+        for (auto& item : resetScratch) {
+            if (item && item->id == itemHomes[ordinal].itemId) return std::move(item);
+        }
+        return nullptr;
+    };
+
+    for (auto& room : allRooms) {
+        uint64_t count = 0, ordinal = 0;
+        if (!TranscriptReader::readVarint(p, end, count)) return fail();
+        for (uint64_t i = 0; i < count; ++i) {
+            std::unique_ptr<Item> item = TranscriptReader::readVarint(p, end, ordinal) ? claim(ordinal) : nullptr;
+            if (!item) return fail();
+            room->addItem(std::move(item));
+        }
+        for (uint32_t e = 0; e < room->elements.size(); ++e) {
+            uint64_t stage = 0;
+            if (!TranscriptReader::readVarint(p, end, stage) || stage > UINT32_MAX ||
+                !room->elements.setState(e, static_cast<uint32_t>(stage))) {
+                return fail();
+            }
+        }
+    }
+    uint64_t carried = 0;
+    if (!TranscriptReader::readVarint(p, end, carried)) return fail();
+    std::ostream quiet(nullptr);
+    for (uint64_t i = 0; i < carried; ++i) {
+        uint64_t ordinal = 0;
+        std::unique_ptr<Item> item = TranscriptReader::readVarint(p, end, ordinal) ? claim(ordinal) : nullptr;
+        if (!item) return fail();
+        player.pickUpItem(std::move(item), quiet);
+    }
+    // Every item that was gathered must have been placed again
+    for (const auto& item : resetScratch) {
+        if (item) return fail();
+    }
+    resetScratch.clear();
+
+    uint64_t records = 0;
+    if (!TranscriptReader::readVarint(p, end, records) || records > undoLog.capacity()) return fail();
+    for (uint64_t i = 0; i < records; ++i) {
+        uint64_t kind = 0, slot = 0, place = 0, value = 0;
+        if (!TranscriptReader::readVarint(p, end, kind) || !TranscriptReader::readVarint(p, end, slot) ||
+            !TranscriptReader::readVarint(p, end, place) || !TranscriptReader::readVarint(p, end, value) ||
+            kind > static_cast<uint64_t>(UndoKind::ItemMove) || slot > UINT16_MAX || place > UINT32_MAX || value > UINT32_MAX) {
+            return fail();
+        }
+        if (static_cast<UndoKind>(kind) == UndoKind::Step) {
+            undoLog.endStep();
+        } else {
+            undoLog.push(UndoRecord{static_cast<UndoKind>(kind), static_cast<uint16_t>(slot),
+                                    static_cast<uint32_t>(place), static_cast<uint32_t>(value)});
+        }
+    }
+    if (undoLog.stepOpen() || p != end) return fail();
+
+    currentGameState = static_cast<GameState>(state);
+    endingReached = static_cast<GameState>(ending);
+    player.currentLocation = allRooms[location - 1].get();
+    player.hasCleanedMemorial = flags & 1;
+    player.hasOrganizedArchives = flags & 2;
+    player.hasTrimmedGarden = flags & 4;
+    guide.setFeigningInjury(flags & 8);
+    gameOver = flags & 16;
+    cutscenesPlayed = static_cast<size_t>(cutscenes);
+    surgicalItemSpawned = !reservedSurgicalItem;
+    std::istringstream(std::to_string(rngState)) >> guide.rng;
+    return true;
+}
+
+// @brief Starts (or with nullptr, stops) recording this session's commands
+void Game::attachRecorder(TranscriptWriter* writer, uint64_t sessionId) {
+    recorder = writer;
+    recorderSessionId = sessionId;
+}
+
+// @brief Switches this session between prose and typed events
+void Game::attachEvents(EventWriter* writer) {
+    events = writer;
+    if (writer) {
+        out = &writer->narration();
+        typewriterDelayMs = 0;
+    }
+}
+
+// @brief Follows a content store from now on
+void Game::attachContent(const ContentStore* store) {
+    content = store;
+    contentVersion = 0;
+    refreshContent();
+}
+
+// @brief Switches the narrated lines and the Guide's dialogue to 'catalog'
+void Game::attachMessages(const MessageCatalog* catalog) {
+    messages = catalog ? catalog : &MessageCatalog::builtIn();
+    guide.initializeDialogue(*messages);
+    applyWorldText();
+}
+
+// @brief Rooms are matched to their table rows by id, so a loaded world keeps its own text. Items are
+// taken out and put back in the same order, so their translated names are indexed as nouns too
+void Game::applyWorldText() {
+    auto isBuiltIn = [this](size_t room) {
+        return room < allRooms.size() && room < std::size(kWorldRooms) && allRooms[room]->id == kWorldRooms[room].id;
+    };
+    for (size_t i = 0; i < allRooms.size(); ++i) {
+        if (!isBuiltIn(i)) continue;
+        allRooms[i]->setText(std::string(message(kWorldRooms[i].name)), std::string(message(kWorldRooms[i].description)));
+    }
+    for (const WorldElement& element : kWorldElements) {
+        if (!isBuiltIn(element.room)) continue;
+        Room& room = *allRooms[element.room];
+        int index = room.elements.find(std::string(element.name));
+        if (index >= 0) room.elements.setDescriptions(static_cast<uint32_t>(index), worldStages(*messages, element.firstStage, element.stageCount));
+    }
+
+    auto translate = [this](Item& item) {
+        for (const WorldItem& world : kWorldItems) {
+            if (item.id != world.id) continue;
+            item.name = message(world.name);
+            item.description = message(world.description);
+            item.addAlias(item.name);
+            player.expectItem(item);
+            return;
+        }
+    };
+    for (auto& room : allRooms) {
+        room->takeAllItems(resetScratch);
+        for (auto& item : resetScratch) {
+            translate(*item);
+            room->addItem(std::move(item));
+        }
+        resetScratch.clear();
+    }
+    player.takeAllItems(resetScratch);
+    for (auto& item : resetScratch) {
+        translate(*item);
+        player.pickUpItem(std::move(item), discardStream());
+    }
+    resetScratch.clear();
+    if (reservedSurgicalItem) translate(*reservedSurgicalItem);
+}
+
+// @brief The only read of shared content on the command path is one atomic load of the version
+void Game::refreshContent() {
+    if (!content || content->version() == contentVersion) return;
+    ContentStore::ReadGuard snapshot(*content);
+    applyContent(*snapshot);
+    contentVersion = snapshot->version;
+}
+
+// @brief Overwrites this session's copies of the text. Rooms and elements the snapshot doesn't
+// know (e.g. in a generated world) keep their text; element states are kept, clamped to the new stages
+void Game::applyContent(const ContentSnapshot& snapshot) {
+    std::string key;
+    for (auto& room : allRooms) {
+        auto text = snapshot.rooms.find(room->id);
+        if (text != snapshot.rooms.end()) {
+            room->setText(text->second.name, text->second.description);
+        }
+        for (uint32_t e = 0; e < room->elements.size(); ++e) {
+            key.assign(room->id).append("/").append(room->elements.name(e));
+            auto stages = snapshot.elementStages.find(key);
+            if (stages == snapshot.elementStages.end() || stages->second.empty()) continue;
+            room->elements.setDescriptions(e, stages->second);
+        }
+    }
+    guide.dialogueLines = snapshot.dialogueLines;
+    guide.commandExplanations = snapshot.commandExplanations;
+}
+
+// @brief Restores the initial state in place
+void Game::reset() {
+    // Gather every item from wherever it ended up. Vectors keep their capacity, so nothing is allocated
+    for (auto& room : allRooms) {
+        room->takeAllItems(resetScratch);
+        room->elements.resetStates();
+    }
+    player.takeAllItems(resetScratch);
+    if (reservedSurgicalItem) {
+        resetScratch.push_back(std::move(reservedSurgicalItem));
+    }
+
+    // Put each item back in its starting room, in the original order
+    for (const auto& home : itemHomes) {
+        for (auto& item : resetScratch) {
+            if (item && item->id == home.itemId) {
+                home.room->addItem(std::move(item));
+                break;
+            }
+        }
+    }
+    // Whatever is left was spawned during play (the surgical item); hold it back again
+    for (auto& item : resetScratch) {
+        if (item && !reservedSurgicalItem) reservedSurgicalItem = std::move(item);
+    }
+    resetScratch.clear();
+
+    player.currentLocation = startLocation;
+    player.hasGasCan = false;
+    player.hasSpareTire = false;
+    player.hasOilFluid = false;
+    player.hasSurgicalDefensiveItem = false;
+    player.hasFirstAidKit = false;
+    player.hasCleanedMemorial = false;
+    player.hasOrganizedArchives = false;
+    player.hasTrimmedGarden = false;
+
+    guide.setFeigningInjury(false);
+
+    currentGameState = GameState::INTRO;
+    gameOver = false;
+    endingReached = GameState::INTRO;
+    surgicalItemSpawned = false;
+    isInCutscene = false;
+    cutscenesPlayed = 0;
+    undoLog.clear();
+}
+
+// @brief Checks that no item was duplicated or lost and that derived flags agree with the world
+bool Game::checkInvariants(std::string* problem) const {
+    auto fail = [problem](const std::string& message) {
+        if (problem) *problem = message;
+        return false;
+    };
+
+    std::vector<const Item*> seen;
+    auto track = [&seen](const Item* item) {
+        for (const Item* other : seen) {
+            if (other == item) return false;
+            if (other->id == item->id) return false;
+        }
+        seen.push_back(item);
+        return true;
+    };
+
+    bool locationValid = false;
+    for (const auto& room : allRooms) {
+        if (room.get() == player.currentLocation) locationValid = true;
+        for (const auto& item : room->items) {
+            if (!item) return fail("null item in room '" + room->id + "'");
+            if (!track(item.get())) return fail("item '" + item->id + "' is duplicated (found again in '" + room->id + "')");
+        }
+        const ElementTable& elements = room->elements;
+        for (uint32_t e = 0; e < elements.size(); ++e) {
+            if (elements.stageCount(e) > 0 && elements.state(e) >= elements.stageCount(e)) {
+                return fail("element '" + elements.name(e) + "' has an out-of-range state");
+            }
+        }
+        for (const auto& exit : room->exits) {
+            if (!exit.second) return fail("exit '" + exit.first + "' in '" + room->id + "' leads nowhere");
+        }
+    }
+    if (!locationValid) return fail("player is not in any room of this game");
+
+    // The noun indexes must agree with the containers
+    for (const auto& room : allRooms) {
+        for (const auto& item : room->items) {
+            if (!room->getItem(item->id)) return fail("item '" + item->id + "' is missing from the index of '" + room->id + "'");
+        }
+    }
+    for (const auto& item : player.inventory) {
+        if (item && !player.getItemFromInventory(item->id)) return fail("item '" + item->id + "' is missing from the inventory index");
+    }
+
+    for (const auto& item : player.inventory) {
+        if (!item) return fail("null item in inventory");
+        if (!track(item.get())) return fail("item '" + item->id + "' is duplicated (found again in inventory)");
+    }
+    if (reservedSurgicalItem && !track(reservedSurgicalItem.get())) {
+        return fail("reserved surgical item is duplicated");
+    }
+    if (seen.size() != itemHomes.size() + 1) {
+        return fail("expected " + std::to_string(itemHomes.size() + 1) + " items but found " + std::to_string(seen.size()));
+    }
+    if (surgicalItemSpawned == static_cast<bool>(reservedSurgicalItem)) {
+        return fail("surgicalItemSpawned disagrees with where the surgical item is");
+    }
+
+    const std::pair<const char*, bool> flags[] = {
+        {"gas_can", player.hasGasCan}, {"spare_tire", player.hasSpareTire}, {"oil_fluid", player.hasOilFluid},
+        {"surgical_item", player.hasSurgicalDefensiveItem}, {"first_aid_kit", player.hasFirstAidKit}
+    };
+    for (const auto& flag : flags) {
+        if (flag.second != (player.getItemFromInventory(flag.first) != nullptr)) {
+            return fail(std::string("inventory flag for '") + flag.first + "' disagrees with the inventory");
+        }
+    }
+    if (gameOver != (currentGameState == GameState::GAME_OVER)) {
+        return fail("gameOver disagrees with the current state");
+    }
+    return true;
+}
+
+// @brief Asks the hint engine for the next useful command
+const std::string& Game::suggestNextAction() {
+    if (hints) hints->nextAction(*this, hintScratch);
+    else hintScratch.clear();
+    return hintScratch;
+}
+
+// @brief Collects which lockable exits are currently closed, for routing around them
+uint32_t Game::lockedExitMask() const {
+    uint32_t mask = 0;
+    for (size_t i = 0; i < kLockableExits.size(); ++i) {
+        if (!exitLockMessage(kLockableExits[i]).empty()) mask |= 1u << i;
+    }
+    return mask;
+}
+
+void Game::typeOut(std::string_view text, bool isDialogue) {
+    TRACE_SCOPE("typeOut");
+    if (events) {
+        // All spoken lines belong to the Guide
+        if (isDialogue) events->dialogue(guide.name, text);
+        else events->cutsceneLine(text);
+        return;
+    }
+    if (isDialogue) *out << "\"";
+    if (typewriterDelayMs <= 0) {
+        *out << text;
+    } else {
+        for (const char c : text) {
+            *out << c << std::flush;
+            std::this_thread::sleep_for(std::chrono::milliseconds(typewriterDelayMs));
+        }
+    }
+    if (isDialogue) *out << "\"";
+    *out << std::endl;
+}
+
+void Game::typeGuideHeading(bool spaced) {
+    headingScratch.assign(spaced ? "\n--- " : "--- ").append(guide.name).append(" ---");
+    typeOut(headingScratch);
 }
 
 void Game::enterCutscene() {
     isInCutscene = true;
-    std::cout << "\n";
+    ++cutscenesPlayed;
+    *out << "\n";
 }
 
 void Game::exitCutscene() {
     isInCutscene = false;
 }
 
+void Game::describeLocation() {
+    if (!player.currentLocation) return;
+    if (events) events->roomView(*player.currentLocation);
+    else player.currentLocation->look(*out);
+}
+
 void Game::displayIntro() {
     enterCutscene();
-    std::cout << "----------------------------------------------------------" << std::endl;
-    typeOut("           THE VISITOR CENTER");
-    std::cout << "----------------------------------------------------------" << std::endl;
+    *out << "----------------------------------------------------------" << std::endl;
+    typeOut(message(MessageId::INTRO_TITLE));
+    *out << "----------------------------------------------------------" << std::endl;
     
-    typeOut("Your heart pounds with anxiety. Racing to your gravely ill mother, your chosen shortcut has led to disaster.");
-    typeOut("Your car sputters and dies near the Oakhaven Visitor Center – an isolated, dilapidated structure exuding an unnerving stillness.");
-    typeOut("Miles from anywhere, with a failing phone signal, the Center is your only hope.");
+    typeOut(message(MessageId::INTRO_1));
+    typeOut(message(MessageId::INTRO_2));
+    typeOut(message(MessageId::INTRO_3));
     exitCutscene();
     
     // Player's location look() is now called from moveTo, which is called from setupGame
-    if (player.currentLocation) {
-        player.currentLocation->look();
-    }
+    describeLocation();
     transitionToState(GameState::INTRO);
 }
 
 // @brief The main state transition handler. This is the heart of the game's narrative logic
 // When the game needs to move to a new narrative beat, this function is called.
 void Game::transitionToState(GameState newState) {
+    TRACE_SCOPE("transitionToState");
+    GameState previousState = currentGameState;
     currentGameState = newState;
+    if (events && previousState != newState) events->stateTransition(previousState, newState);
 
     // Specific actions on entering a new state
     switch (newState) {
         case GameState::FIRST_ENCOUNTER_WITH_GUIDE:
             enterCutscene();
-            typeOut("--- " + guide.name + " ---", false);
+            typeGuideHeading();
             typeOut(guide.getDialogue(currentGameState), true);
-            typeOut("\n(A thought crosses your mind: This man is clearly unwell... but he's my only way out of here. I'll play along.)");
-            typeOut("\nYou should probably talk to him again to see what he wants you to do.");
+            typeOut(message(MessageId::FIRST_ENCOUNTER_1));
+            typeOut(message(MessageId::FIRST_ENCOUNTER_2));
             exitCutscene();
             transitionToState(GameState::AWAITING_TASK_1);
             break;
         
         case GameState::GUIDE_FACES_VENGEANCE:
             enterCutscene();
-            typeOut("--- " + guide.name + " ---", false);
+            typeGuideHeading();
             typeOut(guide.getDialogue(currentGameState), true);
             exitCutscene();
             transitionToState(GameState::CHOICE_POINT_LEAVE_OR_HELP);
@@ -242,42 +825,42 @@ void Game::transitionToState(GameState newState) {
         case GameState::TASK_1_COMPLETE:
             {
                 enterCutscene();
-                typeOut("As you finish, a sudden, loud CRASH from across the hall makes you jump.");
-                typeOut("The small music box has fallen from its shelf, shattering on the floorboards.");
-                typeOut("Your heart hammers against your ribs. It must have been precariously balanced. It had to be.");
+                typeOut(message(MessageId::TASK_1_COMPLETE_1));
+                typeOut(message(MessageId::TASK_1_COMPLETE_2));
+                typeOut(message(MessageId::TASK_1_COMPLETE_3));
                 
-                InteractiveElement* musicBox = player.currentLocation->getInteractiveElement("music_box");
-                if (musicBox) musicBox->advanceState();
+                ElementRef musicBox = player.currentLocation->getInteractiveElement("music_box");
+                if (musicBox) advanceElement(*player.currentLocation, musicBox);
 
-                typeOut("\n--- " + guide.name + " ---", false);
-                typeOut("He flinches at the sound, his face pale. 'A good sign,' he whispers, though he sounds anything but convinced. 'The spirits... they noticed. The storage room should be unlocked now. The gas can should be in there.'");
+                typeGuideHeading(true);
+                typeOut(message(MessageId::TASK_1_COMPLETE_GUIDE));
                 exitCutscene();
             }
             break;
         case GameState::VIGIL_MISTAKE:
             enterCutscene();
-            typeOut("You use a lighter from your pocket to light the candle. For a moment, a solemn quiet fills the room.");
-            typeOut("Then, a sudden tremor shakes the building! You stumble, knocking the desk. The candle topples, instantly extinguished against the floor.");
-            typeOut("--- " + guide.name + " ---", false);
+            typeOut(message(MessageId::VIGIL_MISTAKE_1));
+            typeOut(message(MessageId::VIGIL_MISTAKE_2));
+            typeGuideHeading();
             typeOut(guide.getDialogue(currentGameState), true);
-            typeOut("He flees the office, and you hear the sounds of a horrific attack begin in the main hall.");
+            typeOut(message(MessageId::VIGIL_MISTAKE_3));
             exitCutscene();
             transitionToState(GameState::CHOICE_POINT_LEAVE_OR_HELP);
             break;
         case GameState::CHOICE_POINT_LEAVE_OR_HELP:
             enterCutscene();
-            typeOut("\nWith the sounds of the attack echoing from the other room, your mind races. Your mother... waiting.");
-            typeOut("But you caused this. You feel the weight of your mistake, the chilling belief that you have doomed him.");
-            typeOut("You have all the parts to fix your car. Your choice is stark and immediate: will you 'leave' or 'assist' him?");
+            typeOut(message(MessageId::CHOICE_POINT_1));
+            typeOut(message(MessageId::CHOICE_POINT_2));
+            typeOut(message(MessageId::CHOICE_POINT_3));
             exitCutscene();
             break;
 
         case GameState::PLAYER_RETURNS_GUIDE_UNHARMED_REVEAL:
             enterCutscene();
             guide.setFeigningInjury(false); 
-            typeOut("You burst back into the main hall, First Aid Kit in hand, to find... silence.");
-            typeOut("The Guide stands there, completely unharmed, a strange, calm smile on his face.");
-            typeOut("\n--- " + guide.name + " ---", false);
+            typeOut(message(MessageId::UNHARMED_REVEAL_1));
+            typeOut(message(MessageId::UNHARMED_REVEAL_2));
+            typeGuideHeading(true);
             typeOut(guide.getDialogue(currentGameState), true);
             exitCutscene();
             transitionToState(GameState::FIGURES_REVEALED);
@@ -286,10 +869,10 @@ void Game::transitionToState(GameState newState) {
         case GameState::FIGURES_REVEALED:
             enterCutscene();
             if (player.currentLocation) {
-                if (InteractiveElement* figures = player.currentLocation->getInteractiveElement("figures")) figures->advanceState(3);
+                if (ElementRef figures = player.currentLocation->getInteractiveElement("figures")) advanceElement(*player.currentLocation, figures, 3);
             }
-            typeOut("He gestures to the figures, their true nature now horrifyingly apparent in the dim light.");
-            typeOut("\n--- " + guide.name + " ---", false);
+            typeOut(message(MessageId::FIGURES_REVEALED_1));
+            typeGuideHeading(true);
             typeOut(guide.getDialogue(currentGameState), true);
             exitCutscene();
             transitionToState(GameState::FINAL_CONFRONTATION_IMMINENT);
@@ -297,17 +880,17 @@ void Game::transitionToState(GameState newState) {
 
         case GameState::FINAL_CONFRONTATION_IMMINENT:
             enterCutscene();
-            typeOut("\n--- " + guide.name + " ---", false);
+            typeGuideHeading(true);
             typeOut(guide.getDialogue(currentGameState), true);
-            typeOut("\nHe lunges towards you!");
+            typeOut(message(MessageId::CONFRONTATION_1));
 
             // This logic automatically determines the ending
             if (player.hasItem("surgical_item")) {
-                typeOut("In the split-second before he's on you, your mind races, and a memory flashes: the glint of metal from the office. The surgical instrument. It's your only chance.");
-                typeOut("You reach into your pocket, and your hand closes around the cool, hard steel of the surgical instrument in your pocket.");
+                typeOut(message(MessageId::CONFRONTATION_ARMED_1));
+                typeOut(message(MessageId::CONFRONTATION_ARMED_2));
                 transitionToState(GameState::ENDING_GOOD_ESCAPED);
             } else {
-                typeOut("You desperately search your pockets for a weapon, but find nothing.");
+                typeOut(message(MessageId::CONFRONTATION_UNARMED));
                 transitionToState(GameState::ENDING_BAD_VICTIM);
             }
 
@@ -329,52 +912,60 @@ void Game::displayEnding(GameState endingType) {
     enterCutscene();
     switch (endingType) {
         case GameState::ENDING_NOT_WORTHY:
-            typeOut("\n--- ENDING 1: The Unworthy ---");
-            typeOut("The image of your mother, pale and still in a hospital bed, burns in your mind. Guilt is a hot stone in your gut, but the primal need to reach your family is a tidal wave that washes it all away.");
-            typeOut("You don't look back. You fix the car in a frenzy, your hands shaking, and peel away from the curb, leaving the screams and the Visitor Center behind.");
-            typeOut("As you flee, a single, clear whisper, no longer weak or afraid, seems to follow you on the wind, a final, chilling judgment:");
-            typeOut("--- " + guide.name + " ---", false);
+            typeOut(message(MessageId::ENDING_NOT_WORTHY_1));
+            typeOut(message(MessageId::ENDING_NOT_WORTHY_2));
+            typeOut(message(MessageId::ENDING_NOT_WORTHY_3));
+            typeOut(message(MessageId::ENDING_NOT_WORTHY_4));
+            typeGuideHeading();
             typeOut(guide.getDialogue(endingType), true);
-            typeOut("You escape, but the word is a brand on your soul.");
+            typeOut(message(MessageId::ENDING_NOT_WORTHY_5));
             break;
         case GameState::ENDING_GOOD_ESCAPED:
-            typeOut("\n--- ENDING 2: The Escape ---");
-            typeOut("With a desperate surge of adrenaline, you plunge the sharp instrument into his chest!");
-            typeOut("The Guide recoils with a look of genuine shock, giving you the single moment you need.");
-            typeOut("You scramble past him and out of the horrific gallery, not daring to look back, the image of his collection burned into your memory.");
-            typeOut("Forever scarred, you carry the weight of Oakhaven, but also a desperate hope as you race towards your mother, a survivor.");
+            typeOut(message(MessageId::ENDING_GOOD_ESCAPED_1));
+            typeOut(message(MessageId::ENDING_GOOD_ESCAPED_2));
+            typeOut(message(MessageId::ENDING_GOOD_ESCAPED_3));
+            typeOut(message(MessageId::ENDING_GOOD_ESCAPED_4));
+            typeOut(message(MessageId::ENDING_GOOD_ESCAPED_5));
             break;
         case GameState::ENDING_BAD_VICTIM:
-            typeOut("\n--- ENDING 3: The Collection ---");
-            typeOut("You fumble for a defense, but with his earlier frailty gone, the Guide is too quick.");
-            typeOut("His triumphant smile is the last thing you see.");
-            typeOut("\n--- " + guide.name + " ---", false);
+            typeOut(message(MessageId::ENDING_BAD_VICTIM_1));
+            typeOut(message(MessageId::ENDING_BAD_VICTIM_2));
+            typeOut(message(MessageId::ENDING_BAD_VICTIM_3));
+            typeGuideHeading(true);
             typeOut(guide.getDialogue(endingType), true);
-            typeOut("The Oakhaven Visitor Center has claimed another exhibit. Far away, a hospital vigil continues, unaware of why their loved one never arrived.");
+            typeOut(message(MessageId::ENDING_BAD_VICTIM_4));
             break;
         default:
             typeOut("Error: Unknown ending type.");
             break;
     }
     exitCutscene();
+    endingReached = endingType;
     gameOver = true;
     currentGameState = GameState::GAME_OVER;
+    if (events) {
+        events->ending(endingType);
+        events->stateTransition(endingType, GameState::GAME_OVER);
+    }
 }
 
 // Main game loop
 void Game::run() {
+    refreshContent();
     displayIntro();
     std::string inputLine;
 
     while (!gameOver) {
         if (currentGameState == GameState::GAME_OVER) break;
 
-        if (!isInCutscene) {
-            std::cout << "\n";
+        if (!isInCutscene && events) {
+            events->prompt(*this);
+        } else if (!isInCutscene) {
+            *out << "\n";
             if (player.currentLocation) {
-                std::cout << "[" << player.currentLocation->name <<"] > ";
+                *out << "[" << player.currentLocation->name <<"] > ";
             } else {
-                std::cout << "[Unknown location] > ";
+                *out << "[Unknown location] > ";
             }
         }
         
@@ -388,225 +979,527 @@ void Game::run() {
 
         processInput(inputLine);
         updateGame();
+
+        // An ending can still be taken back; offer that once before leaving the loop. Bots get a
+        // prompt event and leave with any command other than undo
+        if (gameOver && endingReached != GameState::INTRO && undoLog.steps() > 0) {
+            if (events) {
+                events->prompt(*this);
+            } else {
+                *out << "\n(Type 'undo' to take back your last move, or press Enter to finish.) > ";
+            }
+            if (std::getline(std::cin, inputLine)) {
+                parseCommand(inputLine, inputWords);
+                if (!inputWords.empty() && verbFromWord(inputWords[0]) == Verb::Undo) processInput(inputLine);
+            }
+        }
+    }
+
+    *out << "\n--- Thank you for playing The Visitor Center! ---" << std::endl;
+    if (events) events->flush();
+}
+
+// @brief Parses the raw input string from the user into command words. Strings left in 'words' by
+// the last command are overwritten in place, so their buffers are reused
+void Game::parseCommand(const std::string& rawInput, std::vector<std::string>& words) {
+    ALLOC_SCOPE("parseCommand");
+    auto isSpace = [](char c) { return std::isspace(static_cast<unsigned char>(c)) != 0; };
+    // Same lowering as addNounForms; bytes of UTF-8 sequences pass through unchanged
+    auto toLower = [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); };
+    size_t count = 0;
+    size_t i = 0;
+    while (i < rawInput.size()) {
+        if (isSpace(rawInput[i])) {
+            ++i;
+            continue;
+        }
+        size_t start = i;
+        while (i < rawInput.size() && !isSpace(rawInput[i])) ++i;
+        if (count == words.size()) words.emplace_back();
+        std::string& word = words[count++];
+        word.assign(rawInput, start, i - start);
+        std::transform(word.begin(), word.end(), word.begin(), toLower);
     }
+    words.resize(count);
+}
 
-    std::cout << "\n--- Thank you for playing The Visitor Center! ---" << std::endl;
+// @brief Joins the words after the verb, skipping a leading "the", so multi-word names resolve
+std::string Game::nounFrom(const std::vector<std::string>& words, size_t count) {
+    size_t first = 1;
+    if (words.size() > 2 && words[1] == "the") first = 2;
+    size_t last = words.size() - first > count ? first + count : words.size();
+    std::string noun;
+    for (size_t i = first; i < last; ++i) {
+        if (i > first) noun.push_back(' ');
+        noun += words[i];
+    }
+    return noun;
 }
 
-// @brief Parses the raw input string from the user into a vector of command words 
-std::vector<std::string> Game::parseCommand(const std::string& rawInput) {
-    std::vector<std::string> words;
-    std::string input = rawInput;
-    std::transform(input.begin(), input.end(), input.begin(), ::tolower);
-    std::stringstream ss(input);
-    std::string word;
-    while (ss >> word) {
-        words.push_back(word);
+// @brief Tries the whole phrase first and drops trailing words until something answers to it, so
+// "get gas_can now" still finds the can while "examine gas can" keeps its two-word name
+std::string Game::resolveNounFor(const Player& actor, const std::vector<std::string>& words, bool takeOnly) {
+    Room* room = actor.currentLocation;
+    std::string noun;
+    for (size_t count = words.size(); count > 0; --count) {
+        noun = nounFrom(words, count);
+        if (noun.empty()) break;
+        if (takeOnly) {
+            if (room && room->getItem(noun)) return noun;
+            continue;
+        }
+        if (actor.getItemFromInventory(noun)) return noun;
+        if (room) {
+            NounMatch here = room->resolveNoun(noun);
+            if (here.item || here.element) return noun;
+        }
     }
-    return words;
+    return nounFrom(words, 1);
+}
+
+// @brief Replaces a misspelled verb or noun with its closest known match
+bool Game::autoCorrect(std::vector<std::string>& words, const Player& actor) {
+    ALLOC_SCOPE("autoCorrect");
+    bool corrected = false;
+    Verb verb = verbFromWord(words[0]);
+    if (verb == Verb::Unknown) {
+        if (const std::string* fix = closestVerbWord(words[0])) {
+            words[0] = *fix;
+            verb = verbFromWord(*fix);
+            corrected = true;
+        }
+    }
+
+    Room* room = actor.currentLocation;
+    if (words.size() >= 2 && room) {
+        FuzzyMatch match;
+        switch (verb) {
+            case Verb::Go:
+                if (!room->exits.count(words[1])) room->fuzzyMatchExit(words[1], match);
+                break;
+            case Verb::Examine: {
+                std::string noun = resolveNounFor(actor, words, false);
+                NounMatch here = room->resolveNoun(noun);
+                if (!here.item && !here.element && !actor.getItemFromInventory(noun)) {
+                    room->fuzzyMatchNoun(noun, false, match);
+                    actor.fuzzyMatchItem(noun, match);
+                }
+                break;
+            }
+            case Verb::Get: {
+                std::string noun = resolveNounFor(actor, words, true);
+                if (!room->getItem(noun)) room->fuzzyMatchNoun(noun, true, match);
+                break;
+            }
+            default:
+                break;
+        }
+        if (match.found()) {
+            words.resize(2);
+            words[1] = *match.word;
+            corrected = true;
+        }
+    }
+
+    return corrected;
+}
+
+void Game::describeCorrection(const std::vector<std::string>& words, std::ostream& os) {
+    os << "(Assuming you meant '";
+    for (size_t i = 0; i < words.size(); ++i) {
+        os << (i > 0 ? " " : "") << words[i];
+    }
+    os << "'.)" << std::endl;
 }
 
 void Game::processInput(const std::string& rawInput) {
-    if (gameOver) return;
+    TRACE_SCOPE("processInput");
+    ALLOC_SCOPE("processInput");
+    if (gameOver && undoLog.steps() == 0) return;
+    refreshContent();
 
-    std::vector<std::string> words = parseCommand(rawInput);
+    if (rawInput.find(';') != std::string::npos) {
+        processBatch(rawInput);
+        return;
+    }
+
+    std::vector<std::string>& words = inputWords;
+    parseCommand(rawInput, words);
     if (words.empty()) return;
+    // Once the game is over, only an exactly typed 'undo' is still accepted
+    if (gameOver && verbFromWord(words[0]) != Verb::Undo) return;
+    correctionPending = autoCorrect(words, player);
+
+    // Every command except undo itself becomes one undo step
+    bool undoing = verbFromWord(words[0]) == Verb::Undo;
+    if (!undoing) beginUndoStep();
+    runCommand(words);
+    if (!undoing) endUndoStep();
+}
 
-    std::string command = words[0];
-    std::cout << "\n==================================================================\n";
-
-    if (command == "quit") {
-        std::cout << "Exiting game." << std::endl;
-        gameOver = true;
-        currentGameState = GameState::GAME_OVER;
-    } else if (command == "go" || command == "move") {
-        handleGoCommand(words);
-    } else if (command == "look" || command == "l") {
-        handleLookCommand(words);
-    } else if (command == "examine" || command == "x" || command == "inspect") {
-        handleExamineCommand(words);
-    } else if (command == "get" || command == "take" || command == "pickup") {
-        handleGetCommand(words);
-    } else if (command == "inventory" || command == "i" || command == "inv") {
-        handleInventoryCommand(words);
-    } else if (command == "talk") {
-        handleTalkCommand(words);
-    } else if (command == "help" || command == "?") {
-        handleHelpCommand(words);
-    } else if (command == "use") {
-        handleUseCommand(words);
-    } else if (command == "clean") {
-        handleCleanCommand(words);
-    } else if (command == "organize") {
-        handleOrganizeCommand(words);
-    } else if (command == "trim") {
-        handleTrimCommand(words);
-    } else if (command == "leave" || command == "assist") { // Simplified choice commands
-        if (currentGameState == GameState::CHOICE_POINT_LEAVE_OR_HELP) {
-             handleChooseCommand({command}); // Pass the command directly
-        } else {
-            std::cout << "You can't do that right now." << std::endl;
+void Game::runCommand(const std::vector<std::string>& words) {
+    if (!recorder) {
+        executeCommand(words);
+        return;
+    }
+
+    uint64_t nowMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    recorder->record(recorderSessionId, nowMs, currentGameState, words);
+
+    GameState endingBefore = endingReached;
+    executeCommand(words);
+    if (!recorder || endingReached == endingBefore) return;
+    // Only undo moves the ending back to INTRO
+    if (endingReached != GameState::INTRO) {
+        recorder->recordEnding(recorderSessionId, nowMs, endingReached);
+    } else {
+        recorder->recordEndingUndone(recorderSessionId, nowMs, currentGameState);
+    }
+}
+
+// Verbs that are expected to change the game. In a batch, one that changes nothing (a locked door,
+// an item that isn't there, a task that isn't due) counts as failed and ends the batch
+static bool verbActs(Verb verb) {
+    switch (verb) {
+        case Verb::Go: case Verb::Travel: case Verb::Get: case Verb::Use: case Verb::Clean:
+        case Verb::Organize: case Verb::Trim: case Verb::Leave: case Verb::Assist: case Verb::Quit:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// @brief Runs "go hall; talk to guide; go storage" in one go. The commands share one content version
+// and one undo step, and their output is collected and written at the end, so a scripted client gets
+// a single response. The batch stops after a command that fails or starts a cutscene, and names the
+// commands it skipped
+void Game::processBatch(const std::string& rawInput) {
+    TRACE_SCOPE("processBatch");
+    if (gameOver) return;
+
+    std::ostream* target = out;
+    int delayMs = typewriterDelayMs;
+    std::ostringstream collected;
+    if (!events) {
+        out = &collected;
+        typewriterDelayMs = 0;
+    }
+
+    beginUndoStep();
+    std::string command;
+    size_t start = 0;
+    while (start <= rawInput.size() && !gameOver) {
+        size_t segment = start;
+        size_t end = std::min(rawInput.find(';', start), rawInput.size());
+        command.assign(rawInput, start, end - start);
+        start = end + 1;
+
+        std::vector<std::string>& words = inputWords;
+        parseCommand(command, words);
+        if (words.empty()) continue;
+        correctionPending = autoCorrect(words, player);
+
+        Verb verb = verbFromWord(words[0]);
+        if (verb == Verb::Undo) {
+            *out << "\n'undo' can't be part of a batch." << std::endl;
+            start = segment; // Report it as skipped
+            break;
+        }
+        GameState stateBefore = currentGameState;
+        uint16_t flagsBefore = undoFlags();
+        const Room* locationBefore = player.currentLocation;
+        uint64_t inventoryBefore = player.inventoryRevision;
+        size_t cutscenesBefore = cutscenesPlayed;
+
+        runCommand(words);
+
+        bool changed = currentGameState != stateBefore || undoFlags() != flagsBefore ||
+            player.currentLocation != locationBefore || player.inventoryRevision != inventoryBefore;
+        if (cutscenesPlayed != cutscenesBefore || verb == Verb::Unknown || (verbActs(verb) && !changed)) break;
+    }
+    endUndoStep();
+
+    // Whatever did not run is listed, so the client can resend it once the story allows
+    if (start < rawInput.size() && !gameOver) {
+        size_t first = rawInput.find_first_not_of(" \t;", start);
+        if (first != std::string::npos) {
+            *out << "\n(Batch stopped; not run: " << rawInput.substr(first) << ")" << std::endl;
         }
     }
-     else {
-        std::cout << "Unknown command. Type 'help' for options." << std::endl;
+
+    if (!events) {
+        out = target;
+        typewriterDelayMs = delayMs;
+        *out << collected.str() << std::flush;
+    }
+}
+
+// Dispatches a tokenized command to its handler
+void Game::executeCommand(const std::vector<std::string>& words) {
+    if (words.empty()) return;
+
+    const std::string& command = words[0];
+    Verb verb = verbFromWord(command);
+    bool corrected = correctionPending;
+    correctionPending = false;
+    if (gameOver && verb != Verb::Undo) return;
+    if (!events) *out << "\n==================================================================\n";
+    if (corrected) describeCorrection(words, *out);
+
+    ALLOC_SCOPE(verbName(verb)); // Attributes what the handler allocates to its verb
+    switch (verb) {
+        case Verb::Quit:
+            *out << "Exiting game." << std::endl;
+            gameOver = true;
+            if (events) events->stateTransition(currentGameState, GameState::GAME_OVER);
+            currentGameState = GameState::GAME_OVER;
+            break;
+        case Verb::Go: handleGoCommand(words); break;
+        case Verb::Look: handleLookCommand(words); break;
+        case Verb::Examine: handleExamineCommand(words); break;
+        case Verb::Get: handleGetCommand(words); break;
+        case Verb::Inventory: handleInventoryCommand(words); break;
+        case Verb::Talk: handleTalkCommand(words); break;
+        case Verb::Help: handleHelpCommand(words); break;
+        case Verb::Use: handleUseCommand(words); break;
+        case Verb::Clean: handleCleanCommand(words); break;
+        case Verb::Organize: handleOrganizeCommand(words); break;
+        case Verb::Trim: handleTrimCommand(words); break;
+        case Verb::Travel: handleTravelCommand(words); break;
+        case Verb::Hint: handleHintCommand(words); break;
+        case Verb::Ack: handleAckCommand(words); break;
+        case Verb::Undo: handleUndoCommand(words); break;
+        case Verb::Leave:
+        case Verb::Assist: // Simplified choice commands
+            if (currentGameState == GameState::CHOICE_POINT_LEAVE_OR_HELP) {
+                handleChooseCommand({command}); // Pass the command directly
+            } else {
+                *out << "You can't do that right now." << std::endl;
+            }
+            break;
+        default:
+            *out << "Unknown command. Type 'help' for options." << std::endl;
+            break;
     }
 }
 
 // Command handlers 
 void Game::handleGoCommand(const std::vector<std::string>& words) {
+    TRACE_SCOPE("handleGoCommand");
     if (words.size() < 2) {
-        std::cout << "Go where?" << std::endl;
+        *out << "Go where?" << std::endl;
         return;
     }
-    std::string destination_key = words[1];
+    if (Room* nextRoom = walk(player, words[1], *out)) {
+        onPlayerEntered(nextRoom);
+    }
+}
 
+// @brief Moves 'actor' through an exit of their room, printing the new room (or why they can't go)
+Room* Game::walk(Player& actor, const std::string& destination_key, std::ostream& os) {
     // Room Unlocking Logic
-    if (destination_key == "storage" && currentGameState < GameState::TASK_1_COMPLETE) {
-        std::cout << "The door is securely locked." << std::endl;
-        return; 
-    }
-    if (destination_key == "west-wing" && currentGameState < GameState::AWAITING_TASK_3) {
-        std::cout << "That part of the center is sealed off." << std::endl;
-        return;
-    }
-    if (destination_key == "office" && currentGameState < GameState::TASK_3_COMPLETE_FALSE_HOPE) {
-        std::cout << "The Guide's office is securely locked." << std::endl;
-        return;
+    std::string_view lockMessage = exitLockMessage(destination_key);
+    if (!lockMessage.empty()) {
+        os << lockMessage << std::endl;
+        return nullptr;
     }
 
-    if (player.currentLocation && player.currentLocation->exits.count(destination_key)) {
-        Room* nextRoom = player.currentLocation->exits[destination_key];
-        player.moveTo(nextRoom);
-
-        if (nextRoom && nextRoom->id == "main_hall" && currentGameState == GameState::INTRO) {
-            transitionToState(GameState::FIRST_ENCOUNTER_WITH_GUIDE);
-        } else if (currentGameState == GameState::TASK_2_COMPLETE) {
-                InteractiveElement* figures = nextRoom->getInteractiveElement("figures");
-                if (figures && figures->currentState == 0) {
-                    figures->advanceState();
-                    enterCutscene();
-                    typeOut("You re-enter the main hall. A chill crawls up your spine. Something feels... wrong. The figures that were originally facing forward are suddenly looking directly at you!");
-                    typeOut("(My heart is pounding. Did... did they just move? No. It's just my mind playing tricks on me. It has to be.)");
-                    exitCutscene();
-                }
-            }
-            else if (currentGameState == GameState::MENACING_TABLEAU) {
-                 InteractiveElement* figures = nextRoom->getInteractiveElement("figures");
-                if (figures && figures->currentState == 1) {
-                    figures->advanceState(); // Advance to Scare 2 description
-                    enterCutscene();
-                    typeOut("You step back into the hall and the sight before you steals the air from your lungs.");
-                    typeOut("It's not your imagination. The figures have moved. They are now clustered together in the center of the room, a silent, menacing jury. Their glassy eyes are all fixed on you.");
-                    typeOut("The Guide looks at them, his face a mask of pure terror.");
-                    exitCutscene();
-                }
-            }
-        else if (nextRoom && nextRoom->id == "main_hall" && currentGameState == GameState::PLAYER_FOUND_MEDKIT) {
-             transitionToState(GameState::PLAYER_RETURNS_GUIDE_UNHARMED_REVEAL);
-        }
-    } else {
-        std::cout << "You can't go '" << destination_key << "' from here." << std::endl;
+    if (actor.currentLocation && actor.currentLocation->exits.count(destination_key)) {
+        Room* nextRoom = actor.currentLocation->exits[destination_key];
+        actor.moveTo(nextRoom, events ? discardStream() : os);
+        if (events && nextRoom) events->roomView(*nextRoom);
+        return nextRoom;
     }
+    os << "You can't go '" << destination_key << "' from here." << std::endl;
+    return nullptr;
+}
+
+// @brief True if someone entering 'room' right now sets off a story beat (see onPlayerEntered)
+bool Game::entryTriggerPending(const Room* room) const {
+    return room && triggerPending(TriggerEvent::Enter, *room, std::string_view());
+}
+
+// @brief Story beats that play when a player walks into a room
+void Game::onPlayerEntered(Room* nextRoom) {
+    if (nextRoom) fireTriggers(TriggerEvent::Enter, *nextRoom, std::string_view());
 }
 
 void Game::handleLookCommand([[maybe_unused]] const std::vector<std::string>& words) {
-    if (player.currentLocation) {
-        player.currentLocation->look();
-        if (player.currentLocation->id == "main_hall" && currentGameState <= GameState::AWAITING_TASK_3) {
-            std::cout << "The Guide watches you, a faint, unreadable expression on his face." << std::endl;
+    TRACE_SCOPE("handleLookCommand");
+    lookAround(player, *out);
+}
+
+// @brief Describes the room 'actor' is in
+void Game::lookAround(const Player& actor, std::ostream& os) const {
+    if (actor.currentLocation) {
+        if (events) events->roomView(*actor.currentLocation);
+        else actor.currentLocation->look(os);
+        if (actor.currentLocation->id == "main_hall" && currentGameState <= GameState::AWAITING_TASK_3) {
+            os << message(MessageId::GUIDE_WATCHES) << std::endl;
         }
     } else {
-        std::cout << "You are nowhere in particular. This is odd." << std::endl;
+        os << "You are nowhere in particular. This is odd." << std::endl;
     }
 }
 
 void Game::handleExamineCommand(const std::vector<std::string>& words) {
+    TRACE_SCOPE("handleExamineCommand");
+    examineFor(player, words, *out);
+}
+
+// @brief Examines something in the room of 'actor' or in their inventory
+void Game::examineFor(const Player& actor, const std::vector<std::string>& words, std::ostream& os) const {
     if (words.size() < 2) {
-        std::cout << "Examine what?" << std::endl;
+        os << "Examine what?" << std::endl;
         return;
     }
-    std::string targetName = words[1];
-    if (targetName == "the" && words.size() > 2) {
-        targetName = words[2];
-    }
+    std::string targetName = resolveNounFor(actor, words, false);
 
-    if (player.currentLocation) {
-        Item* roomItem = player.currentLocation->getItem(targetName);
-        if (roomItem) { roomItem->examine(); return; }
-        
-        InteractiveElement* element = player.currentLocation->getInteractiveElement(targetName);
-        if (element) {
-            element->examine();
-            return;
-        }
+    // Items and elements share the room's noun index, so one lookup finds either
+    if (actor.currentLocation) {
+        NounMatch match = actor.currentLocation->resolveNoun(targetName);
+        if (match.item) { match.item->examine(os); return; }
+        if (match.element) { match.element.examine(os); return; }
     }
     
-    Item* invItem = player.getItemFromInventory(targetName);
-    if (invItem) { invItem->examine(); return; }
+    Item* invItem = actor.getItemFromInventory(targetName);
+    if (invItem) { invItem->examine(os); return; }
 
     if (targetName == "guide") {
-        if (player.currentLocation->getInteractiveElement("guide")) {
-            player.currentLocation->getInteractiveElement("guide")->examine();
-        } else {
-            std::cout << "The Guide isn't here." << std::endl;
-        }
+        os << "The Guide isn't here." << std::endl;
         return;
     }
 
-    std::cout << "You don't see any '" << targetName << "' here to examine, nor are you carrying it." << std::endl;
+    os << "You don't see any '" << targetName << "' here to examine, nor are you carrying it." << std::endl;
 }
 
 void Game::handleGetCommand(const std::vector<std::string>& words) {
-    if (words.size() < 2) { std::cout << "Get what?" << std::endl; return; }
-    std::string itemId = words[1];
+    TRACE_SCOPE("handleGetCommand");
+    if (words.size() < 2) { *out << "Get what?" << std::endl; return; }
+    if (Item* item = take(player, resolveNounFor(player, words, true), *out)) {
+        onItemTaken(player.currentLocation, *item);
+    }
+}
 
-    if (player.currentLocation && player.currentLocation->getItem(itemId)) {
-        std::unique_ptr<Item> item = player.currentLocation->removeItem(itemId);
-        
-        if (item->id == "gas_can" && currentGameState == GameState::TASK_1_COMPLETE) {
-            enterCutscene();
-            typeOut("You found the gas can. Now that you have the first part for your car, you should talk to the Guide to see what's next.");
-            exitCutscene();
-            transitionToState(GameState::AWAITING_TASK_2); // Prepares the game for the next task's dialogue.
-        }
+// @brief Moves an item from the room of 'actor' into their inventory. Returns it, or nullptr if it isn't there
+Item* Game::take(Player& actor, const std::string& noun, std::ostream& os) {
+    Room* room = actor.currentLocation;
+    // Where the item stood in the room, so undo can put it back in the same place
+    size_t position = 0;
+    if (recordingUndo && room) {
+        const Item* target = room->getItem(noun);
+        while (position < room->items.size() && room->items[position].get() != target) ++position;
+    }
 
-        if (item->id == "oil_fluid" && !surgicalItemSpawned) {
-             Room* officeRoom = findRoomById("office");
-             if(officeRoom) {
-                officeRoom->addItem(std::make_unique<Item>("surgical_item", "Surgical Instrument", "An antique surgical instrument, surprisingly well-maintained. It was tucked away near where the oil was. Almost... waiting."));
-                surgicalItemSpawned = true;
+    std::unique_ptr<Item> item = room ? room->removeItem(noun) : nullptr;
+    if (!item) {
+        os << "You don't see any '" << noun << "' here." << std::endl;
+        return nullptr;
+    }
+    Item* taken = item.get();
+    if (events) events->itemPicked(*item);
+    actor.pickUpItem(std::move(item), events ? discardStream() : os);
+    if (&actor == &player) {
+        recordChange(UndoRecord{UndoKind::ItemMove, static_cast<uint16_t>(position),
+                                static_cast<uint32_t>(navigation.roomIndex(room)), UndoLog::kInventory});
+    }
+    return taken;
+}
+
+// @brief True if taking 'item' in 'room' right now sets off a story beat (see onItemTaken)
+bool Game::itemTriggerPending(const Room* room, const Item& item) const {
+    return room && triggerPending(TriggerEvent::Take, *room, item.id);
+}
+
+// @brief Story beats that play when a player picks up a key item in 'room'
+void Game::onItemTaken(Room* room, const Item& item) {
+    if (room) fireTriggers(TriggerEvent::Take, *room, item.id);
+}
+
+// @brief True if some rule for 'event' would fire in 'room' now. Rules that need the player to carry
+// the subject are counted without checking, since CoopGame asks before the acting player is swapped in
+bool Game::triggerPending(TriggerEvent event, const Room& room, std::string_view subject) const {
+    bool pending = false;
+    storyTriggers().forEachCandidate(event, room.id, subject, currentGameState, [&](const WorldTrigger& rule) {
+        pending = triggerConditionsHold(rule, room, false);
+        return !pending;
+    });
+    return pending;
+}
+
+// @brief Runs every rule for 'event' whose conditions hold, in the order the world defines them.
+// Each rule is checked just before it runs, so one rule can rule out a later one. Returns true if any ran
+bool Game::fireTriggers(TriggerEvent event, Room& room, std::string_view subject) {
+    bool fired = false;
+    storyTriggers().forEachCandidate(event, room.id, subject, currentGameState, [&](const WorldTrigger& rule) {
+        if (!triggerConditionsHold(rule, room, true)) return true;
+        runTrigger(rule, room);
+        fired = true;
+        return !gameOver;
+    });
+    return fired;
+}
+
+// @brief True if the 'if' conditions of 'rule' hold in 'room'. 'carried' is about the player, so it is only
+// checked when 'checkCarried' is set
+bool Game::triggerConditionsHold(const WorldTrigger& rule, const Room& room, bool checkCarried) const {
+    if (!rule.element.empty()) {
+        int element = room.elements.find(std::string(rule.element));
+        if (element < 0 || room.elements.state(static_cast<uint32_t>(element)) != rule.elementStage) return false;
+    }
+    if (rule.needsUnspawned && surgicalItemSpawned) return false;
+    return !rule.needsCarried || !checkCarried || player.hasItem(std::string(rule.subject));
+}
+
+// @brief Runs the steps of 'rule'. Consecutive lines are told as one cutscene; a step that cannot
+// happen in this world (a missing element or room) ends the rule there
+void Game::runTrigger(const WorldTrigger& rule, Room& room) {
+    const WorldTriggerStep* steps = kWorldTriggerSteps + rule.firstStep;
+    for (size_t i = 0; i < rule.stepCount; ++i) {
+        const WorldTriggerStep& step = steps[i];
+        switch (step.action) {
+            case TriggerAction::Say:
                 enterCutscene();
-                typeOut("As you pick up the oil, a glint of metal from a shadowy corner catches your eye.");
+                typeOut(message(step.message));
+                while (i + 1 < rule.stepCount && steps[i + 1].action == TriggerAction::Say) typeOut(message(steps[++i].message));
                 exitCutscene();
-             }
-        }
-        
-        if(item->id == "first_aid_kit" && currentGameState == GameState::PLAYER_CHOOSES_HELP_SEARCH_MEDKIT) {
-            transitionToState(GameState::PLAYER_FOUND_MEDKIT);
-            enterCutscene();
-            typeOut("You have the First Aid Kit. You should return to the Guide in the main hall.");
-            exitCutscene();
+                break;
+            case TriggerAction::State:
+                transitionToState(step.state);
+                break;
+            case TriggerAction::Advance: {
+                int element = room.elements.find(std::string(step.text));
+                if (element < 0) return;
+                advanceElement(room, room.elements.ref(static_cast<uint32_t>(element)), step.stage);
+                break;
+            }
+            case TriggerAction::Spawn: {
+                Room* target = findRoomById(std::string(step.text));
+                if (!target || !reservedSurgicalItem) return;
+                target->addItem(std::move(reservedSurgicalItem));
+                surgicalItemSpawned = true;
+                recordChange(UndoRecord{UndoKind::ItemMove, 0, UndoLog::kReserve, static_cast<uint32_t>(navigation.roomIndex(target))});
+                break;
+            }
         }
-
-        player.pickUpItem(std::move(item));
-    } else {
-        std::cout << "You don't see any '" << itemId << "' here." << std::endl;
     }
 }
 
 void Game::handleInventoryCommand([[maybe_unused]] const std::vector<std::string>& words) {
-    player.showInventory();
+    TRACE_SCOPE("handleInventoryCommand");
+    player.showInventory(*out);
 }
 
 void Game::handleTalkCommand(const std::vector<std::string>& words) {
+    TRACE_SCOPE("handleTalkCommand");
     if ((words.size() > 2 && (words[1] == "to" || words[1] == "with") && words[2] == "guide") ||
         (words.size() > 1 && words[1] == "guide")) {
         if (player.currentLocation && player.currentLocation->id == "main_hall") {
             if (currentGameState == GameState::TASK_2_COMPLETE) {
                 enterCutscene();
-                typeOut("--- " + guide.name + " ---", false);
-                typeOut("You saw it too, didn't you? The figures moving... It's getting worse. The spirits are more agitated than ever. There is one final act. A memorial garden in the West Wing has become overgrown. If you 'trim' it, that might be the show of respect we need to finally calm them. The oil fluid you need is in my office. Please, this might be our last chance.", true);
+                typeGuideHeading();
+                typeOut(message(MessageId::TALK_FIGURES_MOVED), true);
                 exitCutscene();
                 transitionToState(GameState::AWAITING_TASK_3);
                 return;
@@ -614,100 +1507,89 @@ void Game::handleTalkCommand(const std::vector<std::string>& words) {
             // "False Hope" dialogue after Task 3
             if (currentGameState == GameState::TASK_3_COMPLETE_FALSE_HOPE) {
                 enterCutscene();
-                typeOut("--- " + guide.name + " ---", false);
-                typeOut("It's quiet... too quiet. I think... I think we've done it. The air feels lighter. Thank you. Truly. My office is now unlocked. The oil fluid is in there. Get it, and you can finally leave this dreadful place.", true);
-                typeOut("(A wave of relief washes over you. It's finally over. You just need to get the last part and you can go home.)");
+                typeGuideHeading();
+                typeOut(message(MessageId::TALK_FALSE_HOPE), true);
+                typeOut(message(MessageId::TALK_FALSE_HOPE_THOUGHT));
                 exitCutscene();
                 transitionToState(GameState::MENACING_TABLEAU); // Set up the next trigger
                 return;
             }
             if (currentGameState == GameState::MENACING_TABLEAU) {
-                enterCutscene(); typeOut("--- " + guide.name + " ---", false);
+                enterCutscene(); typeGuideHeading();
                 typeOut(guide.getDialogue(GameState::AWAITING_TASK_4), true);
                 exitCutscene(); transitionToState(GameState::AWAITING_TASK_4); return;
             }
             
             // Default dialogue
             enterCutscene();
-            typeOut("--- " + guide.name + " ---", false);
-            std::string dialogue = guide.getDialogue(currentGameState);
+            typeGuideHeading();
+            const std::string& dialogue = guide.getDialogue(currentGameState);
             typeOut(dialogue, true);
             
             // Special player thought for intro
             if (currentGameState == GameState::AWAITING_TASK_1) {
-                typeOut("(You think to yourself: This is ridiculous. What kind of superstitious hocus-pocus is this? Whatever. I have no time to argue with him.)");
+                typeOut(message(MessageId::TALK_TASK_1_THOUGHT));
             }
 
             exitCutscene();
 
         } else {
-            std::cout << "The Guide is not here." << std::endl;
+            *out << "The Guide is not here." << std::endl;
         }
     }
     else {
-        std::cout << "Talk to whom? (e.g., 'talk to guide')" << std::endl;
+        *out << "Talk to whom? (e.g., 'talk to guide')" << std::endl;
     }
 }
 
 void Game::handleHelpCommand(const std::vector<std::string>& words) {
+    TRACE_SCOPE("handleHelpCommand");
     if (currentGameState == GameState::CHOICE_POINT_LEAVE_OR_HELP) {
-        std::cout << "\n--- Help ---" << std::endl;
-        std::cout << "The choice is yours. You can 'leave' to save yourself, or you can be a good person and 'assist' me." << std::endl;
-        std::cout << "------------------------------------------" << std::endl;
+        *out << "\n--- Help ---" << std::endl;
+        *out << message(MessageId::CHOICE_HELP) << std::endl;
+        *out << "------------------------------------------" << std::endl;
         return;
     }
     if (words.size() > 1) {
-        guide.provideHelp(words[1], currentGameState);
+        guide.provideHelp(words[1], currentGameState, *out);
     } else {
-        guide.provideHelp("general", currentGameState);
+        guide.provideHelp("general", currentGameState, *out, suggestNextAction());
     }
 }
 
+void Game::handleHintCommand([[maybe_unused]] const std::vector<std::string>& words) {
+    TRACE_SCOPE("handleHintCommand");
+    guide.giveHint(suggestNextAction(), currentGameState, *out);
+}
+
 void Game::handleUseCommand(const std::vector<std::string>& words) {
-    if (words.size() < 2) { std::cout << "Use what?" << std::endl; return; }
+    TRACE_SCOPE("handleUseCommand");
+    if (words.size() < 2) { *out << "Use what?" << std::endl; return; }
     std::string targetId = words[1];
 
-    // --- Logic for using the Candle Interactive Element ---
-    if (targetId == "candle") {
-        if (currentGameState == GameState::AWAITING_TASK_4 && player.currentLocation->id == "office") {
-            if (InteractiveElement* candle = player.currentLocation->getInteractiveElement("candle")) {
-                candle->advanceState(); // Show it's been used/knocked over
-                transitionToState(GameState::VIGIL_MISTAKE);
-                return; // Interaction handled
-            }
-        } else {
-            std::cout << "Now doesn't seem like the right time or place to use the candle." << std::endl;
-            return;
-        }
-    }
+    // Story uses (the vigil, the gas can demo) come from the world's triggers
+    if (player.currentLocation && fireTriggers(TriggerEvent::Use, *player.currentLocation, targetId)) return;
 
     if (!player.hasItem(targetId)) {
-        std::cout << "You don't have a '" << targetId << "' to use." << std::endl;
-        return;
-    }
-    
-    // --- DEMO of how cutscenes will work for tasks ---
-    if (targetId == "gas_can" && currentGameState == GameState::AWAITING_TASK_1) {
-        transitionToState(GameState::TASK_1_COMPLETE);
-        enterCutscene();
-        typeOut("This isn't how it works. The Guide asked you to perform an act of respect, not just use an item.");
-        typeOut("Perhaps you should 'examine' the 'figures' to know what to do.");
-        exitCutscene();
-        // Set state back for demonstration purposes
-        transitionToState(GameState::AWAITING_TASK_1);
+        if (storyTriggers().usedInPlace(targetId)) {
+            *out << "Now doesn't seem like the right time or place to use the " << targetId << "." << std::endl;
+        } else {
+            *out << "You don't have a '" << targetId << "' to use." << std::endl;
+        }
         return;
     }
 
-    std::cout << "You try to use the " << targetId << ", but nothing specific happens." << std::endl;
+    *out << "You try to use the " << targetId << ", but nothing specific happens." << std::endl;
 }
 
 void Game::handleChooseCommand(const std::vector<std::string>& words) {
+    TRACE_SCOPE("handleChooseCommand");
     if (currentGameState != GameState::CHOICE_POINT_LEAVE_OR_HELP) {
-        std::cout << "There's no specific choice to make right now with that command." << std::endl;
+        *out << "There's no specific choice to make right now with that command." << std::endl;
         return;
     }
     if (words.empty()) {
-        std::cout << "Choose what? ('leave' or 'assist')" << std::endl;
+        *out << "Choose what? ('leave' or 'assist')" << std::endl;
         return;
     }
     std::string choice = words[0];
@@ -715,21 +1597,22 @@ void Game::handleChooseCommand(const std::vector<std::string>& words) {
         transitionToState(GameState::ENDING_NOT_WORTHY);
     } else if (choice == "assist") {
         enterCutscene();
-        typeOut("Overcome with guilt, you decide you can't leave him. You have to do something. You remember seeing a First Aid Kit in the office.");
+        typeOut(message(MessageId::CHOOSE_ASSIST));
         exitCutscene();
         transitionToState(GameState::PLAYER_CHOOSES_HELP_SEARCH_MEDKIT);
     } else {
-        std::cout << "That's not a valid choice here. Try 'leave' or 'assist'." << std::endl;
+        *out << "That's not a valid choice here. Try 'leave' or 'assist'." << std::endl;
     }
 }
 
 void Game::handleCleanCommand(const std::vector<std::string>& words) {
+    TRACE_SCOPE("handleCleanCommand");
     if (words.size() < 2 || words[1] != "memorial") {
-        std::cout << "Clean what? (Perhaps you should 'clean memorial'?)" << std::endl;
+        *out << "Clean what? (Perhaps you should 'clean memorial'?)" << std::endl;
         return;
     }
     if (player.currentLocation->id != "main_hall") {
-        std::cout << "There is no memorial to clean here." << std::endl;
+        *out << "There is no memorial to clean here." << std::endl;
         return; 
     }
     if (currentGameState == GameState::AWAITING_TASK_1) {
@@ -737,75 +1620,279 @@ void Game::handleCleanCommand(const std::vector<std::string>& words) {
             player.hasCleanedMemorial = true;
 
             // Update the memorial's description to be clean
-            InteractiveElement* memorial = player.currentLocation->getInteractiveElement("memorial");
+            ElementRef memorial = player.currentLocation->getInteractiveElement("memorial");
             if (memorial) {
-                memorial->advanceState();
+                advanceElement(*player.currentLocation, memorial);
             }
 
-            std::cout << "You carefully wipe the dust and grime from the memorial plaque. It's a small gesture, but it feels significant." << std::endl;
+            *out << message(MessageId::CLEAN_MEMORIAL) << std::endl;
             transitionToState(GameState::TASK_1_COMPLETE);
         } else {
-            std::cout << "You've already cleaned the memorial." << std::endl;
+            *out << message(MessageId::ALREADY_CLEANED_MEMORIAL) << std::endl;
         }
     } else {
-        std::cout << "That doesn't seem necessary right now." << std::endl; 
+        *out << "That doesn't seem necessary right now." << std::endl; 
     }
 }
 
 void Game::handleOrganizeCommand(const std::vector<std::string>& words) {
+    TRACE_SCOPE("handleOrganizeCommand");
     if (words.size() < 2 || words[1] != "archives") {
-        std::cout << "Organize what? (Perhaps 'organize archives'?)" << std::endl;
+        *out << "Organize what? (Perhaps 'organize archives'?)" << std::endl;
         return; 
     }
     if (player.currentLocation->id != "storage_room") {
-        std::cout << "There are no archives to organize here." << std::endl; 
+        *out << "There are no archives to organize here." << std::endl; 
         return;
     }
     if (currentGameState == GameState::AWAITING_TASK_2) {
         if (!player.hasOrganizedArchives) {
             player.hasOrganizedArchives = true;
-            InteractiveElement* archives = player.currentLocation->getInteractiveElement("archives");
-            if (archives) archives->advanceState();
+            ElementRef archives = player.currentLocation->getInteractiveElement("archives");
+            if (archives) advanceElement(*player.currentLocation, archives);
 
             enterCutscene();
-            typeOut("You spend a few minutes stacking the old photo albums and papers into neat piles. The room feels a little less chaotic now.");
-            typeOut("You should return to the Guide in the main hall.");
+            typeOut(message(MessageId::ORGANIZE_ARCHIVES));
+            typeOut(message(MessageId::RETURN_TO_GUIDE));
             exitCutscene();
             transitionToState(GameState::TASK_2_COMPLETE);
         } else {
-            std::cout << "You've already organized the archives." << std::endl;
+            *out << message(MessageId::ALREADY_ORGANIZED_ARCHIVES) << std::endl;
         }
     } else {
-        std::cout << "That doesn't seem necessary right now." << std::endl;
+        *out << "That doesn't seem necessary right now." << std::endl;
     }
 }
 
 void Game::handleTrimCommand(const std::vector<std::string>& words) {
+    TRACE_SCOPE("handleTrimCommand");
     if (words.size() < 2 || words[1] != "garden") {
-        std::cout << "Trim what? (Perhaps 'trim garden'?)" << std::endl;
+        *out << "Trim what? (Perhaps 'trim garden'?)" << std::endl;
         return;
     }
     if (player.currentLocation->id != "west_wing") {
-        std::cout << "There is no garden to trim here." << std::endl;
+        *out << "There is no garden to trim here." << std::endl;
         return; 
     }
     if (currentGameState == GameState::AWAITING_TASK_3) {
         if (!player.hasTrimmedGarden) {
             player.hasTrimmedGarden = true;
-            InteractiveElement* garden = player.currentLocation->getInteractiveElement("garden");
-            if (garden) garden->advanceState();
+            ElementRef garden = player.currentLocation->getInteractiveElement("garden");
+            if (garden) advanceElement(*player.currentLocation, garden);
             
             enterCutscene();
-            typeOut("You carefully trim back the thorny vines, revealing the names on the memorial stones. A profound sadness seems to lift from the area.");
-            typeOut("You should return to the Guide in the main hall.");
+            typeOut(message(MessageId::TRIM_GARDEN));
+            typeOut(message(MessageId::RETURN_TO_GUIDE));
             exitCutscene();
             transitionToState(GameState::TASK_3_COMPLETE_FALSE_HOPE);
         } else {
-            std::cout << "You've already trimmed the garden." << std::endl;
+            *out << message(MessageId::ALREADY_TRIMMED_GARDEN) << std::endl;
         }
     } else {
-        std::cout << "That doesn't seem necessary right now." << std::endl; 
+        *out << "That doesn't seem necessary right now." << std::endl; 
+    }
+}
+
+// @brief Walks towards a room along the precomputed shortest route, one exit at a time
+// Each hop is a walk() followed by onPlayerEntered(), the same steps as handleGoCommand, so locks and
+// story triggers behave exactly as if the player had typed every 'go'. The journey stops early if a
+// cutscene or state change interrupts it.
+void Game::handleTravelCommand(const std::vector<std::string>& words) {
+    TRACE_SCOPE("handleTravelCommand");
+    if (words.size() < 2) {
+        *out << "Travel where? (e.g., 'travel office')" << std::endl;
+        return;
+    }
+    int target = navigation.roomIndex(words[1]);
+    if (target < 0) {
+        *out << "You don't know of any place called '" << words[1] << "'." << std::endl;
+        return;
+    }
+    if (navigation.roomIndex(player.currentLocation) == target) {
+        *out << "You're already there." << std::endl;
+        return;
+    }
+
+    for (size_t hop = 0; hop < navigation.roomCount(); ++hop) {
+        const std::string* exitKey = navigation.nextExit(player.currentLocation, target, lockedExitMask());
+        if (!exitKey) {
+            if (navigation.nextExit(player.currentLocation, target, 0)) {
+                *out << "The way there is still locked." << std::endl;
+            } else {
+                *out << "You can't find a way to get there from here." << std::endl;
+            }
+            return;
+        }
+
+        GameState stateBefore = currentGameState;
+        size_t cutscenesBefore = cutscenesPlayed;
+        if (Room* nextRoom = walk(player, *exitKey, *out)) onPlayerEntered(nextRoom);
+
+        if (navigation.roomIndex(player.currentLocation) == target || gameOver) return;
+        if (currentGameState != stateBefore || cutscenesPlayed != cutscenesBefore) {
+            *out << "\n(Your journey is interrupted.)" << std::endl;
+            return;
+        }
+    }
+}
+
+// @brief Confirms that a delta-syncing client has applied a version. Succeeds silently
+void Game::handleAckCommand(const std::vector<std::string>& words) {
+    if (!events || !events->deltasEnabled()) {
+        *out << "There is nothing to acknowledge." << std::endl;
+        return;
+    }
+    uint64_t version = 0;
+    const char* first = words.size() > 1 ? words[1].data() : nullptr;
+    const char* last = words.size() > 1 ? words[1].data() + words[1].size() : nullptr;
+    if (!first || std::from_chars(first, last, version).ptr != last) {
+        *out << "Acknowledge which version? (e.g., 'ack 3')" << std::endl;
+        return;
+    }
+    if (!events->acknowledge(version)) {
+        *out << "Version " << version << " is not the latest." << std::endl;
+    }
+}
+
+// @brief Takes back the last command that changed something, or the last N ('undo 3')
+void Game::handleUndoCommand(const std::vector<std::string>& words) {
+    TRACE_SCOPE("handleUndoCommand");
+    size_t wanted = 1;
+    if (words.size() > 1) {
+        const char* first = words[1].data();
+        const char* last = first + words[1].size();
+        if (std::from_chars(first, last, wanted).ptr != last || wanted == 0) {
+            *out << "Undo how many commands? (e.g., 'undo 2')" << std::endl;
+            return;
+        }
+    }
+    if (undoLog.steps() == 0) {
+        *out << "There is nothing to undo." << std::endl;
+        return;
+    }
+
+    GameState stateBefore = currentGameState;
+    size_t undone = 0;
+    while (undone < wanted && undoLog.undoStep([this](const UndoRecord& change) { revertChange(change); })) {
+        ++undone;
+    }
+    if (undone == 1) *out << "You take back your last command." << std::endl;
+    else *out << "You take back your last " << undone << " commands." << std::endl;
+    if (events && currentGameState != stateBefore) events->stateTransition(stateBefore, currentGameState);
+    describeLocation();
+}
+
+size_t Game::undoDepth() const {
+    return undoLog.steps();
+}
+
+void Game::beginUndoStep() {
+    undoBefore = UndoScalars{currentGameState, endingReached, undoFlags(), navigation.roomIndex(player.currentLocation), cutscenesPlayed};
+    recordingUndo = true;
+}
+
+// @brief Records the scalars the command changed and closes its step. Item moves and element
+// stages were recorded as they happened
+void Game::endUndoStep() {
+    recordingUndo = false;
+    if (currentGameState != undoBefore.state || endingReached != undoBefore.ending) {
+        undoLog.push(UndoRecord{UndoKind::State, static_cast<uint16_t>(undoBefore.ending), 0,
+                                static_cast<uint32_t>(undoBefore.state)});
+    }
+    if (undoFlags() != undoBefore.flags) {
+        undoLog.push(UndoRecord{UndoKind::Flags, 0, 0, undoBefore.flags});
+    }
+    if (navigation.roomIndex(player.currentLocation) != undoBefore.location) {
+        undoLog.push(UndoRecord{UndoKind::Location, 0, 0, static_cast<uint32_t>(undoBefore.location)});
+    }
+    // A cutscene on its own (e.g. talking to the Guide) changes nothing worth taking back
+    if (cutscenesPlayed != undoBefore.cutscenes && undoLog.stepOpen()) {
+        undoLog.push(UndoRecord{UndoKind::Cutscenes, 0, 0, static_cast<uint32_t>(undoBefore.cutscenes)});
+    }
+    undoLog.endStep();
+}
+
+void Game::recordChange(const UndoRecord& change) {
+    if (recordingUndo) undoLog.push(change);
+}
+
+// @brief Applies the inverse of one change. Changes are reverted newest first, so an item that was
+// moved is always the last one at its destination
+void Game::revertChange(const UndoRecord& change) {
+    switch (change.kind) {
+        case UndoKind::State:
+            currentGameState = static_cast<GameState>(change.value);
+            endingReached = static_cast<GameState>(change.slot);
+            break;
+        case UndoKind::Flags:
+            restoreUndoFlags(static_cast<uint16_t>(change.value));
+            break;
+        case UndoKind::Location:
+            player.currentLocation = change.value < allRooms.size() ? allRooms[change.value].get() : nullptr;
+            break;
+        case UndoKind::Cutscenes:
+            cutscenesPlayed = change.value;
+            break;
+        case UndoKind::Element:
+            if (change.place < allRooms.size()) allRooms[change.place]->elements.setState(change.slot, change.value);
+            break;
+        case UndoKind::ItemMove: {
+            std::unique_ptr<Item> item;
+            if (change.value == UndoLog::kInventory) {
+                if (!player.inventory.empty()) item = player.dropItem(player.inventory.back()->id, discardStream());
+            } else if (change.value < allRooms.size()) {
+                Room& room = *allRooms[change.value];
+                if (!room.items.empty()) item = room.removeItem(room.items.back()->id);
+            }
+            if (!item) break;
+            if (change.place == UndoLog::kReserve) {
+                reservedSurgicalItem = std::move(item);
+            } else if (change.place == UndoLog::kInventory) {
+                player.pickUpItem(std::move(item), discardStream());
+            } else if (change.place < allRooms.size()) {
+                allRooms[change.place]->insertItem(std::move(item), change.slot);
+            }
+            break;
+        }
+        case UndoKind::Step:
+            break;
+    }
+}
+
+uint16_t Game::undoFlags() const {
+    const bool bits[] = {
+        player.hasGasCan, player.hasSpareTire, player.hasOilFluid, player.hasSurgicalDefensiveItem,
+        player.hasFirstAidKit, player.hasCleanedMemorial, player.hasOrganizedArchives, player.hasTrimmedGarden,
+        surgicalItemSpawned, guide.isFeigningInjury, gameOver
+    };
+    uint16_t flags = 0;
+    for (size_t i = 0; i < sizeof(bits) / sizeof(bits[0]); ++i) {
+        if (bits[i]) flags |= static_cast<uint16_t>(1u << i);
+    }
+    return flags;
+}
+
+void Game::restoreUndoFlags(uint16_t flags) {
+    player.hasGasCan = flags & (1u << 0);
+    player.hasSpareTire = flags & (1u << 1);
+    player.hasOilFluid = flags & (1u << 2);
+    player.hasSurgicalDefensiveItem = flags & (1u << 3);
+    player.hasFirstAidKit = flags & (1u << 4);
+    player.hasCleanedMemorial = flags & (1u << 5);
+    player.hasOrganizedArchives = flags & (1u << 6);
+    player.hasTrimmedGarden = flags & (1u << 7);
+    surgicalItemSpawned = flags & (1u << 8);
+    guide.setFeigningInjury(flags & (1u << 9));
+    gameOver = flags & (1u << 10);
+}
+
+void Game::advanceElement(Room& room, ElementRef element, int newState) {
+    int place = navigation.roomIndex(&room);
+    if (place >= 0) {
+        recordChange(UndoRecord{UndoKind::Element, static_cast<uint16_t>(element.position()),
+                                static_cast<uint32_t>(place), element.state()});
     }
+    element.advanceState(newState);
 }
 
 // Updates game state
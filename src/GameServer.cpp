@@ -0,0 +1,242 @@
+#include "GameServer.h"
+#include "Tracer.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+namespace {
+
+bool makeNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+} // namespace
+
+GameServer::ResponseBuffer::int_type GameServer::ResponseBuffer::overflow(int_type ch) {
+    if (ch != traits_type::eof()) target.push_back(static_cast<char>(ch));
+    return ch;
+}
+
+std::streamsize GameServer::ResponseBuffer::xsputn(const char* s, std::streamsize count) {
+    target.append(s, static_cast<size_t>(count));
+    return count;
+}
+
+// Constructor
+GameServer::Connection::Connection(int fd)
+    : fd(fd), session(0), sent(0), paused(false), backlog(false), closing(false), endingOffered(false), response(pending), out(&response) {}
+
+// Constructor
+GameServer::GameServer(SessionManager& sessions)
+    : sessions(sessions), listenFd(-1), wakeFds{-1, -1}, boundPort(0), stopping(false), commands(0), pauses(0) {
+    if (pipe(wakeFds) == 0) {
+        makeNonBlocking(wakeFds[0]);
+        makeNonBlocking(wakeFds[1]);
+    }
+}
+
+GameServer::~GameServer() {
+    while (!connections.empty()) drop(connections.size() - 1);
+    if (listenFd >= 0) close(listenFd);
+    if (wakeFds[0] >= 0) close(wakeFds[0]);
+    if (wakeFds[1] >= 0) close(wakeFds[1]);
+}
+
+bool GameServer::listen(uint16_t port, std::string* error) {
+    auto fail = [error](const char* what) {
+        if (error) *error = std::string(what) + ": " + std::strerror(errno);
+        return false;
+    };
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) return fail("socket");
+    int yes = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) return fail("bind");
+    if (::listen(listenFd, SOMAXCONN) != 0) return fail("listen");
+    if (!makeNonBlocking(listenFd)) return fail("fcntl");
+
+    socklen_t length = sizeof(address);
+    getsockname(listenFd, reinterpret_cast<sockaddr*>(&address), &length);
+    boundPort = ntohs(address.sin_port);
+    return true;
+}
+
+void GameServer::stop() {
+    stopping.store(true);
+    if (wakeFds[1] >= 0) {
+        char byte = 0;
+        [[maybe_unused]] ssize_t ignored = write(wakeFds[1], &byte, 1);
+    }
+}
+
+void GameServer::run() {
+    std::vector<pollfd> polled;
+    while (!stopping.load()) {
+        polled.clear();
+        polled.push_back(pollfd{listenFd, POLLIN, 0});
+        polled.push_back(pollfd{wakeFds[0], POLLIN, 0});
+        bool backlog = false;
+        for (const auto& connection : connections) {
+            short events = connection->wantsInput() ? POLLIN : 0;
+            if (connection->queued() > 0) events |= POLLOUT;
+            polled.push_back(pollfd{connection->fd, events, 0});
+            backlog = backlog || connection->backlog;
+        }
+
+        // Buffered commands left over from the last round are run without waiting for new events
+        if (poll(polled.data(), polled.size(), backlog ? 0 : -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        // Walk backwards so dropping a connection does not shift the ones still to be visited.
+        // Connections accepted below are not in 'polled' yet and are picked up next round
+        for (size_t i = connections.size(); i-- > 0;) {
+            short revents = polled[i + 2].revents;
+            Connection& connection = *connections[i];
+            if (!revents && !connection.backlog) continue;
+            bool keep = true;
+            if (revents & (POLLIN | POLLHUP | POLLERR)) {
+                // A connection that is not reading only hears of a hang-up this way
+                keep = connection.wantsInput() ? readFrom(connection) : !(revents & (POLLHUP | POLLERR));
+            } else if (connection.backlog) {
+                runQueued(connection);
+            }
+            if (keep && connection.queued() > 0) keep = writeTo(connection);
+            if (keep && connection.closing && connection.queued() == 0) keep = false;
+            if (!keep) drop(i);
+        }
+        if (polled[1].revents & POLLIN) {
+            char drain[64];
+            while (read(wakeFds[0], drain, sizeof(drain)) > 0) {}
+        }
+        if (polled[0].revents & POLLIN) acceptAll();
+    }
+}
+
+void GameServer::acceptAll() {
+    for (;;) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return; // EAGAIN, or out of descriptors: the rest stay in the backlog
+        int yes = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+        // Keep the kernel from buffering megabytes for a client that does not read, so the send queue
+        // and its watermarks are what bound a connection's memory
+        int sendBuffer = static_cast<int>(kHighWatermark);
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sendBuffer, sizeof(sendBuffer));
+
+        auto connection = std::make_unique<Connection>(fd);
+        connection->session = sessions.open(connection->out);
+        sessions.processInput(connection->session, "look");
+        connection->pending += kEndOfResponse;
+        writeTo(*connection);
+        connections.push_back(std::move(connection));
+    }
+}
+
+// Reads once and runs the complete lines that arrived (up to this round's share).
+// Returns false once the client is gone
+bool GameServer::readFrom(Connection& connection) {
+    char buffer[4096];
+    size_t room = std::min(sizeof(buffer), kMaxInputBytes - connection.input.size());
+    ssize_t got = recv(connection.fd, buffer, room, 0);
+    if (got == 0) return false;
+    if (got < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    connection.input.append(buffer, static_cast<size_t>(got));
+    runQueued(connection);
+    return true;
+}
+
+void GameServer::runQueued(Connection& connection) {
+    size_t start = 0;
+    size_t budget = kCommandsPerRound;
+    connection.backlog = false;
+    while (!connection.closing && !connection.paused) {
+        if (budget-- == 0) {
+            connection.backlog = true;
+            break;
+        }
+        size_t newline = connection.input.find('\n', start);
+        if (newline == std::string::npos) {
+            // A line that fills the whole input buffer would stall the connection for good; run what there is
+            if (start > 0 || connection.input.size() < kMaxInputBytes) break;
+            newline = connection.input.size();
+        }
+        handleLine(connection, connection.input.substr(start, newline - start));
+        start = std::min(newline + 1, connection.input.size());
+        if (connection.queued() >= kHighWatermark) {
+            connection.paused = true;
+            pauses.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    connection.input.erase(0, start);
+}
+
+void GameServer::handleLine(Connection& connection, const std::string& line) {
+    TRACE_SCOPE("GameServer::handleLine");
+    std::string command = line.size() > kMaxLineBytes ? line.substr(0, kMaxLineBytes) : line;
+    if (!command.empty() && command.back() == '\r') command.pop_back();
+    sessions.processInput(connection.session, command);
+    commands.fetch_add(1, std::memory_order_relaxed);
+    if (!sessions.isOver(connection.session)) {
+        connection.endingOffered = false;
+    } else if (!connection.endingOffered && sessions.undoDepth(connection.session) > 0) {
+        connection.out << "\n(Type 'undo' to take back your last move; anything else ends the session.)\n";
+        connection.endingOffered = true;
+    } else {
+        connection.closing = true;
+    }
+    connection.pending += kEndOfResponse;
+}
+
+// Writes as much as the socket takes, and resumes a paused connection once its client has caught up.
+// Returns false on a broken connection
+bool GameServer::writeTo(Connection& connection) {
+    for (;;) {
+        while (connection.queued() > 0) {
+            ssize_t written = send(connection.fd, connection.pending.data() + connection.sent,
+                                   connection.queued(), MSG_NOSIGNAL);
+            if (written < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) break;
+                return false;
+            }
+            connection.sent += static_cast<size_t>(written);
+        }
+        if (connection.queued() == 0) {
+            // Keep the capacity for the next response, unless a burst made it unusually large
+            connection.pending.clear();
+            if (connection.pending.capacity() > 2 * kHighWatermark) std::string().swap(connection.pending);
+            connection.sent = 0;
+        } else if (connection.sent >= kLowWatermark) {
+            // A client that never quite catches up must not make the written prefix grow forever
+            connection.pending.erase(0, connection.sent);
+            connection.sent = 0;
+        }
+
+        if (!connection.paused || connection.queued() > kLowWatermark) return true;
+        // Buffered commands may produce more output, which the next round tries to send right away
+        connection.paused = false;
+        runQueued(connection);
+        if (connection.queued() == 0) return true;
+    }
+}
+
+void GameServer::drop(size_t index) {
+    Connection& connection = *connections[index];
+    sessions.close(connection.session);
+    close(connection.fd);
+    connections[index] = std::move(connections.back());
+    connections.pop_back();
+}
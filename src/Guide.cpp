@@ -1,74 +1,80 @@
 #include "Guide.h"
 #include "Game.h"
+#include "WorldTables.h"
+#include <cstdlib>
 
 // Constructor
 Guide::Guide(std::string name)
-    : name(std::move(name)), isFeigningInjury(false) {
+    : name(std::move(name)), isFeigningInjury(false), rng(static_cast<unsigned int>(std::rand())) {
         initializeDialogue();
     }
 
-// Initialize dialogue and help messages
-void Guide::initializeDialogue() {
+// Initialize dialogue and help messages from the generated world tables (see world/visitor_center.world),
+// in the language of 'messages'
+void Guide::initializeDialogue(const MessageCatalog& messages) {
+    commandExplanations.clear();
+    dialogueLines.clear();
     // Command explanations (Help System)
-    commandExplanations["general"] = "You can 'go <direction/place_id>', 'look', 'examine <object/item_id>', 'get <item_id>', 'inventory', 'talk to guide', 'use <item_id>', 'help <command>', or 'quit'.";
-    commandExplanations["go"] = "To move, type 'go' followed by an exit name (e.g., 'go north', 'go office', 'go enter-center'). Check 'look' for available exits.";
-    commandExplanations["look"] = "Type 'look' to get a description of your current surroundings.";
-    commandExplanations["examine"] = "Type 'examine' followed by the name or ID of an item or object you see (e.g., 'examine desk', 'examine gas_can').";
-    commandExplanations["get"] = "Type 'get' followed by the ID of an item you see to pick it up (e.g., 'get gas_can').";
-    commandExplanations["inventory"] = "Type 'inventory' to see the items you are carrying.";
-    commandExplanations["talk"] = "Type 'talk to guide' to speak with me. Though, I am always listening.";
-    commandExplanations["use"] = "Type 'use' followed by the ID of an item in your inventory (e.g., 'use first_aid_kit').";
-
-    // Initial dialogue when player first meets the Guide.
-    dialogueLines[GameState::FIRST_ENCOUNTER_WITH_GUIDE].push_back("Oh! A visitor... I... I'm sorry for the state of things. The air has been so heavy lately. Since you've arrived... the spirits... they feel your presence, and they're not pleased. They are keeping me from the supply rooms... where the parts you need for your car are stored. But... there may be a way. There are three acts of respect we must show them. If we can prove you honor their memory, I believe they will relent.");
-
-    // Dialogue for Task 1
-    dialogueLines[GameState::AWAITING_TASK_1].push_back("This place remembers. The Pioneer Family exhibit honors those who first settled Oakhaven. To show the spirits you mean no harm, perhaps a simple act of care is needed. Wiping away the dust from their memorial would speak volumes. 'Clean' it, and I feel they will allow you to get the gas can from the storage room.");
-
-    // Dialogue for Task 2
-    dialogueLines[GameState::AWAITING_TASK_2].push_back("That noise... the music box... they're still not satisfied. The archives... a place of history and order, has fallen into disarray. They hate chaos. If you could 'organize' the scattered papers, put things back in order... it would soothe them. The archives should be in the storage room. The spare tire that you need is in the West Wing; this act of respect should grant us passage.");
-
-    // Dialogue for Task 3
-    dialogueLines[GameState::AWAITING_TASK_3].push_back("Did you see them move? It's getting worse... The music box that fell... it belonged to a little girl, one of the first to be lost here. Her spirit is the most restless. If you could repair it... maybe its song could bring some peace to her, and to this place. The oil fluid is in my office. A final act of respect like this might be all we need.");
-
-    // --- Endgame Dialogue ---
-    dialogueLines[GameState::AWAITING_TASK_4].push_back("It wasn't enough! They're angrier than ever! My plan... it failed! I... I'm so sorry. There is one last thing we can try. A desperate, final act. A candlelight vigil. To show our sorrow, our respect for their final moments. In the office... please. I've left a candle for you on the desk. 'Use' it when you are ready. It's our only chance.");
-    dialogueLines[GameState::VIGIL_MISTAKE].push_back("You've desecrated the vigil! Now they will have their vengeance on ME!");
-
-    // Ending dialogue 
-    dialogueLines[GameState::PLAYER_RETURNS_GUIDE_UNHARMED_REVEAL].push_back("My, my, how gullible you are... I'm amazed how quickly you fell for this elaborate ruse... All of this talk about evil spirits? All fake! But more importantly, you chose to stay... You chose to help little old me. I now know you are truly 'worthy'.");
-    dialogueLines[GameState::FIGURES_REVEALED].push_back("The figures... they are my collection of past 'worthy' individuals, 'saved' at their moment of purest empathy.");
-    dialogueLines[GameState::FINAL_CONFRONTATION_IMMINENT].push_back("You, my friend, have shown such profound compassion. It is time for you to join them, to be kept perfect, forever.");
-
-    dialogueLines[GameState::ENDING_NOT_WORTHY].push_back("Go then... flee back to your decaying world. Some souls... simply are unworthy of preservation...");
-    
-    dialogueLines[GameState::ENDING_BAD_VICTIM].push_back("Such a perfect specimen for my collection.");
-
+    for (const WorldHelp& help : kWorldHelp) {
+        commandExplanations[std::string(help.topic)] = std::string(messages.text(help.message));
+    }
+    // Lines the Guide can say in each state; a state with several lines picks one at random
+    for (const WorldDialogue& line : kWorldDialogue) {
+        dialogueLines[line.state].emplace_back(messages.text(line.message));
+    }
+    silence = std::string(messages.text(MessageId::GUIDE_SILENCE));
+    noHint = std::string(messages.text(MessageId::HINT_NONE));
+    hintThought = std::string(messages.text(MessageId::HINT_THOUGHT));
+    hintSpoken = std::string(messages.text(MessageId::HINT_GUIDE));
 }
 
 // Interact with the Guide
-std::string Guide::getDialogue(GameState currentState) const {
+const std::string& Guide::getDialogue(GameState currentState) const {
     auto it_dialogue = dialogueLines.find(currentState);
     if (it_dialogue != dialogueLines.end() && !it_dialogue->second.empty()) {
-        return it_dialogue->second[rand() % it_dialogue->second.size()];
+        return it_dialogue->second[rng() % it_dialogue->second.size()];
     } else {
-        return "He just stares at you, a look of profound sorrow on his face.";
+        return silence;
 
     }
 }
 
 // Provide help
-void Guide::provideHelp(const std::string& commandTopic, [[maybe_unused]] GameState currentState) {
-    std::cout << "\n";
-    std::cout << "\n--- " << name << " (Help) ---" << std::endl;
+void Guide::provideHelp(const std::string& commandTopic, GameState currentState, std::ostream& os, const std::string& hint) {
+    os << "\n";
+    os << "\n--- " << name << " (Help) ---" << std::endl;
     auto it = commandExplanations.find(commandTopic);
     if (it != commandExplanations.end()) {
-        std::cout << it->second << std::endl;
+        os << it->second << std::endl;
+    } else {
+        os << commandExplanations["general"] << std::endl;
+        if (!hint.empty()) {
+            giveHint(hint, currentState, os);
+        }
+    }
+    os << "------------------------------------------" << std::endl;
+
+}
+
+// Print a hint for the next useful command
+void Guide::giveHint(const std::string& hint, GameState currentState, std::ostream& os) const {
+    if (hint.empty()) {
+        os << noHint << std::endl;
+        return;
+    }
+    static constexpr std::string_view kMark = "{hint}";
+    std::string_view line = currentState == GameState::INTRO ? hintThought : hintSpoken;
+    size_t mark = line.find(kMark);
+    if (mark == std::string_view::npos) {
+        os << line << std::endl;
     } else {
-        std::cout << commandExplanations["general"] << std::endl;
+        os << line.substr(0, mark) << hint << line.substr(mark + kMark.size()) << std::endl;
     }
-    std::cout << "------------------------------------------" << std::endl;
+}
 
+// Reseed the dialogue picker
+void Guide::seed(unsigned int value) {
+    rng.seed(value);
 }
 
 // Set Guide's state
@@ -0,0 +1,109 @@
+#include "HintEngine.h"
+#include "Game.h"
+#include <unordered_set>
+
+// Returns the recommended next command for the game's current state
+void HintEngine::nextAction(const Game& game, std::string& action) {
+    if (game.gameOver) {
+        action.clear();
+        return;
+    }
+
+    // Games on one thread take turns, so they can share the key buffer
+    thread_local std::string key;
+    game.stateKey(key);
+    {
+        std::lock_guard<std::mutex> lock(memoMutex);
+        auto it = memo.find(key);
+        if (it != memo.end()) {
+            action = it->second;
+            return;
+        }
+    }
+    action = solve(game, key);
+}
+
+size_t HintEngine::cachedStates() const {
+    std::lock_guard<std::mutex> lock(memoMutex);
+    return memo.size();
+}
+
+// @brief Breadth-first search over copies of the game until the GameState changes
+// The search itself runs without holding the memo lock; only the results are published under it.
+std::string HintEngine::solve(const Game& game, const std::string& rootKey) {
+    struct Node {
+        Game game;
+        size_t parent;
+        std::string command; // Command that led here from the parent
+        std::string key;
+    };
+
+    std::ostream discard(nullptr);
+    std::vector<Node> nodes;
+    nodes.reserve(256);
+    nodes.push_back(Node{game, 0, std::string(), rootKey});
+    nodes.back().game.redirectOutput(discard, 0);
+
+    std::unordered_set<std::string> visited{rootKey};
+    const GameState rootState = game.currentGameState;
+    size_t goal = 0;
+
+    for (size_t head = 0; head < nodes.size() && goal == 0 && nodes.size() < kMaxSearchStates; ++head) {
+        for (const auto& words : candidateCommands(nodes[head].game)) {
+            Game child = nodes[head].game;
+            child.executeCommand(words);
+            std::string childKey = child.stateKey();
+            if (!visited.insert(childKey).second) continue;
+
+            std::string command = words[0];
+            for (size_t w = 1; w < words.size(); ++w) command += " " + words[w];
+            nodes.push_back(Node{std::move(child), head, std::move(command), std::move(childKey)});
+
+            if (nodes.back().game.currentGameState != rootState) {
+                goal = nodes.size() - 1;
+                break;
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(memoMutex);
+    if (goal == 0) {
+        memo[rootKey] = std::string();
+        return std::string();
+    }
+
+    // Walk back from the goal: each state on the path maps to the command that follows it
+    std::string next;
+    for (size_t n = goal; n != 0; n = nodes[n].parent) {
+        memo[nodes[nodes[n].parent].key] = nodes[n].command;
+        next = nodes[n].command;
+    }
+    return next;
+}
+
+// @brief Lists the commands that could change something from the game's current state
+// Story choices are ordered so that, between equally short paths, helping comes before leaving.
+std::vector<std::vector<std::string>> HintEngine::candidateCommands(const Game& game) {
+    std::vector<std::vector<std::string>> commands;
+    Room* room = game.player.currentLocation;
+    if (!room || game.gameOver) {
+        return commands;
+    }
+
+    for (const auto& exit : room->exits) {
+        if (game.exitLockMessage(exit.first).empty()) commands.push_back({"go", exit.first});
+    }
+    for (const auto& item : room->items) {
+        if (item) commands.push_back({"get", item->id});
+    }
+    if (room->getInteractiveElement("guide")) commands.push_back({"talk", "to", "guide"});
+    if (room->getInteractiveElement("memorial")) commands.push_back({"clean", "memorial"});
+    if (room->getInteractiveElement("archives")) commands.push_back({"organize", "archives"});
+    if (room->getInteractiveElement("garden")) commands.push_back({"trim", "garden"});
+    if (room->getInteractiveElement("candle")) commands.push_back({"use", "candle"});
+    if (game.currentGameState == GameState::CHOICE_POINT_LEAVE_OR_HELP) {
+        commands.push_back({"assist"});
+        commands.push_back({"leave"});
+    }
+    return commands;
+}
@@ -1,31 +1,12 @@
 #include "InteractiveElement.h"
+#include "Item.h"
 
 // Constructor
-InteractiveElement::InteractiveElement(std::string name, const std::vector<std::string>& descs)
+InteractiveElement::InteractiveElement(std::string name, const std::vector<std::string>& descs, const std::vector<std::string>& aliases)
     : name(std::move(name)),
-    descriptions(descs),
-    currentState(0) {}
-
-// Displays the current description of the element
-void InteractiveElement::examine() const {
-    if (!descriptions.empty() && currentState < descriptions.size()) {
-        std::cout << descriptions[currentState] << std::endl;
-    } else {
-        std::cout << "You look at the " << name << ", but nothing seems out of the ordinary." << std::endl;
-    }
-}
-
-// Method to advance the element to its next state
-void InteractiveElement::advanceState(int newState) {
-    if (newState == -1) {
-        if (currentState + 1 < descriptions.size()) {
-            currentState++;
-        }
-    } else {
-        if (static_cast<size_t>(newState) < descriptions.size()) {
-            currentState = newState; 
-        }
+    descriptions(descs) {
+    addNounForms(nouns, this->name);
+    for (const auto& alias : aliases) {
+        addNounForms(nouns, alias);
     }
-
-    
 }
\ No newline at end of file
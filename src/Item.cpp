@@ -1,16 +1,65 @@
 #include "Item.h"
+#include <algorithm>
+#include <cctype>
 
 // Constructor 
-Item::Item(std::string id, std::string name, std::string description)
-    : id(std::move(id)), name(std::move(name)), description(std::move(description)) {}
+Item::Item(std::string id, std::string name, std::string description, const std::vector<std::string>& aliases)
+    : id(std::move(id)), name(std::move(name)), description(std::move(description)) {
+    nouns.push_back(this->id);
+    addNounForms(nouns, this->name);
+    for (const auto& alias : aliases) {
+        addNounForms(nouns, alias);
+    }
+}
+
+void Item::addAlias(const std::string& alias) {
+    addNounForms(nouns, alias);
+}
+
+void releaseItemSlot(ItemSlot& slot, const std::string& noun, const Item* leaving, const std::vector<std::unique_ptr<Item>>& items) {
+    if (slot.count > 0) --slot.count;
+    if (slot.item != leaving) return;
+
+    slot.item = nullptr;
+    if (slot.count == 0) return;
+    for (const auto& other : items) {
+        if (other && other.get() != leaving &&
+            std::find(other->nouns.begin(), other->nouns.end(), noun) != other->nouns.end()) {
+            slot.item = other.get();
+            return;
+        }
+    }
+}
+
+void addNounForms(std::vector<std::string>& nouns, const std::string& text) {
+    std::string form = text;
+    // tolower is only defined for unsigned char values, and translated names hold UTF-8 bytes above 0x7F
+    std::transform(form.begin(), form.end(), form.begin(),
+                   [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+    std::string swapped = form;
+    for (char& c : swapped) {
+        if (c == ' ') c = '_';
+        else if (c == '_') c = ' ';
+    }
+    for (const std::string* candidate : {&form, &swapped}) {
+        if (!candidate->empty() && std::find(nouns.begin(), nouns.end(), *candidate) == nouns.end()) {
+            nouns.push_back(*candidate);
+        }
+    }
+}
 
 // Displays the item's description
-void Item::examine() const {
-    std::cout << description << std::endl;
+void Item::examine(std::ostream& os) const {
+    os << description << std::endl;
 }
 
 
+// Returns a copy of this item
+std::unique_ptr<Item> Item::clone() const {
+    return std::make_unique<Item>(*this);
+}
+
 // Placeholder for using an item
-void Item::use() const {
-    std::cout << "You try to use the " << name << ", but nothing specific happens." << std::endl;
+void Item::use(std::ostream& os) const {
+    os << "You try to use the " << name << ", but nothing specific happens." << std::endl;
 }
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include "MessageCatalog.h"
+#include "Game.h"
+#include "WorldTables.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstring>
+
+const MessageCatalog& MessageCatalog::builtIn() {
+    static const MessageCatalog catalog;
+    return catalog;
+}
+
+std::unique_ptr<MessageCatalog> MessageCatalog::open(const std::string& path, std::string* error) {
+    auto fail = [&](const std::string& message) {
+        if (error) *error = path + ": " + message;
+        return nullptr;
+    };
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return fail("cannot open");
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(Header)) {
+        close(fd);
+        return fail("not a message catalog");
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // The mapping keeps the file alive
+    if (data == MAP_FAILED) return fail("cannot map");
+
+    // From here the destructor unmaps
+    std::unique_ptr<MessageCatalog> catalog(new MessageCatalog());
+    catalog->mapped = static_cast<const uint8_t*>(data);
+    catalog->mappedSize = size;
+
+    // Only the header is read now; each line's offsets are checked when it is looked up
+    Header header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kFormatVersion) {
+        return fail("not a message catalog");
+    }
+    if (header.schema != kMessageSchema || header.count != kMessageCount) {
+        return fail("built for a different set of messages; rebuild it with 'make catalogs'");
+    }
+    if (size != sizeof(Header) + (static_cast<size_t>(header.count) + 1) * sizeof(uint32_t) + header.textBytes) {
+        return fail("truncated or padded");
+    }
+    catalog->offsets = reinterpret_cast<const uint32_t*>(catalog->mapped + sizeof(Header));
+    catalog->textBlock = reinterpret_cast<const char*>(catalog->offsets + header.count + 1);
+    catalog->count = header.count;
+    catalog->textBytes = header.textBytes;
+    const char* tag = reinterpret_cast<const char*>(catalog->mapped + offsetof(Header, locale));
+    catalog->localeTag = std::string_view(tag, strnlen(tag, sizeof(header.locale)));
+    return catalog;
+}
+
+MessageCatalog::~MessageCatalog() {
+    if (mapped) munmap(const_cast<uint8_t*>(mapped), mappedSize);
+}
+
+std::string_view MessageCatalog::text(MessageId id) const {
+    size_t i = static_cast<size_t>(id);
+    if (i < count) {
+        uint32_t begin = offsets[i];
+        uint32_t end = offsets[i + 1];
+        if (begin < end && end <= textBytes) return std::string_view(textBlock + begin, end - begin);
+    }
+    return i < kMessageCount ? kWorldMessages[i] : std::string_view();
+}
@@ -0,0 +1,136 @@
+#include "NavigationTable.h"
+#include <algorithm>
+#include <iterator>
+
+// Indexes the rooms and their exits
+void NavigationTable::build(const std::vector<std::unique_ptr<Room>>& allRooms, const std::vector<std::string>& lockableExits) {
+    rooms.clear();
+    indexById.clear();
+    indexByRoom.clear();
+    exits.clear();
+    exitOffsets.clear();
+    incoming.clear();
+    incomingOffsets.clear();
+    columns.clear();
+    columnByKey.clear();
+
+    for (const auto& room : allRooms) {
+        indexByRoom[room.get()] = static_cast<uint32_t>(rooms.size());
+        indexById[room->id] = static_cast<uint32_t>(rooms.size());
+        rooms.push_back(room.get());
+    }
+
+    // Outgoing exits
+    std::vector<uint32_t> incomingCount(rooms.size(), 0);
+    exitOffsets.reserve(rooms.size() + 1);
+    for (const Room* room : rooms) {
+        exitOffsets.push_back(static_cast<uint32_t>(exits.size()));
+        for (const auto& exit : room->exits) {
+            auto target = indexByRoom.find(exit.second);
+            if (target == indexByRoom.end()) continue;
+
+            uint32_t lockBit = 0;
+            for (size_t i = 0; i < lockableExits.size() && i < 32; ++i) {
+                if (lockableExits[i] == exit.first) lockBit = 1u << i;
+            }
+            exits.push_back(Exit{exit.first, target->second, lockBit});
+            ++incomingCount[target->second];
+        }
+    }
+    exitOffsets.push_back(static_cast<uint32_t>(exits.size()));
+
+    // Incoming edges, bucketed by destination for the reverse searches
+    incomingOffsets.assign(rooms.size() + 1, 0);
+    for (size_t r = 0; r < rooms.size(); ++r) {
+        incomingOffsets[r + 1] = incomingOffsets[r] + incomingCount[r];
+    }
+    incoming.resize(exits.size());
+    std::vector<uint32_t> fill(incomingOffsets.begin(), incomingOffsets.end() - 1);
+    for (uint32_t source = 0; source < rooms.size(); ++source) {
+        for (uint32_t e = exitOffsets[source]; e < exitOffsets[source + 1]; ++e) {
+            incoming[fill[exits[e].target]++] = {source, e};
+        }
+    }
+}
+
+int NavigationTable::roomIndex(const std::string& roomId) const {
+    auto it = indexById.find(roomId);
+    return it != indexById.end() ? static_cast<int>(it->second) : -1;
+}
+
+int NavigationTable::roomIndex(const Room* room) const {
+    auto it = indexByRoom.find(room);
+    return it != indexByRoom.end() ? static_cast<int>(it->second) : -1;
+}
+
+// Returns the exit key that leads one step closer to the target room
+const std::string* NavigationTable::nextExit(const Room* from, int target, uint32_t blockedMask) {
+    int source = roomIndex(from);
+    if (source < 0 || target < 0 || static_cast<size_t>(target) >= rooms.size() || source == target) {
+        return nullptr;
+    }
+    uint16_t slot = column(static_cast<uint32_t>(target), blockedMask)[source];
+    if (slot == kNoRoute) {
+        return nullptr;
+    }
+    return &exits[exitOffsets[source] + slot].key;
+}
+
+void NavigationTable::setColumnBudget(size_t bytes) {
+    columnBudget = bytes;
+    size_t capacity = columnCapacity();
+    while (columns.size() > capacity) {
+        columnByKey.erase(columns.back().key);
+        columns.pop_back();
+    }
+}
+
+size_t NavigationTable::columnCapacity() const {
+    size_t columnBytes = std::max<size_t>(rooms.size(), 1) * sizeof(uint16_t);
+    return std::max<size_t>(columnBudget / columnBytes, 1);
+}
+
+// @brief Returns the next-hop column towards 'target' under a blocked mask, computing it if it is
+// not cached. Once the cache is full, the least recently used column's buffer is reused for the new one
+const std::vector<uint16_t>& NavigationTable::column(uint32_t target, uint32_t blockedMask) {
+    uint64_t key = (static_cast<uint64_t>(blockedMask) << 32) | target;
+    auto found = columnByKey.find(key);
+    if (found != columnByKey.end()) {
+        columns.splice(columns.begin(), columns, found->second);
+        return found->second->nextHop;
+    }
+
+    if (columns.size() >= columnCapacity()) {
+        columnByKey.erase(columns.back().key);
+        columns.splice(columns.begin(), columns, std::prev(columns.end()));
+        columns.front().key = key;
+    } else {
+        columns.push_front(Column{key, {}});
+    }
+    columnByKey[key] = columns.begin();
+    computeColumn(target, blockedMask, columns.front().nextHop);
+    return columns.front().nextHop;
+}
+
+// @brief A reverse breadth-first search from the target labels every room with the exit slot
+// that starts one of its shortest paths
+void NavigationTable::computeColumn(uint32_t target, uint32_t blockedMask, std::vector<uint16_t>& nextHop) {
+    nextHop.assign(rooms.size(), kNoRoute);
+    queue.clear();
+    queue.reserve(rooms.size());
+    visited.assign(rooms.size(), false);
+    visited[target] = true;
+    queue.push_back(target);
+    for (size_t head = 0; head < queue.size(); ++head) {
+        uint32_t room = queue[head];
+        for (uint32_t i = incomingOffsets[room]; i < incomingOffsets[room + 1]; ++i) {
+            uint32_t source = incoming[i].first;
+            uint32_t exitIndex = incoming[i].second;
+            if (visited[source] || (exits[exitIndex].lockBit & blockedMask)) continue;
+            visited[source] = true;
+            uint32_t slot = exitIndex - exitOffsets[source];
+            nextHop[source] = slot < kNoRoute ? static_cast<uint16_t>(slot) : kNoRoute;
+            queue.push_back(source);
+        }
+    }
+}
@@ -11,44 +11,86 @@ Player::Player(Room* startLocation)
     hasFirstAidKit(false),
     hasCleanedMemorial(false), 
     hasOrganizedArchives(false), 
-    hasTrimmedGarden(false) {}
+    hasTrimmedGarden(false),
+    inventoryRevision(0) {}
+
+// Copy constructor
+Player::Player(const Player& other)
+    : currentLocation(other.currentLocation),
+    hasGasCan(other.hasGasCan),
+    hasSpareTire(other.hasSpareTire),
+    hasOilFluid(other.hasOilFluid),
+    hasSurgicalDefensiveItem(other.hasSurgicalDefensiveItem),
+    hasFirstAidKit(other.hasFirstAidKit),
+    hasCleanedMemorial(other.hasCleanedMemorial),
+    hasOrganizedArchives(other.hasOrganizedArchives),
+    hasTrimmedGarden(other.hasTrimmedGarden),
+    inventoryRevision(other.inventoryRevision) {
+    // Carry over every noun the other player has indexed, so this copy doesn't allocate on pickups either
+    inventoryIndex.reserve(other.inventoryIndex.size());
+    for (const auto& entry : other.inventoryIndex) indexNoun(entry.first);
+    inventory.reserve(other.inventory.capacity());
+    for (const auto& item : other.inventory) {
+        if (item) {
+            inventory.push_back(item->clone());
+            indexItem(inventory.back().get());
+        }
+    }
+}
 
 // Moves the player to a new location 
-void Player::moveTo(Room* newLocation) {
+void Player::moveTo(Room* newLocation, std::ostream& os) {
     currentLocation = newLocation;
     if (currentLocation) {
-        std::cout << "\n==================================================================\n"; // Separator before room description
-        currentLocation->look(); // Display description of the new room
+        os << "\n==================================================================\n"; // Separator before room description
+        currentLocation->look(os); // Display description of the new room
     }
 }
 
 // Adds an item to the player's inventory
-void Player::pickUpItem(std::unique_ptr<Item> item) {
+void Player::pickUpItem(std::unique_ptr<Item> item, std::ostream& os) {
     if (item) {
-        std::cout << "You picked up the " << item->id << "." << std::endl;
+        os << "You picked up the " << item->id << "." << std::endl;
         updateItemFlags(item->id, true);
+        indexItem(item.get());
         inventory.push_back(std::move(item));
+        ++inventoryRevision;
     }
 }
 
 // Removes and returns an item from inventory
-std::unique_ptr<Item> Player::dropItem(const std::string& itemId) {
+std::unique_ptr<Item> Player::dropItem(const std::string& noun, std::ostream& os) {
+    Item* target = getItemFromInventory(noun);
     auto it = std::find_if(inventory.begin(), inventory.end(),
-                           [&itemId](const std::unique_ptr<Item>& item_ptr) {
-                               return item_ptr && item_ptr->id == itemId;
+                           [target](const std::unique_ptr<Item>& item_ptr) {
+                               return target && item_ptr.get() == target;
                            });
 
     if (it != inventory.end()) {
         std::unique_ptr<Item> foundItem = std::move(*it);
         inventory.erase(it);
-        std::cout << "You dropped the " << foundItem->id << "." << std::endl;
+        unindexItem(foundItem.get());
+        ++inventoryRevision;
+        os << "You dropped the " << foundItem->id << "." << std::endl;
         updateItemFlags(foundItem->id, false);
         return foundItem;
     }
-    std::cout << "You don't have a '" << itemId << "' to drop." << std::endl;
+    os << "You don't have a '" << noun << "' to drop." << std::endl;
     return nullptr;
 }
 
+// Empties the inventory into 'out'
+void Player::takeAllItems(std::vector<std::unique_ptr<Item>>& out) {
+    for (auto& item : inventory) {
+        if (item) {
+            unindexItem(item.get());
+            out.push_back(std::move(item));
+        }
+    }
+    inventory.clear();
+    ++inventoryRevision;
+}
+
 // Checks if the player has a specific item by its ID
 bool Player::hasItem(const std::string& itemId) const {
     // Directly check the flags for key items for efficiency, then inventory for others.
@@ -58,37 +100,63 @@ bool Player::hasItem(const std::string& itemId) const {
     if (itemId == "surgical_item" && hasSurgicalDefensiveItem) return true;
     if (itemId == "first_aid_kit" && hasFirstAidKit) return true;
     
-    // Fallback to checking inventory vector if not a flagged item or flag logic is TBD for some items
-    for (const auto& item_ptr : inventory) {
-        if (item_ptr && item_ptr->id == itemId) {
-            return true;
-        }
-    }
-    return false;
+    // Fallback to the inventory index if not a flagged item or flag logic is TBD for some items
+    const Item* item = getItemFromInventory(itemId);
+    return item && item->id == itemId;
 }
 
 // Gets a raw pointer to an item in inventory
-Item* Player::getItemFromInventory(const std::string& itemId) const {
-    for (const auto& item_ptr : inventory) {
-        if (item_ptr && item_ptr->id == itemId) {
-            return item_ptr.get();
+Item* Player::getItemFromInventory(const std::string& noun) const {
+    auto entry = inventoryIndex.find(noun);
+    return entry != inventoryIndex.end() ? entry->second.item : nullptr;
+}
+
+// Looks for near misses among the nouns of carried items
+void Player::fuzzyMatchItem(const std::string& noun, FuzzyMatch& match) const {
+    inventoryTree.search(noun, FuzzyIndex::typoBudget(noun.size()), [&](const std::string& candidate, unsigned distance) {
+        const ItemSlot& slot = inventoryIndex.find(candidate)->second;
+        if (slot.item) match.offer(candidate, distance, slot.item);
+    });
+}
+
+void Player::expectItem(const Item& item) {
+    for (const auto& noun : item.nouns) indexNoun(noun);
+}
+
+ItemSlot& Player::indexNoun(const std::string& noun) {
+    auto result = inventoryIndex.try_emplace(noun);
+    if (result.second) inventoryTree.insert(result.first->first);
+    return result.first->second;
+}
+
+void Player::indexItem(Item* item) {
+    for (const auto& noun : item->nouns) {
+        ItemSlot& slot = indexNoun(noun);
+        if (slot.count++ == 0) slot.item = item;
+    }
+}
+
+void Player::unindexItem(const Item* item) {
+    for (const auto& noun : item->nouns) {
+        auto entry = inventoryIndex.find(noun);
+        if (entry != inventoryIndex.end()) {
+            releaseItemSlot(entry->second, noun, item, inventory);
         }
     }
-    return nullptr;
 }
 
 // Displays the player's inventory
-void Player::showInventory() const {
+void Player::showInventory(std::ostream& os) const {
     if (inventory.empty()) {
-        std::cout << "Your inventory is empty." << std::endl;
+        os << "Your inventory is empty." << std::endl;
     } else {
-        std::cout << "\n--- Inventory ---" << std::endl;
+        os << "\n--- Inventory ---" << std::endl;
         for (const auto& item : inventory) {
             if (item) {
-                std::cout << "  - " << item->id << std::endl;
+                os << "  - " << item->id << std::endl;
             }
         }
-        std::cout << "------------------------" << std::endl;
+        os << "------------------------" << std::endl;
     }
 }
 
@@ -1,97 +1,184 @@
 #include "Room.h"
+#include "Tracer.h"
+#include "AllocTracker.h"
 #include <algorithm>
 
 // Constructor
 Room::Room(std::string id, std::string name, std::string description) 
-    : id(std::move(id)), name(std::move(name)), description(std::move(description)) {}
+    : id(std::move(id)), name(std::move(name)), description(std::move(description)), contentRevision(0), textRevision(0) {}
 
 // Displays room information
-void Room::look() const {
+void Room::look(std::ostream& os) const {
+    TRACE_SCOPE("Room::look");
+    ALLOC_SCOPE("Room::look");
     // std::cout << "\n==================================================================\n"; // Moved to moveTo for better context
-    std::cout << "\n--- " << name << " ---" << std::endl;
-    std::cout << description << std::endl;
+    os << "\n--- " << name << " ---" << std::endl;
+    os << description << std::endl;
 
     bool items_present = false;
     for (const auto& item : items) {
         if (item) { // Check if unique_ptr is not null
             if(!items_present) {
-                 std::cout << "\nYou see here:" << std::endl;
+                 os << "\nYou see here:" << std::endl;
                  items_present = true;
             }
-            std::cout << "  - " << item->id << " (" << item->name << ")" << std::endl;
+            os << "  - " << item->id << " (" << item->name << ")" << std::endl;
         }
     }
 
 
-    if (!interactive_elements.empty()) {
-        std::cout << "\nAlso here:" << std::endl;
-        for (const auto& element : interactive_elements) {
-            std::cout << "  - " << element.name << std::endl;
+    if (!elements.empty()) {
+        os << "\nAlso here:" << std::endl;
+        for (uint32_t i = 0; i < elements.size(); ++i) {
+            os << "  - " << elements.name(i) << std::endl;
         }
     }
 
     if (!exits.empty()) {
-        std::cout << "\nExits:" << std::endl;
+        os << "\nExits:" << std::endl;
         for (const auto& pair : exits) {
-            std::cout << "  - " << pair.first;
+            os << "  - " << pair.first;
             // Optionally show connected room name: std::cout << " (to " << pair.second->name << ")";
-            std::cout << std::endl;
+            os << std::endl;
         }
     } else {
-        std::cout << "\nThere are no obvious exits." << std::endl;
+        os << "\nThere are no obvious exits." << std::endl;
     }
     // std::cout << "==================================================================\n"; // Moved to be before prompt in run loop
 }
 
+// Replace the room's text
+void Room::setText(const std::string& newName, const std::string& newDescription) {
+    if (name == newName && description == newDescription) return;
+    name = newName;
+    description = newDescription;
+    ++textRevision;
+}
+
 // Add an exit to another room
 void Room::addExit(const std::string& direction, Room* room) {
-    exits[direction] = room;
+    auto result = exits.insert_or_assign(direction, room);
+    if (result.second) exitTree.insert(result.first->first);
 }
 
 // Add an item to the room
 void Room::addItem(std::unique_ptr<Item> item) {
     if (item) {
+        indexItem(item.get());
         items.push_back(std::move(item));
+        ++contentRevision;
+    }
+}
+
+// Puts an item back where it was
+void Room::insertItem(std::unique_ptr<Item> item, size_t position) {
+    if (item) {
+        indexItem(item.get());
+        items.insert(items.begin() + std::min(position, items.size()), std::move(item));
+        ++contentRevision;
     }
 }
 
 // Remove an item from the room 
-std::unique_ptr<Item> Room::removeItem(const std::string& itemId) {
+std::unique_ptr<Item> Room::removeItem(const std::string& noun) {
+    Item* target = getItem(noun);
+    if (!target) return nullptr; // Item not found
+
+    // The index already found the item; this only locates its slot, comparing pointers
     auto it = std::find_if(items.begin(), items.end(),
-                            [&itemId](const std::unique_ptr<Item>& item_ptr) {
-                                return item_ptr && item_ptr->id == itemId;
+                            [target](const std::unique_ptr<Item>& item_ptr) {
+                                return item_ptr.get() == target;
                             });
-    if (it != items.end()) {
-        std::unique_ptr<Item> foundItem = std::move(*it);
-        items.erase(it);
-        return foundItem;
+    if (it == items.end()) return nullptr;
+    std::unique_ptr<Item> foundItem = std::move(*it);
+    items.erase(it);
+    unindexItem(foundItem.get());
+    ++contentRevision;
+    return foundItem;
+}
+
+// Empties the room into 'out'
+void Room::takeAllItems(std::vector<std::unique_ptr<Item>>& out) {
+    for (auto& item : items) {
+        if (item) {
+            unindexItem(item.get());
+            out.push_back(std::move(item));
+        }
     }
-    return nullptr; // Item not found
+    items.clear();
+    ++contentRevision;
 }
 
 // Add an interactive element to the room
 void Room::addInteractiveElement(const InteractiveElement& element) {
-    interactive_elements.push_back(element);
+    indexElement(elements.add(element));
+}
+
+void Room::copyElementsFrom(const Room& other) {
+    elements = other.elements;
+    for (uint32_t i = 0; i < elements.size(); ++i) indexElement(i);
+}
+
+// Get an interactive element in the room
+ElementRef Room::getInteractiveElement(const std::string& noun) {
+    return resolveNoun(noun).element;
+}
+
+// Get a pointer to an item in the room (without removing it)
+Item* Room::getItem(const std::string& noun) {
+    return resolveNoun(noun).item;
+}
+
+// Looks a noun up in the index
+NounMatch Room::resolveNoun(const std::string& noun) {
+    auto entry = nounIndex.find(noun);
+    if (entry == nounIndex.end()) return NounMatch{nullptr, ElementRef()};
+    ElementRef element = entry->second.element >= 0 ? elements.ref(static_cast<uint32_t>(entry->second.element)) : ElementRef();
+    return NounMatch{entry->second.item.item, element};
 }
 
-// Get a pointer to an interactive element in the room
-InteractiveElement* Room::getInteractiveElement(const std::string& elementName) {
-    for (auto& element : interactive_elements) {
-        if (element.name == elementName) {
-            return &element;
+// Looks for near misses among the nouns of what is here now
+void Room::fuzzyMatchNoun(const std::string& noun, bool itemsOnly, FuzzyMatch& match) {
+    nounTree.search(noun, FuzzyIndex::typoBudget(noun.size()), [&](const std::string& candidate, unsigned distance) {
+        const NounEntry& entry = nounIndex.find(candidate)->second;
+        if (entry.item.item) {
+            match.offer(candidate, distance, entry.item.item);
+        } else if (!itemsOnly && entry.element >= 0) {
+            match.offer(candidate, distance, &elements.name(static_cast<uint32_t>(entry.element)));
         }
+        // Otherwise the noun belonged to an item that has left the room
+    });
+}
+
+void Room::fuzzyMatchExit(const std::string& direction, FuzzyMatch& match) const {
+    exitTree.search(direction, FuzzyIndex::typoBudget(direction.size()), [&](const std::string& candidate, unsigned distance) {
+        match.offer(candidate, distance, &candidate);
+    });
+}
+
+void Room::indexElement(uint32_t index) {
+    for (const auto& noun : elements.nouns(index)) {
+        auto result = nounIndex.try_emplace(noun);
+        if (result.second) nounTree.insert(result.first->first);
+        NounEntry& entry = result.first->second;
+        if (entry.element < 0) entry.element = static_cast<int>(index); // The first element with a noun keeps it
     }
-    return nullptr;
 }
 
-// Get a pointer to an item in the room (without removing it)
-Item* Room::getItem(const std::string& itemId) {
-    auto it = std::find_if(items.begin(), items.end(),
-                            [&itemId](const std::unique_ptr<Item>& item_ptr) {
-                                return item_ptr && item_ptr->id == itemId;
-                            });
-    if (it != items.end()) {
-        return it->get();
+void Room::indexItem(Item* item) {
+    for (const auto& noun : item->nouns) {
+        auto result = nounIndex.try_emplace(noun);
+        if (result.second) nounTree.insert(result.first->first);
+        ItemSlot& slot = result.first->second.item;
+        if (slot.count++ == 0) slot.item = item;
+    }
+}
+
+void Room::unindexItem(const Item* item) {
+    for (const auto& noun : item->nouns) {
+        auto entry = nounIndex.find(noun);
+        if (entry != nounIndex.end()) {
+            releaseItemSlot(entry->second.item, noun, item, items);
+        }
     }
-    return nullptr;
 }
\ No newline at end of file
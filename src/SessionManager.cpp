@@ -0,0 +1,234 @@
+#include "SessionManager.h"
+#include "Tracer.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+
+// Constructor
+SessionManager::SessionManager(SessionPool& pool, std::string spillPath, std::chrono::milliseconds idleAfter,
+                               std::chrono::milliseconds sweepInterval)
+    : pool(pool),
+    spillPath(std::move(spillPath)),
+    idleAfter(idleAfter),
+    nextId(1),
+    spillFd(-1),
+    fileBytes(0),
+    liveBytes(0),
+    stopping(false),
+    sweepInterval(sweepInterval) {
+    spillFd = ::open(this->spillPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (sweepInterval.count() > 0) sweeper = std::thread(&SessionManager::sweepLoop, this);
+}
+
+SessionManager::~SessionManager() {
+    if (sweeper.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(stopMutex);
+            stopping = true;
+        }
+        stopSignal.notify_all();
+        sweeper.join();
+    }
+    for (auto& entry : sessions) {
+        if (entry.second->game) pool.release(std::move(entry.second->game));
+    }
+    if (spillFd >= 0) {
+        ::close(spillFd);
+        std::remove(spillPath.c_str());
+    }
+}
+
+bool SessionManager::canSpill() const {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    return spillFd >= 0;
+}
+
+uint64_t SessionManager::open(std::ostream& output, int typewriterDelayMs) {
+    auto session = std::make_shared<Session>();
+    session->game = pool.acquire(output, typewriterDelayMs);
+    session->out = &output;
+    session->typewriterDelayMs = typewriterDelayMs;
+    session->lastActive = Clock::now();
+
+    std::lock_guard<std::mutex> lock(sessionsMutex);
+    uint64_t id = nextId++;
+    sessions.emplace(id, std::move(session));
+    return id;
+}
+
+void SessionManager::close(uint64_t id) {
+    std::shared_ptr<Session> session;
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex);
+        auto it = sessions.find(id);
+        if (it == sessions.end()) return;
+        session = std::move(it->second);
+        sessions.erase(it);
+    }
+    // Wait for a command in progress before taking the game away
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (session->game) pool.release(std::move(session->game));
+    forget(id);
+}
+
+std::shared_ptr<SessionManager::Session> SessionManager::find(uint64_t id) const {
+    std::lock_guard<std::mutex> lock(sessionsMutex);
+    auto it = sessions.find(id);
+    return it != sessions.end() ? it->second : nullptr;
+}
+
+bool SessionManager::processInput(uint64_t id, const std::string& rawInput) {
+    std::shared_ptr<Session> session = find(id);
+    if (!session) return false;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!session->game && !rehydrate(id, *session)) return false;
+    session->game->processInput(rawInput);
+    session->lastActive = Clock::now();
+    return true;
+}
+
+bool SessionManager::isOver(uint64_t id) const {
+    std::shared_ptr<Session> session = find(id);
+    if (!session) return true;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    return session->game && session->game->gameOver;
+}
+
+size_t SessionManager::undoDepth(uint64_t id) const {
+    std::shared_ptr<Session> session = find(id);
+    if (!session) return 0;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    return session->game ? session->game->undoDepth() : 0;
+}
+
+// Sessions busy with a command are skipped; they are not idle
+size_t SessionManager::evictIdle(Clock::time_point now) {
+    std::vector<std::pair<uint64_t, std::shared_ptr<Session>>> candidates;
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex);
+        candidates.reserve(sessions.size());
+        for (const auto& entry : sessions) candidates.emplace_back(entry.first, entry.second);
+    }
+
+    size_t evicted = 0;
+    for (auto& candidate : candidates) {
+        Session& session = *candidate.second;
+        std::unique_lock<std::mutex> lock(session.mutex, std::try_to_lock);
+        if (!lock.owns_lock() || !session.game || session.game->gameOver) continue;
+        if (now - session.lastActive < idleAfter) continue;
+        if (spill(candidate.first, session)) ++evicted;
+    }
+    return evicted;
+}
+
+bool SessionManager::spill(uint64_t id, Session& session) {
+    TRACE_SCOPE("SessionManager::spill");
+    std::vector<uint8_t> state;
+    session.game->saveState(state);
+    {
+        std::lock_guard<std::mutex> lock(fileMutex);
+        if (spillFd < 0) return false;
+        ssize_t written = ::pwrite(spillFd, state.data(), state.size(), static_cast<off_t>(fileBytes));
+        if (written != static_cast<ssize_t>(state.size())) return false;
+        records[id] = Record{fileBytes, static_cast<uint32_t>(state.size())};
+        fileBytes += state.size();
+        liveBytes += state.size();
+    }
+    pool.release(std::move(session.game));
+    return true;
+}
+
+bool SessionManager::rehydrate(uint64_t id, Session& session) {
+    TRACE_SCOPE("SessionManager::rehydrate");
+    std::vector<uint8_t> state;
+    {
+        std::lock_guard<std::mutex> lock(fileMutex);
+        auto it = records.find(id);
+        if (it == records.end() || spillFd < 0) return false;
+        state.resize(it->second.length);
+        ssize_t got = ::pread(spillFd, state.data(), state.size(), static_cast<off_t>(it->second.offset));
+        if (got != static_cast<ssize_t>(state.size())) return false;
+    }
+
+    std::unique_ptr<Game> game = pool.acquire(*session.out, session.typewriterDelayMs);
+    if (!game->restoreState(state.data(), state.size())) {
+        pool.release(std::move(game));
+        return false;
+    }
+    session.game = std::move(game);
+    forget(id);
+    return true;
+}
+
+void SessionManager::forget(uint64_t id) {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    auto it = records.find(id);
+    if (it == records.end()) return;
+    liveBytes -= it->second.length;
+    records.erase(it);
+
+    uint64_t garbage = fileBytes - liveBytes;
+    if (records.empty()) {
+        // Nothing live: start the file over instead of copying
+        if (spillFd >= 0 && ::ftruncate(spillFd, 0) == 0) fileBytes = 0;
+    } else if (garbage >= kCompactBytes && garbage > liveBytes) {
+        compactLocked();
+    }
+}
+
+// Copies the live records to a new file and swaps it in. If anything fails the old file stays
+void SessionManager::compactLocked() {
+    std::string tempPath = spillPath + ".compact";
+    int fd = ::open(tempPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) return;
+
+    std::unordered_map<uint64_t, Record> moved;
+    moved.reserve(records.size());
+    std::vector<uint8_t> buffer;
+    uint64_t offset = 0;
+    for (const auto& entry : records) {
+        buffer.resize(entry.second.length);
+        if (::pread(spillFd, buffer.data(), buffer.size(), static_cast<off_t>(entry.second.offset)) != static_cast<ssize_t>(buffer.size()) ||
+            ::pwrite(fd, buffer.data(), buffer.size(), static_cast<off_t>(offset)) != static_cast<ssize_t>(buffer.size())) {
+            ::close(fd);
+            std::remove(tempPath.c_str());
+            return;
+        }
+        moved[entry.first] = Record{offset, entry.second.length};
+        offset += buffer.size();
+    }
+    if (std::rename(tempPath.c_str(), spillPath.c_str()) != 0) {
+        ::close(fd);
+        std::remove(tempPath.c_str());
+        return;
+    }
+    ::close(spillFd);
+    spillFd = fd;
+    records.swap(moved);
+    fileBytes = offset;
+}
+
+size_t SessionManager::residentCount() const {
+    std::lock_guard<std::mutex> lock(sessionsMutex);
+    std::lock_guard<std::mutex> files(fileMutex);
+    return sessions.size() - records.size();
+}
+
+size_t SessionManager::spilledCount() const {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    return records.size();
+}
+
+uint64_t SessionManager::spillFileBytes() const {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    return fileBytes;
+}
+
+void SessionManager::sweepLoop() {
+    std::unique_lock<std::mutex> lock(stopMutex);
+    while (!stopSignal.wait_for(lock, sweepInterval, [this] { return stopping; })) {
+        lock.unlock();
+        evictIdle();
+        lock.lock();
+    }
+}
@@ -0,0 +1,86 @@
+#include "SessionPool.h"
+#include <random>
+
+// The game every session is copied from. Copies share its message catalog and content store
+static Game makePrototype(std::ostream& discard, const MessageCatalog* messages, const ContentStore* content) {
+    Game game(discard, 0);
+    if (messages) game.attachMessages(messages);
+    if (content) game.attachContent(content);
+    return game;
+}
+
+// Constructor
+SessionPool::SessionPool(size_t prewarmCount, size_t maxIdle, const MessageCatalog* messages, const ContentStore* content)
+    : discard(nullptr),
+    content(content),
+    prototype(makePrototype(discard, messages, content)),
+    nextSeed(std::random_device()()),
+    maxIdle(maxIdle) {
+    idle.reserve(std::min(prewarmCount, maxIdle));
+    prewarm(prewarmCount);
+}
+
+// Returns a fresh session, recycled if possible
+std::unique_ptr<Game> SessionPool::acquire(std::ostream& output, int typewriterDelayMs) {
+    std::unique_ptr<Game> game;
+    {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        if (!idle.empty()) {
+            game = std::move(idle.back());
+            idle.pop_back();
+        }
+    }
+    // Copying the prototype happens outside the lock so concurrent acquires don't serialize on it
+    if (!game) {
+        game = std::make_unique<Game>(prototype);
+    }
+    game->redirectOutput(output, typewriterDelayMs);
+    game->guide.seed(nextSeed.fetch_add(0x9E3779B9u, std::memory_order_relaxed));
+    return game;
+}
+
+// Takes back a session for reuse
+void SessionPool::release(std::unique_ptr<Game> game) {
+    if (!game) return;
+    game->reset();
+    // Nothing of the last client's may reach the next one: its recorder, event writer or content store
+    game->attachEvents(nullptr);
+    game->attachContent(content);
+    game->attachRecorder(nullptr, 0);
+    game->redirectOutput(discard, 0);
+
+    std::lock_guard<std::mutex> lock(idleMutex);
+    if (idle.size() < maxIdle) {
+        idle.push_back(std::move(game));
+        return;
+    }
+    // Pool is full: the session is destroyed when 'game' goes out of scope, after the lock is released
+}
+
+// Fills the idle list up to 'count' sessions
+void SessionPool::prewarm(size_t count) {
+    count = std::min(count, maxIdle);
+    size_t missing = 0;
+    {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        missing = count > idle.size() ? count - idle.size() : 0;
+    }
+    if (missing == 0) return;
+
+    std::vector<std::unique_ptr<Game>> fresh;
+    fresh.reserve(missing);
+    for (size_t i = 0; i < missing; ++i) {
+        fresh.push_back(std::make_unique<Game>(prototype));
+    }
+
+    std::lock_guard<std::mutex> lock(idleMutex);
+    for (auto& game : fresh) {
+        if (idle.size() >= maxIdle) break;
+        idle.push_back(std::move(game));
+    }
+}
+
+size_t SessionPool::idleCount() const {
+    std::lock_guard<std::mutex> lock(idleMutex);
+    return idle.size();
+}
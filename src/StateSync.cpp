@@ -0,0 +1,118 @@
+#include "StateSync.h"
+#include "Game.h"
+#include <algorithm>
+
+// Constructor
+StateSync::StateSync()
+    : sentVersion(0),
+    ackedVersion(0),
+    changedState(false),
+    changedLocation(false),
+    changedInventory(false) {}
+
+// Compares the game with the last version sent and, if it moved on, prepares the next delta
+bool StateSync::update(const Game& game) {
+    prepare(game);
+    capture(game);
+    if (sentVersion > 0 && sameAsSent()) return false;
+
+    collectChanges();
+    // Assignments between equally sized vectors reuse their storage
+    sent = current;
+    ++sentVersion;
+    return true;
+}
+
+bool StateSync::acknowledge(uint64_t version) {
+    if (version == 0 || version != sentVersion) return false;
+    acked = sent;
+    ackedVersion = version;
+    return true;
+}
+
+bool StateSync::elementChanged(uint32_t room, uint32_t element) const {
+    return elementsToSend[elementOffsets[room] + element] != 0;
+}
+
+void StateSync::prepare(const Game& game) {
+    size_t rooms = game.allRooms.size();
+    size_t elements = 0;
+    for (const auto& room : game.allRooms) elements += room->elements.size();
+    if (elementOffsets.size() == rooms + 1 && elementOffsets.back() == elements) return;
+
+    elementOffsets.assign(rooms + 1, 0);
+    for (size_t i = 0; i < rooms; ++i) {
+        elementOffsets[i + 1] = elementOffsets[i] + static_cast<uint32_t>(game.allRooms[i]->elements.size());
+    }
+    for (Snapshot* snapshot : {&current, &sent, &acked}) {
+        *snapshot = Snapshot();
+        snapshot->known.assign(rooms, 0);
+        snapshot->revisions.assign(rooms, ~0ull);
+        snapshot->textRevisions.assign(rooms, ~0ull);
+        snapshot->elementStates.assign(elements, ~0u);
+        snapshot->elementTexts.assign(elements, ~0u);
+    }
+    changes.reserve(rooms);
+    elementsToSend.assign(elements, 0);
+    sentVersion = 0;
+    ackedVersion = 0;
+}
+
+// Reads the current state of the game into 'current'. Rooms become known once the player is in them
+void StateSync::capture(const Game& game) {
+    current.state = static_cast<int>(game.currentGameState);
+    current.location = -1;
+    current.inventoryRevision = game.player.inventoryRevision;
+    for (size_t i = 0; i < game.allRooms.size(); ++i) {
+        const Room& room = *game.allRooms[i];
+        if (&room == game.player.currentLocation) {
+            current.location = static_cast<int>(i);
+            current.known[i] = 1;
+        }
+        current.revisions[i] = room.contentRevision;
+        current.textRevisions[i] = room.textRevision;
+        uint32_t offset = elementOffsets[i];
+        const std::vector<uint32_t>& states = room.elements.states();
+        std::copy(states.begin(), states.end(), current.elementStates.begin() + offset);
+        const std::vector<uint32_t>& texts = room.elements.textRevisions();
+        std::copy(texts.begin(), texts.end(), current.elementTexts.begin() + offset);
+    }
+}
+
+bool StateSync::sameAsSent() const {
+    return current.state == sent.state &&
+        current.location == sent.location &&
+        current.inventoryRevision == sent.inventoryRevision &&
+        current.known == sent.known &&
+        current.revisions == sent.revisions &&
+        current.textRevisions == sent.textRevisions &&
+        current.elementStates == sent.elementStates &&
+        current.elementTexts == sent.elementTexts;
+}
+
+// Decides what the new version sends, relative to both the acknowledged and the last sent version
+void StateSync::collectChanges() {
+    auto differs = [this](auto member) {
+        return current.*member != acked.*member || current.*member != sent.*member;
+    };
+    changedState = differs(&Snapshot::state);
+    changedLocation = differs(&Snapshot::location);
+    changedInventory = differs(&Snapshot::inventoryRevision);
+
+    changes.clear();
+    for (size_t i = 0; i < current.known.size(); ++i) {
+        if (!current.known[i]) continue;
+        uint32_t room = static_cast<uint32_t>(i);
+        bool full = !acked.known[i];
+        bool items = full || current.revisions[i] != acked.revisions[i] || current.revisions[i] != sent.revisions[i];
+        bool text = full || current.textRevisions[i] != acked.textRevisions[i] || current.textRevisions[i] != sent.textRevisions[i];
+        bool elements = false;
+        for (uint32_t e = elementOffsets[i]; e < elementOffsets[i + 1]; ++e) {
+            bool changed = full || current.elementStates[e] != acked.elementStates[e] || current.elementStates[e] != sent.elementStates[e] ||
+                current.elementTexts[e] != acked.elementTexts[e] || current.elementTexts[e] != sent.elementTexts[e];
+            elementsToSend[e] = changed ? 1 : 0;
+            elements = elements || changed;
+        }
+        if (full || items || text || elements) changes.push_back(RoomChange{room, full, items, text});
+    }
+}
@@ -0,0 +1,76 @@
+#include "Tracer.h"
+#include <fstream>
+#include <memory>
+
+// Fixed-size ring of spans owned by one thread. Only that thread writes 'events';
+// 'head' is published with release ordering so a dumping thread sees complete entries.
+struct Tracer::ThreadBuffer {
+    std::unique_ptr<TraceEvent[]> events;
+    std::atomic<uint64_t> head{0};
+    uint32_t threadId;
+    ThreadBuffer* next;
+
+    explicit ThreadBuffer(uint32_t threadId)
+        : events(new TraceEvent[kBufferCapacity]), threadId(threadId), next(nullptr) {}
+};
+
+// The process-wide tracer
+Tracer& Tracer::instance() {
+    static Tracer tracer;
+    return tracer;
+}
+
+void Tracer::enable() {
+    enabled.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::disable() {
+    enabled.store(false, std::memory_order_relaxed);
+}
+
+// Returns the calling thread's buffer, registering it on first use
+Tracer::ThreadBuffer& Tracer::localBuffer() {
+    // Buffers are intentionally never freed: a thread may exit before the trace is dumped
+    thread_local ThreadBuffer* local = nullptr;
+    if (!local) {
+        local = new ThreadBuffer(nextThreadId.fetch_add(1, std::memory_order_relaxed));
+        ThreadBuffer* oldHead = buffers.load(std::memory_order_relaxed);
+        do {
+            local->next = oldHead;
+        } while (!buffers.compare_exchange_weak(oldHead, local, std::memory_order_release, std::memory_order_relaxed));
+    }
+    return *local;
+}
+
+// Appends a span to the calling thread's ring buffer
+void Tracer::record(const char* name, uint64_t startNs, uint64_t endNs) {
+    ThreadBuffer& buffer = localBuffer();
+    uint64_t slot = buffer.head.load(std::memory_order_relaxed);
+    buffer.events[slot % kBufferCapacity] = TraceEvent{name, startNs, endNs - startNs};
+    buffer.head.store(slot + 1, std::memory_order_release);
+}
+
+// Writes every buffered span as Chrome trace-event JSON ("X" complete events, microsecond timestamps)
+bool Tracer::dump(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    file << "{\"traceEvents\":[\n";
+    bool first = true;
+    for (ThreadBuffer* buffer = buffers.load(std::memory_order_acquire); buffer; buffer = buffer->next) {
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        uint64_t begin = head > kBufferCapacity ? head - kBufferCapacity : 0;
+        for (uint64_t i = begin; i < head; ++i) {
+            const TraceEvent& event = buffer->events[i % kBufferCapacity];
+            if (!first) file << ",\n";
+            first = false;
+            file << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId
+                 << ",\"ts\":" << event.startNs / 1000 << "." << (event.startNs % 1000) / 100
+                 << ",\"dur\":" << event.durationNs / 1000 << "." << (event.durationNs % 1000) / 100 << "}";
+        }
+    }
+    file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return static_cast<bool>(file);
+}
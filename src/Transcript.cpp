@@ -0,0 +1,235 @@
+#include "Transcript.h"
+
+namespace {
+
+const char kFileMagic[4] = {'V', 'C', 'T', 'R'};
+const char kBlockMagic[4] = {'V', 'C', 'B', 'K'};
+const uint8_t kFormatVersion = 1;
+const size_t kFileHeaderBytes = 8;
+
+void appendBytes(std::vector<uint8_t>& out, const void* bytes, size_t count) {
+    const uint8_t* p = static_cast<const uint8_t*>(bytes);
+    out.insert(out.end(), p, p + count);
+}
+
+// Fixed-width little-endian integers, independent of the host's byte order
+void storeLittle(uint8_t* out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) out[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+uint64_t loadLittle(const uint8_t* in, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) value |= static_cast<uint64_t>(in[i]) << (8 * i);
+    return value;
+}
+
+void encodeBlockHeader(const TranscriptBlockHeader& header, uint8_t* out) {
+    std::memcpy(out, header.magic, sizeof(header.magic));
+    storeLittle(out + 4, header.recordCount, 4);
+    storeLittle(out + 8, header.symbolBytes, 4);
+    storeLittle(out + 12, header.recordBytes, 4);
+    storeLittle(out + 16, header.indexBytes, 4);
+    storeLittle(out + 20, header.reserved, 4);
+    storeLittle(out + 24, header.baseTimestampMs, 8);
+}
+
+void decodeBlockHeader(const uint8_t* in, TranscriptBlockHeader& header) {
+    std::memcpy(header.magic, in, sizeof(header.magic));
+    header.recordCount = static_cast<uint32_t>(loadLittle(in + 4, 4));
+    header.symbolBytes = static_cast<uint32_t>(loadLittle(in + 8, 4));
+    header.recordBytes = static_cast<uint32_t>(loadLittle(in + 12, 4));
+    header.indexBytes = static_cast<uint32_t>(loadLittle(in + 16, 4));
+    header.reserved = static_cast<uint32_t>(loadLittle(in + 20, 4));
+    header.baseTimestampMs = loadLittle(in + 24, 8);
+}
+
+} // namespace
+
+// --- TranscriptWriter ---
+
+// Constructor
+TranscriptWriter::TranscriptWriter(const std::string& path)
+    : symbolBytes(0),
+    recordCount(0),
+    baseTimestampMs(0),
+    lastTimestampMs(0),
+    lastSessionId(0) {
+    bool isNew = true;
+    {
+        std::ifstream existing(path, std::ios::binary | std::ios::ate);
+        isNew = !existing || existing.tellg() <= 0;
+    }
+    file.open(path, std::ios::binary | std::ios::app);
+    if (file && isNew) {
+        char header[kFileHeaderBytes] = {kFileMagic[0], kFileMagic[1], kFileMagic[2], kFileMagic[3],
+                                         static_cast<char>(kFormatVersion), 0, 0, 0};
+        file.write(header, sizeof(header));
+    }
+    records.reserve(kMaxBlockBytes);
+}
+
+TranscriptWriter::~TranscriptWriter() {
+    flush();
+}
+
+// Records one command into the current block
+void TranscriptWriter::record(uint64_t sessionId, uint64_t timestampMs, GameState state, const std::vector<std::string>& words) {
+    if (words.empty()) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // The noun is everything after the verb, e.g. "to guide" for "talk to guide"
+    uint32_t noun = 0;
+    if (words.size() > 1) {
+        nounScratch.clear();
+        for (size_t w = 1; w < words.size(); ++w) {
+            if (w > 1) nounScratch.push_back(' ');
+            nounScratch += words[w];
+        }
+        auto it = symbolIds.find(nounScratch);
+        if (it == symbolIds.end()) {
+            it = symbolIds.emplace(nounScratch, static_cast<uint32_t>(symbols.size())).first;
+            symbols.push_back(nounScratch);
+            symbolBytes += nounScratch.size() + 5;
+        }
+        noun = it->second + 1;
+    }
+
+    appendLocked(sessionId, timestampMs, state, verbFromWord(words[0]), noun);
+}
+
+void TranscriptWriter::recordEnding(uint64_t sessionId, uint64_t timestampMs, GameState ending) {
+    std::lock_guard<std::mutex> lock(mutex);
+    appendLocked(sessionId, timestampMs, ending, Verb::Ended, 0);
+}
+
+void TranscriptWriter::recordEndingUndone(uint64_t sessionId, uint64_t timestampMs, GameState state) {
+    std::lock_guard<std::mutex> lock(mutex);
+    appendLocked(sessionId, timestampMs, state, Verb::EndingUndone, 0);
+}
+
+// Encodes one record into the current block
+void TranscriptWriter::appendLocked(uint64_t sessionId, uint64_t timestampMs, GameState state, Verb verb, uint32_t noun) {
+    if (recordCount == 0) {
+        baseTimestampMs = timestampMs;
+        lastTimestampMs = timestampMs;
+        lastSessionId = 0;
+    }
+
+    auto entry = sessionIndex.find(sessionId);
+    if (entry == sessionIndex.end()) {
+        sessionIndex.emplace(sessionId, std::make_pair(static_cast<uint32_t>(records.size()), 1u));
+        sessionOrder.push_back(sessionId);
+    } else {
+        ++entry->second.second;
+    }
+
+    int64_t sessionDelta = static_cast<int64_t>(sessionId - lastSessionId);
+    TranscriptReader::writeVarint(records, (static_cast<uint64_t>(sessionDelta) << 1) ^ static_cast<uint64_t>(sessionDelta >> 63));
+    TranscriptReader::writeVarint(records, timestampMs > lastTimestampMs ? timestampMs - lastTimestampMs : 0);
+    records.push_back(static_cast<uint8_t>(state));
+    TranscriptReader::writeVarint(records, static_cast<uint64_t>(verb));
+    TranscriptReader::writeVarint(records, noun);
+
+    lastSessionId = sessionId;
+    lastTimestampMs = std::max(lastTimestampMs, timestampMs);
+    ++recordCount;
+
+    if (recordCount >= kMaxBlockRecords || records.size() + symbolBytes >= kMaxBlockBytes) {
+        flushLocked();
+    }
+}
+
+void TranscriptWriter::flush() {
+    std::lock_guard<std::mutex> lock(mutex);
+    flushLocked();
+}
+
+// Serializes the buffered block and starts a new one
+void TranscriptWriter::flushLocked() {
+    if (recordCount == 0 || !file) return;
+
+    std::vector<uint8_t> symbolTable;
+    for (const auto& symbol : symbols) {
+        TranscriptReader::writeVarint(symbolTable, symbol.size());
+        appendBytes(symbolTable, symbol.data(), symbol.size());
+    }
+    std::vector<uint8_t> index;
+    TranscriptReader::writeVarint(index, sessionOrder.size());
+    for (uint64_t id : sessionOrder) {
+        const auto& entry = sessionIndex[id];
+        TranscriptReader::writeVarint(index, id);
+        TranscriptReader::writeVarint(index, entry.first);
+        TranscriptReader::writeVarint(index, entry.second);
+    }
+
+    TranscriptBlockHeader header{};
+    std::memcpy(header.magic, kBlockMagic, sizeof(kBlockMagic));
+    header.recordCount = recordCount;
+    header.symbolBytes = static_cast<uint32_t>(symbolTable.size());
+    header.recordBytes = static_cast<uint32_t>(records.size());
+    header.indexBytes = static_cast<uint32_t>(index.size());
+    header.baseTimestampMs = baseTimestampMs;
+
+    uint8_t encoded[TranscriptBlockHeader::kEncodedSize];
+    encodeBlockHeader(header, encoded);
+    file.write(reinterpret_cast<const char*>(encoded), sizeof(encoded));
+    file.write(reinterpret_cast<const char*>(symbolTable.data()), static_cast<std::streamsize>(symbolTable.size()));
+    file.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(records.size()));
+    file.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size()));
+    file.flush();
+
+    records.clear();
+    symbols.clear();
+    symbolIds.clear();
+    symbolBytes = 0;
+    sessionIndex.clear();
+    sessionOrder.clear();
+    recordCount = 0;
+}
+
+// --- TranscriptReader ---
+
+// Constructor
+TranscriptReader::TranscriptReader(const uint8_t* data, size_t size)
+    : data(data), size(size), offset(kFileHeaderBytes), valid(false) {
+    valid = size >= kFileHeaderBytes && std::memcmp(data, kFileMagic, sizeof(kFileMagic)) == 0 && data[4] == kFormatVersion;
+}
+
+// Advances to the next complete block
+bool TranscriptReader::nextBlock(Block& block) {
+    if (!valid || offset + TranscriptBlockHeader::kEncodedSize > size) return false;
+
+    TranscriptBlockHeader header;
+    decodeBlockHeader(data + offset, header);
+    if (std::memcmp(header.magic, kBlockMagic, sizeof(kBlockMagic)) != 0) return false;
+
+    uint64_t bodyBytes = static_cast<uint64_t>(header.symbolBytes) + header.recordBytes + header.indexBytes;
+    if (offset + TranscriptBlockHeader::kEncodedSize + bodyBytes > size) return false; // Torn final block
+
+    block.header = header;
+    block.fileOffset = offset;
+    block.symbols = data + offset + TranscriptBlockHeader::kEncodedSize;
+    block.records = block.symbols + header.symbolBytes;
+    block.index = block.records + header.recordBytes;
+    offset += TranscriptBlockHeader::kEncodedSize + bodyBytes;
+    return true;
+}
+
+bool TranscriptReader::readVarint(const uint8_t*& p, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t byte = *p++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+void TranscriptReader::writeVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
@@ -0,0 +1,27 @@
+#include "TriggerTable.h"
+#include <functional>
+
+// Constructor
+TriggerTable::TriggerTable(const WorldTrigger* rules, size_t count) : rules(rules), count(count) {
+    for (size_t i = 0; i < count; ++i) {
+        const WorldTrigger& rule = rules[i];
+        buckets[key(rule.event, rule.room, rule.subject, rule.anyState, rule.state)].push_back(static_cast<uint32_t>(i));
+        if (rule.event == TriggerEvent::Use && !rule.subject.empty() && !rule.needsCarried) inPlace.insert(rule.subject);
+    }
+}
+
+// An empty room or subject is the wildcard
+uint64_t TriggerTable::key(TriggerEvent event, std::string_view room, std::string_view subject, bool anyState,
+                           GameState state) {
+    uint64_t seed = static_cast<uint64_t>(event) << 32 | (anyState ? 0xFFFFu : static_cast<uint32_t>(state));
+    for (size_t part : {std::hash<std::string_view>{}(room), std::hash<std::string_view>{}(subject)}) {
+        seed ^= part + 0x9E3779B97F4A7C15ull + (seed << 6) + (seed >> 2);
+    }
+    return seed;
+}
+
+bool TriggerTable::matches(const WorldTrigger& rule, TriggerEvent event, std::string_view room,
+                           std::string_view subject, GameState state) {
+    return rule.event == event && (rule.room.empty() || rule.room == room) &&
+        (rule.subject.empty() || rule.subject == subject) && (rule.anyState || rule.state == state);
+}
@@ -0,0 +1,61 @@
+#include "UndoLog.h"
+
+// Constructor
+UndoLog::UndoLog(size_t capacity)
+    : ringCapacity(capacity), head(0), count(0), openRecords(0), stepCount(0), overflowed(false) {}
+
+void UndoLog::push(const UndoRecord& record) {
+    if (ringCapacity == 0 || overflowed) return;
+    if (ring.empty()) ring.resize(ringCapacity);
+    if (count == ringCapacity) {
+        if (stepCount == 0) {
+            // The open step alone fills the ring
+            overflowed = true;
+            return;
+        }
+        dropOldestStep();
+    }
+    at(count++) = record;
+    ++openRecords;
+}
+
+void UndoLog::endStep() {
+    if (overflowed) {
+        clear();
+        return;
+    }
+    if (openRecords == 0) return;
+    if (count == ringCapacity) {
+        if (stepCount == 0) {
+            clear();
+            return;
+        }
+        dropOldestStep();
+    }
+    at(count++) = UndoRecord{UndoKind::Step, 0, 0, 0};
+    openRecords = 0;
+    ++stepCount;
+}
+
+void UndoLog::clear() {
+    head = 0;
+    count = 0;
+    openRecords = 0;
+    stepCount = 0;
+    overflowed = false;
+}
+
+UndoRecord UndoLog::pop() {
+    return at(--count);
+}
+
+// Removes records from the front up to and including the first step marker
+void UndoLog::dropOldestStep() {
+    while (count > 0) {
+        UndoKind kind = ring[head].kind;
+        head = (head + 1) % ringCapacity;
+        --count;
+        if (kind == UndoKind::Step) break;
+    }
+    --stepCount;
+}
@@ -0,0 +1,275 @@
+#include "VectorEnv.h"
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+// Constructor
+VectorEnv::VectorEnv(size_t numEnvs, size_t numThreads, bool captureText)
+    : captureText(captureText),
+    baseSeed(0),
+    numParts(1),
+    currentJob(nullptr),
+    jobGeneration(0),
+    workersPending(0),
+    shuttingDown(false) {
+    // Each game writes to its own stream so workers never share stream state
+    streams.reserve(numEnvs);
+    games.reserve(numEnvs);
+    for (size_t i = 0; i < numEnvs; ++i) {
+        if (captureText) {
+            streams.push_back(std::make_unique<std::ostringstream>());
+        } else {
+            streams.push_back(std::make_unique<std::ostream>(nullptr)); // No buffer: output is discarded
+        }
+        games.emplace_back(*streams[i], 0);
+    }
+
+    if (!games.empty()) {
+        buildActionTable(games.front());
+    }
+
+    obs.resize(numEnvs);
+    rewardBuf.assign(numEnvs, 0.0f);
+    terminalBuf.assign(numEnvs, 0);
+    maskBuf.assign(numEnvs * actions.size(), 0);
+
+    if (numThreads == 0) {
+        numThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    numThreads = std::min(numThreads, std::max<size_t>(1, numEnvs));
+    // The calling thread takes the first share of every step, so spawn one fewer worker
+    numParts = numThreads;
+    for (size_t w = 1; w < numThreads; ++w) {
+        workers.emplace_back(&VectorEnv::workerLoop, this, w);
+    }
+
+    for (size_t i = 0; i < games.size(); ++i) {
+        observe(i);
+    }
+}
+
+VectorEnv::~VectorEnv() {
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        shuttingDown = true;
+    }
+    workReady.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+// @brief Builds the fixed action table from the exits, items and elements of a freshly set up world
+void VectorEnv::buildActionTable(const Game& prototype) {
+    std::set<std::string> exitKeys;
+    std::set<std::string> itemIds;
+    std::set<std::string> elementNames;
+    for (const auto& room : prototype.allRooms) {
+        for (const auto& exit : room->exits) exitKeys.insert(exit.first);
+        for (const auto& item : room->items) if (item) itemIds.insert(item->id);
+        for (uint32_t e = 0; e < room->elements.size(); ++e) elementNames.insert(room->elements.name(e));
+    }
+    // The surgical item only spawns mid-game, so it is not in the initial world
+    itemIds.insert("surgical_item");
+
+    auto add = [this](Action::Kind kind, const std::string& text) {
+        Action action{kind, {}};
+        std::istringstream ss(text);
+        std::string word;
+        while (ss >> word) action.words.push_back(word);
+        actions.push_back(std::move(action));
+        actionTexts.push_back(text);
+    };
+
+    add(Action::Kind::Look, "look");
+    add(Action::Kind::Inventory, "inventory");
+    add(Action::Kind::Talk, "talk to guide");
+    add(Action::Kind::Clean, "clean memorial");
+    add(Action::Kind::Organize, "organize archives");
+    add(Action::Kind::Trim, "trim garden");
+    add(Action::Kind::UseCandle, "use candle");
+    add(Action::Kind::Leave, "leave");
+    add(Action::Kind::Assist, "assist");
+    for (const auto& key : exitKeys) add(Action::Kind::Go, "go " + key);
+    for (const auto& id : itemIds) add(Action::Kind::Get, "get " + id);
+    for (const auto& id : itemIds) add(Action::Kind::Examine, "examine " + id);
+    for (const auto& name : elementNames) add(Action::Kind::Examine, "examine " + name);
+
+    trackedItems.assign(itemIds.begin(), itemIds.end());
+}
+
+// Starts a fresh episode in every environment
+void VectorEnv::reset(uint32_t seed) {
+    baseSeed = seed;
+    parallelFor([this](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            resetEnv(i);
+            rewardBuf[i] = 0.0f;
+            terminalBuf[i] = 0;
+            observe(i);
+        }
+    });
+}
+
+// Applies one action to every environment
+void VectorEnv::step(const std::vector<int>& actionIndices) {
+    if (actionIndices.size() != games.size()) {
+        throw std::invalid_argument("VectorEnv::step: expected one action per environment");
+    }
+    for (int a : actionIndices) {
+        if (a < 0 || static_cast<size_t>(a) >= actions.size()) {
+            throw std::out_of_range("VectorEnv::step: action index out of range");
+        }
+    }
+
+    parallelFor([this, &actionIndices](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (captureText) {
+                static_cast<std::ostringstream&>(*streams[i]).str(std::string());
+            }
+            rewardBuf[i] = 0.0f;
+
+            // Episodes that ended on the previous step restart instead of acting
+            if (terminalBuf[i]) {
+                terminalBuf[i] = 0;
+                resetEnv(i);
+                observe(i);
+                continue;
+            }
+
+            Game& game = games[i];
+            game.executeCommand(actions[actionIndices[i]].words);
+            if (game.gameOver) {
+                terminalBuf[i] = 1;
+                switch (game.endingReached) {
+                    case GameState::ENDING_GOOD_ESCAPED: rewardBuf[i] = kRewardEscaped; break;
+                    case GameState::ENDING_NOT_WORTHY: rewardBuf[i] = kRewardNotWorthy; break;
+                    case GameState::ENDING_BAD_VICTIM: rewardBuf[i] = kRewardVictim; break;
+                    default: break;
+                }
+            }
+            observe(i);
+        }
+    });
+}
+
+std::string VectorEnv::text(size_t env) const {
+    if (!captureText || env >= streams.size()) return std::string();
+    return static_cast<const std::ostringstream&>(*streams[env]).str();
+}
+
+// Restarts one game in place
+void VectorEnv::resetEnv(size_t env) {
+    games[env].reset();
+    games[env].guide.seed(baseSeed + static_cast<uint32_t>(env));
+}
+
+// Fills the observation and action mask for one environment
+void VectorEnv::observe(size_t env) {
+    const Game& game = games[env];
+    EnvObservation& o = obs[env];
+    o.state = game.currentGameState;
+    o.ending = game.endingReached;
+    o.roomIndex = -1;
+    for (size_t r = 0; r < game.allRooms.size(); ++r) {
+        if (game.allRooms[r].get() == game.player.currentLocation) {
+            o.roomIndex = static_cast<int32_t>(r);
+            break;
+        }
+    }
+    o.inventoryMask = 0;
+    for (const auto& item : game.player.inventory) {
+        for (size_t b = 0; b < trackedItems.size() && b < 32; ++b) {
+            if (item && item->id == trackedItems[b]) {
+                o.inventoryMask |= (1u << b);
+                break;
+            }
+        }
+    }
+
+    // A finished game restarts on its next step whatever the action, so every action is allowed
+    uint8_t* mask = maskBuf.data() + env * actions.size();
+    for (size_t a = 0; a < actions.size(); ++a) {
+        mask[a] = (game.gameOver || isLegal(game, actions[a])) ? 1 : 0;
+    }
+}
+
+// @brief Whether an action would currently do something, mirroring the checks in the Game's handlers
+bool VectorEnv::isLegal(const Game& game, const Action& action) const {
+    Room* room = game.player.currentLocation;
+    static const std::string kNowhere;
+    const std::string& roomId = room ? room->id : kNowhere;
+    GameState state = game.currentGameState;
+
+    switch (action.kind) {
+        case Action::Kind::Look:
+        case Action::Kind::Inventory:
+            return true;
+        case Action::Kind::Go:
+            return room && room->exits.count(action.words[1]) && game.exitLockMessage(action.words[1]).empty();
+        case Action::Kind::Get:
+            return room && room->getItem(action.words[1]);
+        case Action::Kind::Examine:
+            return (room && (room->getItem(action.words[1]) || room->getInteractiveElement(action.words[1]))) ||
+                   game.player.getItemFromInventory(action.words[1]);
+        case Action::Kind::Talk:
+            return roomId == "main_hall";
+        case Action::Kind::Clean:
+            return roomId == "main_hall" && state == GameState::AWAITING_TASK_1 && !game.player.hasCleanedMemorial;
+        case Action::Kind::Organize:
+            return roomId == "storage_room" && state == GameState::AWAITING_TASK_2 && !game.player.hasOrganizedArchives;
+        case Action::Kind::Trim:
+            return roomId == "west_wing" && state == GameState::AWAITING_TASK_3 && !game.player.hasTrimmedGarden;
+        case Action::Kind::UseCandle:
+            return roomId == "office" && state == GameState::AWAITING_TASK_4;
+        case Action::Kind::Leave:
+        case Action::Kind::Assist:
+            return state == GameState::CHOICE_POINT_LEAVE_OR_HELP;
+    }
+    return false;
+}
+
+// Splits [0, size()) into one contiguous share per thread and runs them concurrently
+void VectorEnv::parallelFor(const std::function<void(size_t, size_t)>& fn) {
+    const size_t n = games.size();
+    if (workers.empty()) {
+        fn(0, n);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        currentJob = &fn;
+        workersPending = workers.size();
+        ++jobGeneration;
+    }
+    workReady.notify_all();
+
+    fn(0, n / numParts);
+
+    std::unique_lock<std::mutex> lock(poolMutex);
+    workDone.wait(lock, [this] { return workersPending == 0; });
+    currentJob = nullptr;
+}
+
+void VectorEnv::workerLoop(size_t workerIndex) {
+    uint64_t seenGeneration = 0;
+    for (;;) {
+        const std::function<void(size_t, size_t)>* job = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(poolMutex);
+            workReady.wait(lock, [this, seenGeneration] { return shuttingDown || jobGeneration != seenGeneration; });
+            if (shuttingDown) return;
+            seenGeneration = jobGeneration;
+            job = currentJob;
+        }
+
+        const size_t n = games.size();
+        (*job)(n * workerIndex / numParts, n * (workerIndex + 1) / numParts);
+
+        std::lock_guard<std::mutex> lock(poolMutex);
+        if (--workersPending == 0) {
+            workDone.notify_one();
+        }
+    }
+}
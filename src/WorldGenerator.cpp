@@ -0,0 +1,82 @@
+#include "WorldGenerator.h"
+#include <random>
+
+namespace {
+
+// Word pools for room and item text, so descriptions have realistic lengths without being identical
+const char* const kAdjectives[] = {"dusty", "dim", "narrow", "echoing", "cold", "faded", "cluttered", "silent"};
+const char* const kPlaces[] = {"gallery", "corridor", "archive", "workshop", "alcove", "stairwell", "annex", "exhibit hall"};
+const char* const kObjects[] = {"ticket stub", "brass key", "postcard", "lantern", "ledger", "pocket watch", "map", "candle"};
+
+template <size_t N>
+const char* pick(const char* const (&pool)[N], std::mt19937& rng) {
+    return pool[rng() % N];
+}
+
+} // namespace
+
+// Constructor
+WorldGenerator::WorldGenerator(const WorldSpec& spec) : spec(spec) {}
+
+// Creates the rooms, then wires up the exits once every room exists
+std::vector<std::unique_ptr<Room>> WorldGenerator::generate() const {
+    std::vector<std::unique_ptr<Room>> rooms;
+    if (spec.roomCount == 0) return rooms;
+    rooms.reserve(spec.roomCount);
+
+    std::mt19937 rng(spec.seed);
+    std::vector<std::string> elementDescriptions;
+    for (size_t i = 0; i < spec.roomCount; ++i) {
+        std::string adjective = pick(kAdjectives, rng);
+        std::string place = pick(kPlaces, rng);
+        auto room = std::make_unique<Room>(roomId(i), "The " + adjective + " " + place + " " + std::to_string(i),
+            "A " + adjective + " " + place + ". Display cases line the walls and the air smells of old paper and floor wax.");
+
+        room->items.reserve(spec.itemsPerRoom);
+        for (size_t k = 0; k < spec.itemsPerRoom; ++k) {
+            std::string object = pick(kObjects, rng);
+            room->addItem(std::make_unique<Item>(itemId(i, k), "A " + object,
+                "A " + std::string(pick(kAdjectives, rng)) + " " + object + ", left behind by some earlier visitor."));
+        }
+
+        for (size_t k = 0; k < spec.elementsPerRoom; ++k) {
+            elementDescriptions.clear();
+            for (size_t d = 0; d < spec.descriptionsPerElement; ++d) {
+                elementDescriptions.push_back("The display looks " + std::string(pick(kAdjectives, rng)) + " (state " + std::to_string(d) + ").");
+            }
+            room->addInteractiveElement(InteractiveElement(elementName(k), elementDescriptions));
+        }
+        rooms.push_back(std::move(room));
+    }
+
+    size_t count = spec.roomCount;
+    size_t passages = spec.exitsPerRoom > 2 ? spec.exitsPerRoom - 2 : 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (count > 1 && spec.exitsPerRoom > 0) {
+            rooms[i]->addExit("forward", rooms[(i + 1) % count].get());
+            if (spec.exitsPerRoom > 1) {
+                rooms[i]->addExit("back", rooms[(i + count - 1) % count].get());
+            }
+        }
+        for (size_t k = 0; k < passages; ++k) {
+            rooms[i]->addExit(passageExit(k), rooms[rng() % count].get());
+        }
+    }
+    return rooms;
+}
+
+std::string WorldGenerator::roomId(size_t roomIndex) {
+    return "room_" + std::to_string(roomIndex);
+}
+
+std::string WorldGenerator::itemId(size_t roomIndex, size_t itemIndex) {
+    return "item_" + std::to_string(roomIndex) + "_" + std::to_string(itemIndex);
+}
+
+std::string WorldGenerator::elementName(size_t elementIndex) {
+    return "element_" + std::to_string(elementIndex);
+}
+
+std::string WorldGenerator::passageExit(size_t passageIndex) {
+    return "passage_" + std::to_string(passageIndex);
+}
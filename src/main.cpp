@@ -1,18 +1,204 @@
 #include "Game.h"
+#include "Tracer.h"
+#include "Transcript.h"
+#include "EventStream.h"
+#include "ContentStore.h"
+#include "GameServer.h"
+#include <memory>
+#include <random>
 #include <iostream>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
+#include <csignal>
+#include <unistd.h>
+#include <sys/resource.h>
 
-int main() {
-    // Seed random number generator 
+namespace {
+
+GameServer* runningServer = nullptr;
+
+void stopServer(int) {
+    if (runningServer) runningServer->stop();
+}
+
+// Starts publishing the text in 'path' on top of the built-in (or translated) text, reloading it whenever it changes
+void watchContent(const std::string& path, const MessageCatalog* messages,
+                  std::unique_ptr<ContentStore>& store, std::unique_ptr<ContentWatcher>& watcher) {
+    std::ostream quiet(nullptr);
+    Game original(quiet, 0);
+    if (messages) original.attachMessages(messages);
+    std::unique_ptr<ContentSnapshot> builtIn = ContentSnapshot::fromGame(original);
+    const ContentSnapshot base = *builtIn;
+    store = std::make_unique<ContentStore>(std::move(builtIn));
+    watcher = std::make_unique<ContentWatcher>(*store, path, base);
+    std::string error;
+    if (!watcher->reloadNow(&error)) {
+        std::cerr << "Using built-in content: " << error << std::endl;
+    }
+}
+
+void dumpTrace(const std::string& traceFile) {
+    if (traceFile.empty()) return;
+    if (Tracer::instance().dump(traceFile)) {
+        std::cerr << "Trace written to " << traceFile << std::endl;
+    } else {
+        std::cerr << "Could not write trace to " << traceFile << std::endl;
+    }
+}
+
+// Serves sessions over TCP until interrupted (see include/GameServer.h)
+int serve(uint16_t port, const std::string& spillFile, int idleSeconds, const MessageCatalog* messages,
+          const ContentStore* content) {
+    // One descriptor per connected player
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    SessionPool pool(64, 1024, messages, content);
+    SessionManager sessions(pool, spillFile, std::chrono::seconds(idleSeconds), std::chrono::seconds(1));
+    GameServer server(sessions);
+    std::string error;
+    if (!server.listen(port, &error)) {
+        std::cerr << "Could not listen on port " << port << ": " << error << std::endl;
+        return 1;
+    }
+    if (!sessions.canSpill()) {
+        std::cerr << "Could not open spill file " << spillFile << "; idle sessions stay in memory" << std::endl;
+    }
+    std::cerr << "Serving on 127.0.0.1:" << server.port() << " (pid " << getpid() << ")" << std::endl;
+
+    runningServer = &server;
+    std::signal(SIGINT, stopServer);
+    std::signal(SIGTERM, stopServer);
+    server.run();
+    runningServer = nullptr;
+    std::cerr << "Stopped after " << server.commandCount() << " commands (" << server.pauseCount()
+              << " backpressure pauses)" << std::endl;
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    // Optional: '--trace <file>' records a timeline of the session as Chrome trace-event JSON
+    // Optional: '--record <file>' appends every command of this session to a binary transcript archive
+    // Optional: '--json' prints JSON-lines events (see include/EventStream.h) instead of prose, for bots;
+    //           '--deltas' additionally syncs state as acknowledged deltas instead of full room views
+    // Optional: '--content <file>' overrides room, element, dialogue and help text, and reloads the file when it changes
+    // Optional: '--serve <port>' runs one session per TCP connection on 127.0.0.1 instead of playing here;
+    //           '--spill <file>' and '--idle <seconds>' control where and when idle sessions are spilled.
+    //           '--content', '--locale' and '--trace' apply to every session; '--json', '--deltas' and '--record' don't
+    // Optional: '--locale <catalog>' narrates from a compiled message catalog (see make catalogs)
+    std::string traceFile;
+    std::string recordFile;
+    bool jsonEvents = false;
+    bool stateDeltas = false;
+    std::string contentFile;
+    int servePort = -1;
+    std::string spillFile = "visitor_center.spill";
+    int idleSeconds = 60;
+    std::string localeFile;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            traceFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--json") == 0) {
+            jsonEvents = true;
+        } else if (std::strcmp(argv[i], "--deltas") == 0) {
+            stateDeltas = true;
+        } else if (std::strcmp(argv[i], "--content") == 0 && i + 1 < argc) {
+            contentFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+            servePort = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--spill") == 0 && i + 1 < argc) {
+            spillFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--idle") == 0 && i + 1 < argc) {
+            idleSeconds = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--locale") == 0 && i + 1 < argc) {
+            localeFile = argv[++i];
+        }
+    }
+
+    if (servePort >= 0 && (jsonEvents || stateDeltas || !recordFile.empty())) {
+        std::cerr << "--json, --deltas and --record can't be combined with --serve." << std::endl;
+        return 1;
+    }
+
+    // Seed random number generator. This comes first: every session's Guide is seeded from std::rand()
     std::srand(static_cast<unsigned int>(std::time(nullptr)));
 
+#ifdef VC_TRACE
+    if (!traceFile.empty()) Tracer::instance().enable();
+#else
+    if (!traceFile.empty()) {
+        std::cerr << "Tracing is not compiled in. Rebuild with 'make clean && make TRACE=1'." << std::endl;
+        traceFile.clear();
+    }
+#endif
+
+    // The catalog is mapped once; every session reads its lines in place
+    std::unique_ptr<MessageCatalog> messages;
+    if (!localeFile.empty()) {
+        std::string error;
+        messages = MessageCatalog::open(localeFile, &error);
+        if (!messages) std::cerr << "Using built-in text: " << error << std::endl;
+    }
+
+    // Content starts from the built-in text; the watcher republishes the file on every change
+    std::unique_ptr<ContentStore> contentStore;
+    std::unique_ptr<ContentWatcher> contentWatcher;
+    if (!contentFile.empty()) watchContent(contentFile, messages.get(), contentStore, contentWatcher);
+
+    if (servePort >= 0) {
+        int status = serve(static_cast<uint16_t>(servePort), spillFile, idleSeconds, messages.get(), contentStore.get());
+        dumpTrace(traceFile);
+        return status;
+    }
+
     // Create and run the game
     // The Game object's lifetime is managed here. When main ends, game_instance is destructed.
     // All unique_ptrs owned by game_instances will be cleaned up
-    Game visitorCenterGame;
+    // In JSON mode the opening room description is not printed as prose; the intro sends it as an event.
+    // A translated game starts quiet too, since it would describe the room before the catalog is attached
+    std::ostream quiet(nullptr);
+    Game visitorCenterGame(jsonEvents || messages ? quiet : std::cout);
+    if (messages) {
+        visitorCenterGame.attachMessages(messages.get());
+        if (!jsonEvents) visitorCenterGame.redirectOutput(std::cout, Game::kTypewriterDelayMs);
+    }
+
+    std::unique_ptr<EventWriter> events;
+    if (jsonEvents) {
+        events = std::make_unique<EventWriter>(std::cout);
+        if (stateDeltas) events->enableDeltas();
+        visitorCenterGame.attachEvents(events.get());
+    }
+
+    if (contentStore) visitorCenterGame.attachContent(contentStore.get());
+
+    std::unique_ptr<TranscriptWriter> recorder;
+    if (!recordFile.empty()) {
+        recorder = std::make_unique<TranscriptWriter>(recordFile);
+        if (recorder->isOpen()) {
+            std::random_device entropy;
+            uint64_t sessionId = (static_cast<uint64_t>(entropy()) << 32) | entropy();
+            visitorCenterGame.attachRecorder(recorder.get(), sessionId);
+        } else {
+            std::cerr << "Could not open transcript archive " << recordFile << std::endl;
+        }
+    }
+
     visitorCenterGame.run();
 
+    if (recorder) {
+        visitorCenterGame.attachRecorder(nullptr, 0);
+        recorder->flush();
+    }
+
+    dumpTrace(traceFile);
     return 0;
 }
-
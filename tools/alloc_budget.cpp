@@ -0,0 +1,140 @@
+// Allocation budgets for the command path.
+//
+// Usage: alloc_budget [--report]
+//
+// Plays each scenario's setup commands in a fresh game, then counts the heap allocations made by one
+// more processInput call and compares them with that command's budget. Exits with status 1 if any
+// command allocates more than its budget, so an allocation regression in parsing, Room::look,
+// cutscene text or a handler fails the build instead of showing up as latency in production.
+//
+// Scenarios marked warm run their command once before the measured call, so caches and scratch
+// buffers have reached their steady size. '--report' also lists, for every scenario, what each
+// ALLOC_SCOPE allocated; that breakdown needs a 'make clean && make allocbudget ALLOC=1' build.
+//
+// Output goes to a sink that discards characters, so formatting is measured but nothing is printed.
+
+#include "Game.h"
+#include "AllocTracker.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+// --- Heap accounting ---
+// Every allocation in the process is counted on the thread that makes it
+void* operator new(size_t size) {
+    AllocTracker::record(size);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    AllocTracker::record(size);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+// Accepts and drops everything
+class NullBuffer : public std::streambuf {
+protected:
+    int_type overflow(int_type ch) override { return traits_type::not_eof(ch); }
+    std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+};
+
+struct Scenario {
+    const char* name;
+    std::vector<const char*> setup;
+    const char* command;
+    bool warm;
+    uint64_t budget; // Allocations allowed in the measured call
+};
+
+// The walkthrough up to the point each scenario needs
+const std::vector<const char*> kInHall = {"go enter-center", "go enter"};
+const std::vector<const char*> kTask1Done = {"go enter-center", "go enter", "clean memorial"};
+const std::vector<const char*> kInStorage = {"go enter-center", "go enter", "clean memorial", "travel storage_room"};
+const std::vector<const char*> kCarrying = {"go enter-center", "go enter", "clean memorial", "travel storage_room", "get gas_can"};
+// Has walked the storage room - main hall route both ways, so the navigation table has cached it
+const std::vector<const char*> kRouteKnown = {"go enter-center", "go enter", "clean memorial", "travel storage_room", "get gas_can",
+                                              "travel main_hall", "travel storage_room"};
+
+const std::vector<Scenario> kScenarios = {
+    {"look (warm room)", kInHall, "look", true, 0},
+    {"examine element", kInHall, "examine memorial", true, 0},
+    {"examine carried item", kCarrying, "examine gas_can", true, 0},
+    {"inventory", kCarrying, "inventory", true, 0},
+    {"go (no story beat)", kInStorage, "go hall", false, 0},
+    {"travel (known route)", kRouteKnown, "travel main_hall", false, 0},
+    {"get", kInStorage, "get gas_can", false, 0},
+    {"talk to guide", kTask1Done, "talk to guide", true, 0},
+    {"clean (cutscene)", kInHall, "clean memorial", false, 0},
+    {"help", kInHall, "help", true, 0},
+    {"hint (memoized)", kInHall, "hint", true, 0},
+    {"unknown verb", kInHall, "dance", true, 0},
+    {"typo in verb", kInHall, "examin memorial", true, 0},
+    {"typo in noun", kInHall, "examine memorail", true, 0},
+    {"blank line", kInHall, "   ", true, 0},
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    bool report = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--report") == 0) {
+            report = true;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--report]" << std::endl;
+            return 1;
+        }
+    }
+    if (report && !AllocTracker::kCompiledIn) {
+        std::cerr << "(Per-scope counts need a build with ALLOC=1; showing totals only.)" << std::endl;
+    }
+
+    NullBuffer nullBuffer;
+    std::ostream sink(&nullBuffer);
+    size_t failures = 0;
+
+    std::cout << std::left << std::setw(24) << "command" << std::right << std::setw(8) << "allocs"
+              << std::setw(10) << "bytes" << std::setw(8) << "budget" << std::endl;
+    for (const Scenario& scenario : kScenarios) {
+        Game game(sink, 0);
+        for (const char* command : scenario.setup) game.processInput(command);
+        std::string command = scenario.command;
+        if (scenario.warm) game.processInput(command);
+
+        AllocTracker::reset();
+        game.processInput(command);
+        AllocCounts used = AllocTracker::totals();
+
+        bool over = used.allocations > scenario.budget;
+        failures += over ? 1 : 0;
+        std::cout << std::left << std::setw(24) << scenario.name << std::right << std::setw(8) << used.allocations
+                  << std::setw(10) << used.bytes << std::setw(8) << scenario.budget << (over ? "  OVER BUDGET" : "") << std::endl;
+        if (report || over) {
+            AllocTracker::forEachScope([](const char* scope, const AllocCounts& counts) {
+                std::cout << "    " << std::left << std::setw(20) << scope << std::right << std::setw(8)
+                          << counts.allocations << std::setw(10) << counts.bytes << std::endl;
+            });
+        }
+    }
+
+    if (failures > 0) {
+        std::cout << failures << " command(s) over their allocation budget." << std::endl;
+        return 1;
+    }
+    std::cout << "All commands within their allocation budgets." << std::endl;
+    return 0;
+}
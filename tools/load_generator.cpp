@@ -0,0 +1,434 @@
+// Synthetic players for end-to-end load tests against 'visitor_center_game --serve <port>'.
+//
+// Usage: load_generator --port N [--players N] [--seconds N] [--mix script|random|mixed]
+//                       [--commands N] [--think-ms N] [--server-pid PID] [--seed N] [--stalled N]
+//
+// Keeps --players connections (default 1000) busy for --seconds (default 10). Each player starts a
+// session, waits for the opening room, then sends one command at a time and waits for its response
+// (the server ends every response with "\x1e\n"). When a session ends (the script ran out, --commands
+// random commands were sent, or the game ended) the player reconnects for a new session.
+//
+// --stalled N adds N clients that keep sending commands but never read a response, to check that
+// the server's backpressure keeps them from slowing down everyone else.
+//
+// Command mixes:
+//   script   the walkthrough to the good ending, with the detours a player takes to ask for hints
+//   random   commands drawn from the real verb set with plausible nouns (go, examine, get,
+//            talk to guide, clean memorial, assist, ...), --commands per session (default 40)
+//   mixed    each session picks one of the two at random (default)
+//
+// Reports:
+//   latency      time from sending a command to the end of its response: p50, p90, p99, p99.9, max
+//   connect      time from connecting to the end of the opening room
+//   throughput   commands per second and completed sessions per second
+//   server CPU   with --server-pid, user+system CPU of the server from /proc/<pid>/stat, per command
+//                and as a share of one core; the generator's own CPU is shown for comparison
+//
+// Everything runs on one thread with poll(), so the generator needs far less CPU than the server.
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const char* const kWalkthrough[] = {
+    "hint", "go enter-center", "hint", "go enter", "hint", "clean memorial", "hint", "travel storage_room",
+    "hint", "get gas_can", "hint", "travel main_hall", "talk to guide", "hint", "travel storage_room",
+    "organize archives", "hint", "go hall", "hint", "talk to guide", "hint", "travel west_wing", "trim garden",
+    "hint", "go hall", "talk to guide", "hint", "go office", "hint", "get oil_fluid", "get surgical_item",
+    "hint", "go hall", "hint", "talk to guide", "hint", "go office", "use candle", "hint", "help", "assist",
+    "hint", "get first_aid_kit", "hint", "go hall"
+};
+
+const char* const kVerbs[] = {
+    "go", "go", "go", "look", "examine", "examine", "get", "inventory", "talk to guide", "clean memorial",
+    "organize archives", "trim garden", "use", "travel", "hint", "help", "assist", "leave", "xyzzy"
+};
+const char* const kExits[] = {"enter-center", "enter", "hall", "storage", "west-wing", "office", "exit", "back"};
+const char* const kNouns[] = {
+    "memorial", "figures", "archives", "garden", "candle", "gas_can", "spare_tire", "oil_fluid",
+    "first_aid_kit", "surgical_item", "guide", "door"
+};
+const char* const kRooms[] = {"car_breakdown_site", "entrance", "main_hall", "storage_room", "west_wing", "office"};
+
+template <typename T, size_t N>
+const T& pick(const T (&options)[N], std::mt19937& rng) {
+    return options[rng() % N];
+}
+
+std::string randomCommand(std::mt19937& rng) {
+    std::string verb = pick(kVerbs, rng);
+    if (verb == "go") return verb + " " + pick(kExits, rng);
+    if (verb == "examine" || verb == "get" || verb == "use") return verb + " " + pick(kNouns, rng);
+    if (verb == "travel") return verb + " " + pick(kRooms, rng);
+    return verb;
+}
+
+enum class Phase { Connecting, Greeting, Waiting, Thinking, Closed };
+
+struct Player {
+    int fd = -1;
+    Phase phase = Phase::Closed;
+    bool scripted = false;
+    size_t step = 0;                  // Commands sent in this session
+    std::string inbox;                // Received bytes not yet matched to a response
+    std::string outbox;               // Command bytes not yet written
+    Clock::time_point started;        // Connect or send time of what we are waiting for
+    Clock::time_point wakeAt;         // End of think time
+};
+
+struct Stats {
+    std::vector<uint32_t> latencyUs;
+    std::vector<uint32_t> connectUs;
+    uint64_t sessions = 0;
+    uint64_t failures = 0;
+    uint64_t bytesReceived = 0;
+    uint64_t stalledBytesSent = 0;
+};
+
+// utime + stime of a process in seconds, or a negative value if it cannot be read
+double processCpuSeconds(long pid) {
+    std::ifstream stat("/proc/" + std::to_string(pid) + "/stat");
+    std::string text;
+    if (!std::getline(stat, text)) return -1.0;
+    // The command name is in parentheses and may contain spaces; fields resume after the last ')'
+    size_t close = text.rfind(')');
+    if (close == std::string::npos) return -1.0;
+    std::istringstream fields(text.substr(close + 2));
+    std::string field;
+    unsigned long long utime = 0, stime = 0;
+    for (int index = 3; fields >> field; ++index) {
+        if (index == 14) utime = std::strtoull(field.c_str(), nullptr, 10);
+        if (index == 15) { stime = std::strtoull(field.c_str(), nullptr, 10); break; }
+    }
+    return static_cast<double>(utime + stime) / static_cast<double>(sysconf(_SC_CLK_TCK));
+}
+
+double ownCpuSeconds() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+        static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+uint32_t microsSince(Clock::time_point start, Clock::time_point now) {
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(now - start).count());
+}
+
+class LoadGenerator {
+public:
+    LoadGenerator(sockaddr_in server, size_t players, const std::string& mix, size_t commandsPerSession,
+                  std::chrono::milliseconds think, uint32_t seed, size_t stalled)
+        : server(server), players(players), mix(mix), commandsPerSession(commandsPerSession), think(think), rng(seed),
+        stallers(stalled, -1) {
+        // Commands that never end the game, so the server keeps producing output for these clients
+        stallScript = "look\nhelp\nexamine memorial\nhint\n";
+    }
+
+    void run(std::chrono::seconds duration) {
+        Clock::time_point end = Clock::now() + duration;
+        for (int& fd : stallers) fd = startStaller();
+        for (Player& player : players) connect(player);
+
+        std::vector<pollfd> polled;
+        std::vector<size_t> owners;
+        while (Clock::now() < end) {
+            Clock::time_point now = Clock::now();
+            polled.clear();
+            owners.clear();
+            for (size_t i = 0; i < players.size(); ++i) {
+                Player& player = players[i];
+                if (player.phase == Phase::Thinking && now >= player.wakeAt) sendNext(player, now);
+                if (player.phase == Phase::Closed) connect(player);
+                if (player.fd < 0 || player.phase == Phase::Thinking) continue;
+                short events = POLLIN;
+                if (player.phase == Phase::Connecting || !player.outbox.empty()) events |= POLLOUT;
+                polled.push_back(pollfd{player.fd, events, 0});
+                owners.push_back(i);
+            }
+            for (size_t i = 0; i < stallers.size(); ++i) {
+                if (stallers[i] < 0) continue;
+                polled.push_back(pollfd{stallers[i], POLLOUT, 0});
+                owners.push_back(players.size() + i);
+            }
+            int timeoutMs = think.count() > 0 ? 1 : 100;
+            if (poll(polled.data(), polled.size(), timeoutMs) < 0 && errno != EINTR) break;
+
+            now = Clock::now();
+            for (size_t k = 0; k < polled.size(); ++k) {
+                if (!polled[k].revents) continue;
+                if (owners[k] >= players.size()) {
+                    feedStaller(stallers[owners[k] - players.size()]);
+                    continue;
+                }
+                Player& player = players[owners[k]];
+                if (player.phase == Phase::Connecting) finishConnect(player, now);
+                if (player.phase != Phase::Connecting && player.fd >= 0 && (polled[k].revents & POLLOUT)) flush(player);
+                if (player.fd >= 0 && (polled[k].revents & (POLLIN | POLLHUP | POLLERR))) receive(player, now);
+            }
+        }
+        for (Player& player : players) closePlayer(player);
+        for (int fd : stallers) {
+            if (fd >= 0) close(fd);
+        }
+    }
+
+    Stats stats;
+
+private:
+    void connect(Player& player) {
+        player = Player();
+        player.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (player.fd < 0) {
+            ++stats.failures;
+            return;
+        }
+        int yes = 1;
+        setsockopt(player.fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+        player.scripted = mix == "script" || (mix == "mixed" && rng() % 2 == 0);
+        player.started = Clock::now();
+        int result = ::connect(player.fd, reinterpret_cast<const sockaddr*>(&server), sizeof(server));
+        if (result == 0) {
+            player.phase = Phase::Greeting;
+        } else if (errno == EINPROGRESS) {
+            player.phase = Phase::Connecting;
+        } else {
+            fail(player);
+        }
+    }
+
+    int startStaller() {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && ::connect(fd, reinterpret_cast<const sockaddr*>(&server), sizeof(server)) != 0 && errno != EINPROGRESS) {
+            close(fd);
+            fd = -1;
+        }
+        return fd;
+    }
+
+    // Sends the same few commands whenever the socket takes more; responses are never read
+    void feedStaller(int& fd) {
+        ssize_t written = send(fd, stallScript.data(), stallScript.size(), MSG_NOSIGNAL);
+        if (written >= 0) {
+            stats.stalledBytesSent += static_cast<uint64_t>(written);
+        } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            close(fd);
+            fd = -1;
+        }
+    }
+
+    void finishConnect(Player& player, Clock::time_point) {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        getsockopt(player.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+        if (error != 0) fail(player);
+        else player.phase = Phase::Greeting;
+    }
+
+    void receive(Player& player, Clock::time_point now) {
+        char buffer[16384];
+        for (;;) {
+            ssize_t got = recv(player.fd, buffer, sizeof(buffer), 0);
+            if (got == 0) {
+                // The server closes once the game has ended and the line after the ending was not an undo
+                if (player.phase == Phase::Greeting) fail(player);
+                else endSession(player);
+                return;
+            }
+            if (got < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) fail(player);
+                return;
+            }
+            stats.bytesReceived += static_cast<uint64_t>(got);
+            player.inbox.append(buffer, static_cast<size_t>(got));
+
+            size_t marker;
+            while ((marker = player.inbox.find("\x1e\n")) != std::string::npos) {
+                player.inbox.erase(0, marker + 2);
+                if (player.phase == Phase::Greeting) {
+                    stats.connectUs.push_back(microsSince(player.started, now));
+                } else if (player.phase == Phase::Waiting) {
+                    stats.latencyUs.push_back(microsSince(player.started, now));
+                } else {
+                    continue;
+                }
+                if (think.count() > 0) {
+                    player.phase = Phase::Thinking;
+                    player.wakeAt = now + think;
+                } else {
+                    sendNext(player, now);
+                    if (player.fd < 0) return;
+                }
+            }
+        }
+    }
+
+    void sendNext(Player& player, Clock::time_point now) {
+        size_t limit = player.scripted ? sizeof(kWalkthrough) / sizeof(kWalkthrough[0]) : commandsPerSession;
+        if (player.step >= limit) {
+            endSession(player);
+            return;
+        }
+        player.outbox = player.scripted ? kWalkthrough[player.step] : randomCommand(rng);
+        player.outbox.push_back('\n');
+        ++player.step;
+        player.phase = Phase::Waiting;
+        player.started = now;
+        flush(player);
+    }
+
+    void flush(Player& player) {
+        while (!player.outbox.empty()) {
+            ssize_t written = send(player.fd, player.outbox.data(), player.outbox.size(), MSG_NOSIGNAL);
+            if (written < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) fail(player);
+                return;
+            }
+            player.outbox.erase(0, static_cast<size_t>(written));
+        }
+    }
+
+    void endSession(Player& player) {
+        ++stats.sessions;
+        closePlayer(player);
+    }
+
+    void fail(Player& player) {
+        ++stats.failures;
+        closePlayer(player);
+    }
+
+    void closePlayer(Player& player) {
+        if (player.fd >= 0) close(player.fd);
+        player.fd = -1;
+        player.phase = Phase::Closed;
+    }
+
+    sockaddr_in server;
+    std::vector<Player> players;
+    std::string mix;
+    size_t commandsPerSession;
+    std::chrono::milliseconds think;
+    std::mt19937 rng;
+    std::vector<int> stallers;
+    std::string stallScript;
+};
+
+double percentile(const std::vector<uint32_t>& sorted, double fraction) {
+    if (sorted.empty()) return 0.0;
+    size_t index = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)] / 1000.0;
+}
+
+void printDistribution(const char* name, std::vector<uint32_t>& samples) {
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (uint32_t sample : samples) sum += sample;
+    std::cout << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(3)
+              << " n=" << samples.size()
+              << "  mean " << (samples.empty() ? 0.0 : sum / samples.size() / 1000.0)
+              << "  p50 " << percentile(samples, 0.50)
+              << "  p90 " << percentile(samples, 0.90)
+              << "  p99 " << percentile(samples, 0.99)
+              << "  p99.9 " << percentile(samples, 0.999)
+              << "  max " << (samples.empty() ? 0.0 : samples.back() / 1000.0) << " ms\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string host = "127.0.0.1";
+    int port = -1;
+    size_t players = 1000;
+    int seconds = 10;
+    std::string mix = "mixed";
+    size_t commands = 40;
+    int thinkMs = 0;
+    long serverPid = -1;
+    uint32_t seed = 1;
+    size_t stalled = 0;
+    for (int i = 1; i < argc; ++i) {
+        auto next = [&]() -> const char* { return i + 1 < argc ? argv[++i] : ""; };
+        if (std::strcmp(argv[i], "--host") == 0) host = next();
+        else if (std::strcmp(argv[i], "--port") == 0) port = std::atoi(next());
+        else if (std::strcmp(argv[i], "--players") == 0) players = std::strtoull(next(), nullptr, 10);
+        else if (std::strcmp(argv[i], "--seconds") == 0) seconds = std::atoi(next());
+        else if (std::strcmp(argv[i], "--mix") == 0) mix = next();
+        else if (std::strcmp(argv[i], "--commands") == 0) commands = std::strtoull(next(), nullptr, 10);
+        else if (std::strcmp(argv[i], "--think-ms") == 0) thinkMs = std::atoi(next());
+        else if (std::strcmp(argv[i], "--server-pid") == 0) serverPid = std::atol(next());
+        else if (std::strcmp(argv[i], "--seed") == 0) seed = static_cast<uint32_t>(std::strtoul(next(), nullptr, 10));
+        else if (std::strcmp(argv[i], "--stalled") == 0) stalled = std::strtoull(next(), nullptr, 10);
+        else port = -2;
+    }
+    sockaddr_in server{};
+    server.sin_family = AF_INET;
+    server.sin_port = htons(static_cast<uint16_t>(port));
+    if (port < 0 || players == 0 || seconds <= 0 || inet_pton(AF_INET, host.c_str(), &server.sin_addr) != 1 ||
+        (mix != "script" && mix != "random" && mix != "mixed")) {
+        std::cerr << "Usage: " << argv[0] << " --port N [--host ADDR] [--players N] [--seconds N]"
+                  << " [--mix script|random|mixed] [--commands N] [--think-ms N] [--server-pid PID] [--seed N] [--stalled N]" << std::endl;
+        return 1;
+    }
+
+    // One descriptor per simulated player
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    LoadGenerator generator(server, players, mix, commands, std::chrono::milliseconds(thinkMs), seed, stalled);
+    double serverCpuBefore = serverPid > 0 ? processCpuSeconds(serverPid) : -1.0;
+    double ownCpuBefore = ownCpuSeconds();
+    Clock::time_point start = Clock::now();
+    generator.run(std::chrono::seconds(seconds));
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    double serverCpu = serverPid > 0 ? processCpuSeconds(serverPid) - serverCpuBefore : -1.0;
+    double ownCpu = ownCpuSeconds() - ownCpuBefore;
+
+    Stats& stats = generator.stats;
+    size_t commandCount = stats.latencyUs.size();
+    std::cout << players << " players, " << mix << " mix, " << std::fixed << std::setprecision(1) << elapsed << " s\n";
+    printDistribution("latency", stats.latencyUs);
+    printDistribution("connect", stats.connectUs);
+    std::cout << std::setprecision(0)
+              << "throughput " << commandCount / elapsed << " commands/s, " << std::setprecision(1)
+              << stats.sessions / elapsed << " sessions/s (" << stats.sessions << " completed, "
+              << stats.failures << " failed), " << std::setprecision(2)
+              << stats.bytesReceived / elapsed / 1e6 << " MB/s received\n";
+    if (stalled > 0) {
+        std::cout << "stalled " << stalled << " clients sent " << stats.stalledBytesSent / 1024
+                  << " KB of commands without reading\n";
+    }
+    if (serverCpu >= 0.0 && commandCount > 0) {
+        std::cout << "server CPU " << std::setprecision(1) << serverCpu * 1e6 / commandCount << " us/command, "
+                  << serverCpu / elapsed * 100.0 << "% of a core\n";
+    } else if (serverPid > 0 && serverCpu < 0.0) {
+        std::cout << "server CPU unavailable (cannot read /proc/" << serverPid << "/stat)\n";
+    }
+    std::cout << "generator CPU " << std::setprecision(1) << ownCpu / elapsed * 100.0 << "% of a core" << std::endl;
+    return stats.failures > 0 && commandCount == 0 ? 1 : 0;
+}
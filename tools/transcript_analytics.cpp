@@ -0,0 +1,414 @@
+// Offline analytics over session transcripts recorded with '--record' (see include/Transcript.h).
+//
+// Usage: transcript_analytics [--threads N] [--passes N] <archive>...
+//
+// Archives are memory-mapped rather than read, and pages are handed back to the kernel as soon as
+// their block has been decoded, so resident memory stays small no matter how large the input is.
+// Blocks are self-contained and are decoded on all cores. What does grow with the input is one small
+// summary per session; '--passes N' splits the sessions into N hash partitions and scans the archives
+// once per partition to bound that as well.
+//
+// Reports:
+//   - the funnel: how many sessions reached each GameState, in story order
+//   - where players quit: the last state of every session that never reached an ending
+//   - the unknown-command rate per state
+//   - the choice made at CHOICE_POINT_LEAVE_OR_HELP (the last one, if undo took one back) and the
+//     endings each choice led to
+
+#include "Game.h"
+#include "Transcript.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+const size_t kStateCount = static_cast<size_t>(GameState::GAME_OVER) + 1;
+static_assert(kStateCount <= 32, "session summaries keep the visited states in a 32-bit mask");
+
+const uint8_t kNoEnding = 0xFF;
+const uint64_t kNever = ~0ull;
+
+const GameState kEndings[] = {GameState::ENDING_NOT_WORTHY, GameState::ENDING_GOOD_ESCAPED, GameState::ENDING_BAD_VICTIM};
+
+struct MappedFile {
+    std::string path;
+    const uint8_t* data;
+    size_t size;
+};
+
+struct BlockRef {
+    size_t file;
+    TranscriptReader::Block block;
+};
+
+// True if record position 'order' comes after 'than'; kNever means "no record"
+bool isLater(uint64_t order, uint64_t than) {
+    return order != kNever && (than == kNever || order > than);
+}
+
+// Everything we need to know about one session, mergeable across blocks
+struct SessionSummary {
+    uint32_t statesSeen = 0;     // Bit i set when the session was in GameState i
+    uint64_t lastOrder = 0;      // Position of the last command, to find the quit point
+    uint8_t lastState = 0;       // State of the last command
+    uint8_t ending = kNoEnding;    // Set by the latest Ended record, cleared by a later EndingUndone
+    uint64_t endingOrder = kNever; // Position of that record
+    uint64_t choiceOrder = kNever; // Position of the latest leave/assist at the choice point
+    Verb choice = Verb::Unknown;
+
+    void merge(const SessionSummary& other) {
+        statesSeen |= other.statesSeen;
+        if (other.lastOrder >= lastOrder) {
+            lastOrder = other.lastOrder;
+            lastState = other.lastState;
+        }
+        if (isLater(other.endingOrder, endingOrder)) {
+            endingOrder = other.endingOrder;
+            ending = other.ending;
+        }
+        if (isLater(other.choiceOrder, choiceOrder)) {
+            choiceOrder = other.choiceOrder;
+            choice = other.choice;
+        }
+    }
+};
+
+// Per-thread counters for one pass
+struct PartialStats {
+    std::unordered_map<uint64_t, SessionSummary> sessions;
+    uint64_t commands[kStateCount] = {};
+    uint64_t unknownCommands[kStateCount] = {};
+    uint64_t records = 0;
+    uint64_t corruptBlocks = 0;
+};
+
+// Final counters over all passes
+struct Report {
+    uint64_t sessions = 0;
+    uint64_t reached[kStateCount] = {};
+    uint64_t quitAt[kStateCount] = {};
+    uint64_t endings[kStateCount] = {};
+    uint64_t commands[kStateCount] = {};
+    uint64_t unknownCommands[kStateCount] = {};
+    uint64_t leaveChoices = 0;
+    uint64_t assistChoices = 0;
+    uint64_t endingAfterLeave[kStateCount] = {};
+    uint64_t endingAfterAssist[kStateCount] = {};
+    uint64_t undecided = 0; // Reached the choice point but never chose
+    uint64_t records = 0;
+    uint64_t corruptBlocks = 0;
+};
+
+uint64_t mixSessionId(uint64_t id) {
+    id ^= id >> 33;
+    id *= 0xff51afd7ed558ccdull;
+    id ^= id >> 33;
+    return id;
+}
+
+bool mapFile(const std::string& path, MappedFile& mapped) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+    void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps the file alive
+    if (data == MAP_FAILED) return false;
+    madvise(data, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+
+    mapped.path = path;
+    mapped.data = static_cast<const uint8_t*>(data);
+    mapped.size = static_cast<size_t>(info.st_size);
+    return true;
+}
+
+// Drops the pages lying entirely inside [begin, end) from this process; they are re-read if touched again
+void releasePages(const uint8_t* begin, const uint8_t* end) {
+    static const uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t first = (reinterpret_cast<uintptr_t>(begin) + pageSize - 1) & ~(pageSize - 1);
+    uintptr_t last = reinterpret_cast<uintptr_t>(end) & ~(pageSize - 1);
+    if (last > first) {
+        madvise(reinterpret_cast<void*>(first), last - first, MADV_DONTNEED);
+    }
+}
+
+// Decodes one block into a thread's partial stats
+void processBlock(const BlockRef& ref, uint64_t blockOrdinal, unsigned pass, unsigned passes, PartialStats& stats) {
+    uint64_t recordIndex = 0;
+    bool countRecords = (pass == 0); // Per-command counters are independent of the session partition
+    bool ok = TranscriptReader::decodeBlock(ref.block, [&](const TranscriptRecord& record) {
+        uint64_t order = (blockOrdinal << 32) | recordIndex++;
+        size_t state = static_cast<size_t>(record.state);
+        if (state >= kStateCount) return;
+
+        if (countRecords) {
+            ++stats.records;
+            if (record.verb != Verb::Ended && record.verb != Verb::EndingUndone) {
+                ++stats.commands[state];
+                if (record.verb == Verb::Unknown) ++stats.unknownCommands[state];
+            }
+        }
+        if (passes > 1 && mixSessionId(record.sessionId) % passes != pass) return;
+
+        SessionSummary& session = stats.sessions[record.sessionId];
+        // Older archives mark an undone ending as an Ended record in state INTRO
+        bool undone = record.verb == Verb::EndingUndone || (record.verb == Verb::Ended && record.state == GameState::INTRO);
+        if (record.verb == Verb::Ended && !undone) {
+            session.statesSeen |= 1u << state;
+            if (isLater(order, session.endingOrder)) {
+                session.endingOrder = order;
+                session.ending = static_cast<uint8_t>(state);
+            }
+            return;
+        }
+        if (undone) {
+            if (isLater(order, session.endingOrder)) {
+                session.endingOrder = order;
+                session.ending = kNoEnding;
+            }
+            // Play resumes in the recorded state, which is where the session quits if nothing follows
+            if (record.verb == Verb::EndingUndone && order >= session.lastOrder) {
+                session.lastOrder = order;
+                session.lastState = static_cast<uint8_t>(state);
+            }
+            return;
+        }
+        session.statesSeen |= 1u << state;
+        if (order >= session.lastOrder) {
+            session.lastOrder = order;
+            session.lastState = static_cast<uint8_t>(state);
+        }
+        if (record.state == GameState::CHOICE_POINT_LEAVE_OR_HELP &&
+            (record.verb == Verb::Leave || record.verb == Verb::Assist) && isLater(order, session.choiceOrder)) {
+            session.choiceOrder = order;
+            session.choice = record.verb;
+        }
+    });
+    if (!ok && countRecords) ++stats.corruptBlocks;
+
+    const uint8_t* blockStart = ref.block.symbols - TranscriptBlockHeader::kEncodedSize;
+    releasePages(blockStart, ref.block.index + ref.block.header.indexBytes);
+}
+
+// Runs fn(threadIndex) on 'threads' threads and waits for all of them
+template <typename Fn>
+void runOnThreads(unsigned threads, Fn&& fn) {
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back(fn, t);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+// One scan over every block, accumulating the sessions of partition 'pass' into 'report'
+void runPass(const std::vector<BlockRef>& blocks, unsigned pass, unsigned passes, unsigned threads, Report& report) {
+    std::vector<PartialStats> partials(threads);
+    std::atomic<size_t> nextBlock(0);
+    runOnThreads(threads, [&](unsigned t) {
+        for (size_t b = nextBlock.fetch_add(1); b < blocks.size(); b = nextBlock.fetch_add(1)) {
+            processBlock(blocks[b], b, pass, passes, partials[t]);
+        }
+    });
+
+    for (const auto& partial : partials) {
+        for (size_t s = 0; s < kStateCount; ++s) {
+            report.commands[s] += partial.commands[s];
+            report.unknownCommands[s] += partial.unknownCommands[s];
+        }
+        report.records += partial.records;
+        report.corruptBlocks += partial.corruptBlocks;
+    }
+
+    // Sessions span blocks, so the per-thread summaries are merged by hash shard, one shard per thread
+    std::vector<Report> shardReports(threads);
+    runOnThreads(threads, [&](unsigned shard) {
+        std::unordered_map<uint64_t, SessionSummary> merged;
+        for (const auto& partial : partials) {
+            for (const auto& entry : partial.sessions) {
+                if ((mixSessionId(entry.first) >> 32) % threads == shard) {
+                    merged[entry.first].merge(entry.second);
+                }
+            }
+        }
+
+        Report& out = shardReports[shard];
+        const uint32_t choiceBit = 1u << static_cast<size_t>(GameState::CHOICE_POINT_LEAVE_OR_HELP);
+        for (const auto& entry : merged) {
+            const SessionSummary& session = entry.second;
+            ++out.sessions;
+            for (size_t s = 0; s < kStateCount; ++s) {
+                if (session.statesSeen & (1u << s)) ++out.reached[s];
+            }
+            if (session.ending == kNoEnding) {
+                ++out.quitAt[session.lastState];
+            } else {
+                ++out.endings[session.ending];
+            }
+            if (session.choice == Verb::Leave) {
+                ++out.leaveChoices;
+                if (session.ending != kNoEnding) ++out.endingAfterLeave[session.ending];
+            } else if (session.choice == Verb::Assist) {
+                ++out.assistChoices;
+                if (session.ending != kNoEnding) ++out.endingAfterAssist[session.ending];
+            } else if (session.statesSeen & choiceBit) {
+                ++out.undecided;
+            }
+        }
+    });
+
+    for (const auto& shard : shardReports) {
+        report.sessions += shard.sessions;
+        report.leaveChoices += shard.leaveChoices;
+        report.assistChoices += shard.assistChoices;
+        report.undecided += shard.undecided;
+        for (size_t s = 0; s < kStateCount; ++s) {
+            report.reached[s] += shard.reached[s];
+            report.quitAt[s] += shard.quitAt[s];
+            report.endings[s] += shard.endings[s];
+            report.endingAfterLeave[s] += shard.endingAfterLeave[s];
+            report.endingAfterAssist[s] += shard.endingAfterAssist[s];
+        }
+    }
+}
+
+double percent(uint64_t part, uint64_t whole) {
+    return whole == 0 ? 0.0 : 100.0 * static_cast<double>(part) / static_cast<double>(whole);
+}
+
+void printRow(const char* label, uint64_t count, uint64_t whole) {
+    std::cout << "  " << std::left << std::setw(40) << label << std::right << std::setw(12) << count
+              << std::setw(9) << std::fixed << std::setprecision(1) << percent(count, whole) << "%\n";
+}
+
+void printReport(const Report& report, size_t fileCount, size_t blockCount) {
+    std::cout << "Transcripts: " << fileCount << " file(s), " << blockCount << " block(s), "
+              << report.records << " record(s), " << report.sessions << " session(s)\n";
+    if (report.corruptBlocks > 0) {
+        std::cout << "Warning: " << report.corruptBlocks << " block(s) were malformed and only partly decoded\n";
+    }
+
+    // States that cutscenes pass straight through are never seen by a command, so only visited states are listed
+    std::cout << "\nFunnel (sessions that reached each state)\n";
+    for (size_t s = 0; s < kStateCount; ++s) {
+        if (report.reached[s] > 0) printRow(gameStateName(static_cast<GameState>(s)), report.reached[s], report.sessions);
+    }
+
+    uint64_t quitters = 0;
+    for (size_t s = 0; s < kStateCount; ++s) quitters += report.quitAt[s];
+    std::cout << "\nQuit points (last state of the " << quitters << " session(s) without an ending)\n";
+    for (size_t s = 0; s < kStateCount; ++s) {
+        if (report.quitAt[s] > 0) printRow(gameStateName(static_cast<GameState>(s)), report.quitAt[s], quitters);
+    }
+
+    std::cout << "\nUnknown commands per state\n";
+    for (size_t s = 0; s < kStateCount; ++s) {
+        if (report.commands[s] == 0) continue;
+        std::cout << "  " << std::left << std::setw(40) << gameStateName(static_cast<GameState>(s)) << std::right
+                  << std::setw(12) << report.unknownCommands[s] << " / " << std::setw(12) << report.commands[s]
+                  << std::setw(9) << std::fixed << std::setprecision(1)
+                  << percent(report.unknownCommands[s], report.commands[s]) << "%\n";
+    }
+
+    uint64_t atChoice = report.leaveChoices + report.assistChoices + report.undecided;
+    std::cout << "\nChoice at CHOICE_POINT_LEAVE_OR_HELP (" << atChoice << " session(s))\n";
+    printRow("leave", report.leaveChoices, atChoice);
+    for (GameState ending : kEndings) {
+        size_t e = static_cast<size_t>(ending);
+        if (report.endingAfterLeave[e] > 0) printRow((std::string("  -> ") + gameStateName(ending)).c_str(), report.endingAfterLeave[e], report.leaveChoices);
+    }
+    printRow("assist", report.assistChoices, atChoice);
+    for (GameState ending : kEndings) {
+        size_t e = static_cast<size_t>(ending);
+        if (report.endingAfterAssist[e] > 0) printRow((std::string("  -> ") + gameStateName(ending)).c_str(), report.endingAfterAssist[e], report.assistChoices);
+    }
+    printRow("no choice made", report.undecided, atChoice);
+
+    std::cout << "\nEndings\n";
+    for (GameState ending : kEndings) {
+        printRow(gameStateName(ending), report.endings[static_cast<size_t>(ending)], report.sessions);
+    }
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--threads N] [--passes N] <archive>...\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    unsigned passes = 1;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+        } else if (std::strcmp(argv[i], "--passes") == 0 && i + 1 < argc) {
+            passes = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+        } else if (argv[i][0] == '-') {
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (paths.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<MappedFile> files;
+    for (const auto& path : paths) {
+        MappedFile mapped;
+        if (!mapFile(path, mapped)) {
+            std::cerr << "Skipping " << path << ": cannot map file" << std::endl;
+            continue;
+        }
+        files.push_back(mapped);
+    }
+
+    // Locating blocks only touches their headers; the bodies are read by the workers
+    std::vector<BlockRef> blocks;
+    for (size_t f = 0; f < files.size(); ++f) {
+        TranscriptReader reader(files[f].data, files[f].size);
+        if (!reader.isValid()) {
+            std::cerr << "Skipping " << files[f].path << ": not a transcript archive" << std::endl;
+            continue;
+        }
+        BlockRef ref;
+        ref.file = f;
+        while (reader.nextBlock(ref.block)) {
+            blocks.push_back(ref);
+        }
+    }
+
+    Report report;
+    for (unsigned pass = 0; pass < passes; ++pass) {
+        runPass(blocks, pass, passes, threads, report);
+    }
+    printReport(report, files.size(), blocks.size());
+
+    for (const auto& file : files) {
+        munmap(const_cast<uint8_t*>(file.data), file.size);
+    }
+    return 0;
+}
@@ -0,0 +1,303 @@
+// Scaling benchmark for the world model, on worlds built by WorldGenerator.
+//
+// Usage: world_benchmark [--max-rooms N] [--max-items N] [--max-players N]
+//
+// World sweep (10^3 rooms up to --max-rooms, default 10^6):
+//   setup      time to generate the rooms, and live heap bytes per room afterwards
+//   load       Game::loadWorld (takes ownership, rebuilds the navigation table)
+//   findRoom   Game::findRoomById for a random room
+//   go         a full 'go forward' command, including the room description it prints
+//   travel     a full 'travel room_<n>' command to one of up to 64 random rooms, whose routing columns
+//              are computed before timing starts; the cost is mostly the walk and the rooms it prints
+//   nextExit   NavigationTable::nextExit alone, from a random room towards one of the same targets
+//   look       Room::look on the current room
+//
+// Room sweep (10 up to --max-items items and elements in one room, default 10^4):
+//   getItem, getElement, inventory (Player::getItemFromInventory with that many items carried), look,
+//   fuzzy (Room::fuzzyMatchNoun for an item id with one typo)
+//
+// Co-op sweep (1 up to --max-players players, default 16, sharing one 10^4-room CoopGame):
+//   each player runs on its own thread, cycling through go, look, examine and get; reports the
+//   total commands per second and the average latency of a command
+//
+// Output goes to a sink that counts characters, so formatting is measured but nothing is printed.
+
+#include "Game.h"
+#include "CoopGame.h"
+#include "WorldGenerator.h"
+#include "NavigationTable.h"
+
+#include <malloc.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// --- Heap accounting ---
+// Every allocation in the process goes through these, so live bytes can be sampled around a step
+static std::atomic<size_t> gLiveBytes(0);
+
+void* operator new(size_t size) {
+    void* p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    gLiveBytes.fetch_add(malloc_usable_size(p), std::memory_order_relaxed);
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    if (!p) return;
+    gLiveBytes.fetch_sub(malloc_usable_size(p), std::memory_order_relaxed);
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Accepts and counts all output
+class CountingBuffer : public std::streambuf {
+public:
+    size_t count = 0;
+protected:
+    int overflow(int c) override {
+        ++count;
+        return c;
+    }
+    std::streamsize xsputn(const char*, std::streamsize n) override {
+        count += static_cast<size_t>(n);
+        return n;
+    }
+};
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Average nanoseconds per call of fn(i), repeating until at least 'minSeconds' have passed
+template <typename Fn>
+double nsPerOp(Fn&& fn, double minSeconds = 0.2) {
+    size_t done = 0;
+    size_t batch = 1;
+    Clock::time_point start = Clock::now();
+    double elapsed = 0.0;
+    while (elapsed < minSeconds) {
+        for (size_t i = 0; i < batch; ++i) fn(done + i);
+        done += batch;
+        batch *= 2;
+        elapsed = secondsSince(start);
+    }
+    return elapsed * 1e9 / static_cast<double>(done);
+}
+
+void printHeader(const std::vector<const char*>& columns) {
+    for (const char* column : columns) std::cout << std::setw(14) << column;
+    std::cout << "\n";
+}
+
+void printCell(double value, int precision = 0) {
+    std::cout << std::setw(14) << std::fixed << std::setprecision(precision) << value;
+}
+
+void worldSweep(size_t maxRooms, std::ostream& sink) {
+    std::cout << "World sweep (" << WorldSpec().exitsPerRoom << " exits, " << WorldSpec().itemsPerRoom << " items, "
+              << WorldSpec().elementsPerRoom << " elements per room; times in ns unless noted)\n";
+    printHeader({"rooms", "setup ms", "bytes/room", "load ms", "findRoom", "go", "travel", "nextExit", "look"});
+
+    for (size_t rooms = 1000; rooms <= maxRooms; rooms *= 10) {
+        Game game(sink, 0);
+        std::mt19937 rng(static_cast<uint32_t>(rooms));
+
+        // Inputs are prepared up front so string building is not part of the measurements
+        std::vector<std::string> roomIds;
+        for (size_t i = 0; i < 1024; ++i) {
+            roomIds.push_back(WorldGenerator::roomId(rng() % rooms));
+        }
+
+        WorldSpec spec;
+        spec.roomCount = rooms;
+        size_t liveBefore = gLiveBytes.load();
+        Clock::time_point start = Clock::now();
+        std::vector<std::unique_ptr<Room>> world = WorldGenerator(spec).generate();
+        double setupMs = secondsSince(start) * 1e3;
+        double bytesPerRoom = static_cast<double>(gLiveBytes.load() - liveBefore) / static_cast<double>(rooms);
+
+        start = Clock::now();
+        game.loadWorld(std::move(world), WorldGenerator::roomId(0));
+        double loadMs = secondsSince(start) * 1e3;
+
+        // Linear scans get slow on big worlds, so give them a shorter budget
+        double findNs = nsPerOp([&](size_t i) { game.findRoomById(roomIds[i % roomIds.size()]); }, 0.1);
+        double goNs = nsPerOp([&](size_t) { game.processInput("go forward"); });
+
+        // Few travel targets, and no more than the navigation table caches: every timed lookup is warm
+        NavigationTable routes;
+        routes.build(game.allRooms, {});
+        std::vector<int> targets;
+        std::vector<std::string> travelCommands;
+        for (size_t i = 0; i < std::min<size_t>(64, routes.columnCapacity()); ++i) {
+            size_t target = rng() % rooms;
+            targets.push_back(static_cast<int>(target));
+            travelCommands.push_back("travel " + WorldGenerator::roomId(target));
+        }
+        std::vector<const Room*> sources;
+        for (size_t i = 0; i < 1024; ++i) sources.push_back(game.allRooms[rng() % rooms].get());
+        for (const std::string& command : travelCommands) game.processInput(command);
+        for (int target : targets) routes.nextExit(sources[0], target, 0);
+
+        double travelNs = nsPerOp([&](size_t i) { game.processInput(travelCommands[i % travelCommands.size()]); });
+        const std::string* volatile exitKey = nullptr;
+        double nextExitNs = nsPerOp([&](size_t i) {
+            exitKey = routes.nextExit(sources[i % sources.size()], targets[i % targets.size()], 0);
+        });
+        double lookNs = nsPerOp([&](size_t) { game.player.currentLocation->look(sink); });
+
+        std::cout << std::setw(14) << rooms;
+        printCell(setupMs, 1);
+        printCell(bytesPerRoom);
+        printCell(loadMs, 1);
+        printCell(findNs);
+        printCell(goNs);
+        printCell(travelNs);
+        printCell(nextExitNs);
+        printCell(lookNs);
+        std::cout << std::endl;
+    }
+}
+
+void roomSweep(size_t maxItems, std::ostream& sink) {
+    std::cout << "\nRoom sweep (one room with N items and N elements; times in ns)\n";
+    printHeader({"N", "getItem", "getElement", "inventory", "look", "fuzzy"});
+
+    for (size_t count = 10; count <= maxItems; count *= 10) {
+        WorldSpec spec;
+        spec.roomCount = 2;
+        spec.itemsPerRoom = count;
+        spec.elementsPerRoom = count;
+        std::vector<std::unique_ptr<Room>> world = WorldGenerator(spec).generate();
+        Room& room = *world[0];
+
+        Player player(world[1].get());
+        std::vector<std::unique_ptr<Item>> carried;
+        world[1]->takeAllItems(carried);
+        for (auto& item : carried) player.pickUpItem(std::move(item), sink);
+
+        std::mt19937 rng(static_cast<uint32_t>(count));
+        std::vector<std::string> itemIds, carriedIds, elementNames, typos;
+        for (size_t i = 0; i < 1024; ++i) {
+            itemIds.push_back(WorldGenerator::itemId(0, rng() % count));
+            typos.push_back(itemIds.back());
+            typos.back()[rng() % typos.back().size()] = 'q';
+            carriedIds.push_back(WorldGenerator::itemId(1, rng() % count));
+            elementNames.push_back(WorldGenerator::elementName(rng() % count));
+        }
+
+        double itemNs = nsPerOp([&](size_t i) { room.getItem(itemIds[i % itemIds.size()]); });
+        double elementNs = nsPerOp([&](size_t i) { room.getInteractiveElement(elementNames[i % elementNames.size()]); });
+        double inventoryNs = nsPerOp([&](size_t i) { player.getItemFromInventory(carriedIds[i % carriedIds.size()]); });
+        double lookNs = nsPerOp([&](size_t) { room.look(sink); });
+        double fuzzyNs = nsPerOp([&](size_t i) {
+            FuzzyMatch match;
+            room.fuzzyMatchNoun(typos[i % typos.size()], true, match);
+        });
+
+        std::cout << std::setw(14) << count;
+        printCell(itemNs);
+        printCell(elementNs);
+        printCell(inventoryNs);
+        printCell(lookNs);
+        printCell(fuzzyNs);
+        std::cout << std::endl;
+    }
+}
+
+void coopSweep(size_t maxPlayers) {
+    std::cout << "\nCo-op sweep (one shared 10^4-room world, one thread per player)\n";
+    printHeader({"players", "commands/s", "latency ns"});
+
+    for (size_t players = 1; players <= maxPlayers; players *= 2) {
+        WorldSpec spec;
+        spec.roomCount = 10000;
+        CoopGame coop;
+        coop.loadWorld(WorldGenerator(spec).generate(), WorldGenerator::roomId(0));
+
+        std::vector<CountingBuffer> buffers(players);
+        std::vector<std::unique_ptr<std::ostream>> sinks;
+        std::vector<size_t> ids;
+        for (size_t p = 0; p < players; ++p) {
+            sinks.push_back(std::make_unique<std::ostream>(&buffers[p]));
+            ids.push_back(coop.join("player_" + std::to_string(p), *sinks.back()));
+            // Spread the players out so they mostly walk through different rooms
+            for (size_t step = 0; step < p * 64; ++step) coop.processInput(ids[p], "go forward");
+        }
+
+        const char* commands[] = {"go forward", "look", "examine element_0", "get item", "go passage_0", "look"};
+        std::atomic<bool> stop(false);
+        std::vector<size_t> done(players, 0);
+        std::vector<std::thread> threads;
+        Clock::time_point start = Clock::now();
+        for (size_t p = 0; p < players; ++p) {
+            threads.emplace_back([&, p] {
+                size_t count = 0;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    coop.processInput(ids[p], commands[count % 6]);
+                    ++count;
+                }
+                done[p] = count;
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        stop = true;
+        for (auto& thread : threads) thread.join();
+        double elapsed = secondsSince(start);
+
+        size_t total = 0;
+        for (size_t count : done) total += count;
+        std::cout << std::setw(14) << players;
+        printCell(static_cast<double>(total) / elapsed);
+        printCell(elapsed * 1e9 * static_cast<double>(players) / static_cast<double>(total));
+        std::cout << std::endl;
+
+        std::string problem;
+        if (!coop.checkInvariants(&problem)) std::cout << "  invariant violated: " << problem << std::endl;
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t maxRooms = 1000000;
+    size_t maxItems = 10000;
+    size_t maxPlayers = 16;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--max-rooms") == 0 && i + 1 < argc) {
+            maxRooms = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--max-items") == 0 && i + 1 < argc) {
+            maxItems = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--max-players") == 0 && i + 1 < argc) {
+            maxPlayers = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--max-rooms N] [--max-items N] [--max-players N]" << std::endl;
+            return 1;
+        }
+    }
+
+    CountingBuffer sinkBuffer;
+    std::ostream sink(&sinkBuffer);
+    worldSweep(maxRooms, sink);
+    roomSweep(maxItems, sink);
+    coopSweep(maxPlayers);
+    return 0;
+}
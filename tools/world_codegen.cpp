@@ -0,0 +1,688 @@
+// Generates the built-in world tables from the world definition.
+//
+// Usage: world_codegen <world file> <output header>
+//        world_codegen --catalog <world file> <locale file | -> <output catalog>
+//        world_codegen --template <world file> <output locale file>
+//
+// Reads a world definition (see world/visitor_center.world for the format), checks that every
+// reference in it resolves, and writes a header of constexpr tables using the row types in
+// include/WorldDefinition.h. The Makefile runs this whenever the definition changes; the game never
+// parses the definition itself.
+//
+// The output is only rewritten when its contents change, so an unchanged world does not cause a rebuild.
+//
+// --catalog compiles a locale's translations (world/locale/<tag>.messages) into the binary catalog
+// format of include/MessageCatalog.h; '-' compiles the world's own text. --template writes a locale
+// file holding every message ID with its current text, as a starting point for a translation.
+
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "MessageCatalog.h"
+
+namespace {
+
+struct Room {
+    std::string id;
+    std::string name;
+    std::string description;
+    size_t line = 0;
+    std::string nameMessage, descriptionMessage;
+};
+
+struct Exit {
+    std::string room;
+    std::string key;
+    std::string target;
+    size_t line = 0;
+};
+
+struct Item {
+    std::string id;
+    std::string room;
+    std::string name;
+    std::string description;
+    std::vector<std::string> aliases;
+    size_t line = 0;
+    std::string nameMessage, descriptionMessage;
+};
+
+struct Element {
+    std::string room;
+    std::string name;
+    std::map<size_t, std::string> stages;
+    std::vector<std::string> aliases;
+    size_t line = 0;
+    std::vector<std::string> stageMessages;
+};
+
+struct TriggerStep {
+    std::string action; // "say", "state", "advance" or "spawn"
+    std::string text;   // Line, state name, element or room
+    int stage = -1;
+    size_t line = 0;
+    std::string message; // Message ID of a 'say' line
+};
+
+struct Message {
+    std::string id;
+    std::string text;
+    size_t line = 0;
+};
+
+struct Trigger {
+    std::string name;
+    std::string event;
+    std::string room;    // "*" for any
+    std::string subject; // "*" for any
+    std::string state;   // "*" for any
+    std::string element;
+    int elementStage = -1;
+    bool needsCarried = false;
+    bool needsUnspawned = false;
+    std::vector<TriggerStep> steps;
+    size_t line = 0;
+};
+
+struct World {
+    std::string start;
+    std::vector<Room> rooms;
+    std::vector<Exit> exits;
+    std::vector<Item> items;
+    std::vector<Element> elements;
+    std::vector<std::pair<std::string, std::string>> dialogue; // State name, text
+    std::vector<std::pair<std::string, std::string>> help;     // Topic, text
+    std::vector<Trigger> triggers;
+    std::vector<Message> messages; // Explicit 'message' lines
+
+    // Every narrated line in catalog order, filled by assignMessages
+    std::vector<Message> catalog;
+    std::vector<std::string> dialogueIds;
+    std::vector<std::string> helpIds;
+};
+
+// Turns '\n' into a line break and '\\' into a backslash
+std::string unescape(const std::string& text) {
+    std::string result;
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '\\' && i + 1 < text.size() && (text[i + 1] == 'n' || text[i + 1] == '\\')) {
+            result.push_back(text[++i] == 'n' ? '\n' : '\\');
+        } else {
+            result.push_back(text[i]);
+        }
+    }
+    return result;
+}
+
+std::string escape(const std::string& text) {
+    std::string result;
+    for (char c : text) {
+        if (c == '\n') result += "\\n";
+        else if (c == '\\') result += "\\\\";
+        else result.push_back(c);
+    }
+    return result;
+}
+
+bool isMessageId(const std::string& id) {
+    if (id.empty() || std::isdigit(static_cast<unsigned char>(id[0]))) return false;
+    for (char c : id) {
+        if (!std::isupper(static_cast<unsigned char>(c)) && !std::isdigit(static_cast<unsigned char>(c)) && c != '_') return false;
+    }
+    return true;
+}
+
+// 'name' as part of a message ID: upper case, with anything else turned into '_'
+std::string idPart(const std::string& name) {
+    std::string part;
+    for (char c : name) {
+        part.push_back(std::isalnum(static_cast<unsigned char>(c)) ? static_cast<char>(std::toupper(static_cast<unsigned char>(c))) : '_');
+    }
+    return part;
+}
+
+std::vector<std::string> words(const std::string& text) {
+    std::istringstream stream(text);
+    std::vector<std::string> result;
+    for (std::string word; stream >> word;) result.push_back(word);
+    return result;
+}
+
+bool number(const std::string& text, int& value) {
+    char* end = nullptr;
+    long parsed = std::strtol(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0' || parsed < 0 || parsed > 0x7FFF) return false;
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+// Parses the part after '=' of one trigger line into 'trigger'
+bool parseTrigger(const std::string& part, const std::string& text, Trigger& trigger, size_t lineNumber, std::string& message) {
+    std::vector<std::string> args = words(text);
+    if (part == "on") {
+        if (args.size() != 4 || (args[0] != "enter" && args[0] != "take" && args[0] != "use")) {
+            message = "expected 'on = enter|take|use <room|*> <subject|*> <STATE|*>'";
+            return false;
+        }
+        trigger.event = args[0];
+        trigger.room = args[1];
+        trigger.subject = args[2];
+        trigger.state = args[3];
+    } else if (part == "if") {
+        if (args.size() == 3 && args[0] == "element" && number(args[2], trigger.elementStage)) {
+            trigger.element = args[1];
+        } else if (args.size() == 1 && args[0] == "carried") {
+            trigger.needsCarried = true;
+        } else if (args.size() == 1 && args[0] == "unspawned") {
+            trigger.needsUnspawned = true;
+        } else {
+            message = "expected 'if = element <element> <stage>', 'if = carried' or 'if = unspawned'";
+            return false;
+        }
+    } else if (part == "do") {
+        TriggerStep step;
+        step.line = lineNumber;
+        if (args.size() == 2 && (args[0] == "state" || args[0] == "spawn")) {
+            step.action = args[0];
+            step.text = args[1];
+        } else if ((args.size() == 2 || args.size() == 3) && args[0] == "advance" &&
+                   (args.size() == 2 || number(args[2], step.stage))) {
+            step.action = args[0];
+            step.text = args[1];
+        } else {
+            message = "expected 'do = state <STATE>', 'do = advance <element> [<stage>]' or 'do = spawn <room>'";
+            return false;
+        }
+        trigger.steps.push_back(step);
+    } else if (part == "say") {
+        trigger.steps.push_back(TriggerStep{"say", text, -1, lineNumber});
+    } else {
+        message = "triggers only have 'on', 'if', 'do' and 'say' lines";
+        return false;
+    }
+    return true;
+}
+
+// Finds the entry whose key matches, or appends a new one, keeping first-appearance order
+template <typename T, typename Match>
+T& findOrAdd(std::vector<T>& entries, Match match, size_t line) {
+    for (auto& entry : entries) {
+        if (match(entry)) return entry;
+    }
+    entries.emplace_back();
+    entries.back().line = line;
+    return entries.back();
+}
+
+bool parse(const std::string& path, World& world, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = path + ": cannot open";
+        return false;
+    }
+    auto fail = [&](size_t lineNumber, const std::string& message) {
+        error = path + ":" + std::to_string(lineNumber) + ": " + message;
+        return false;
+    };
+
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line[start] == '#') continue;
+
+        size_t separator = line.find(" = ");
+        if (separator == std::string::npos) return fail(lineNumber, "expected '<key> = <text>'");
+        std::string text = line.substr(separator + 3);
+        std::istringstream keyStream(line.substr(0, separator));
+        std::vector<std::string> key;
+        for (std::string word; keyStream >> word;) key.push_back(word);
+        if (key.empty()) return fail(lineNumber, "missing key before '='");
+
+        if (key[0] == "start" && key.size() == 1) {
+            world.start = text;
+        } else if (key[0] == "room" && key.size() == 3) {
+            Room& room = findOrAdd(world.rooms, [&](const Room& r) { return r.id == key[1]; }, lineNumber);
+            room.id = key[1];
+            if (key[2] == "name") room.name = text;
+            else if (key[2] == "description") room.description = text;
+            else return fail(lineNumber, "rooms only have a 'name' and a 'description'");
+        } else if (key[0] == "exit" && key.size() == 3) {
+            world.exits.push_back(Exit{key[1], key[2], text, lineNumber});
+        } else if (key[0] == "item" && key.size() == 4) {
+            Item& item = findOrAdd(world.items, [&](const Item& i) { return i.id == key[2]; }, lineNumber);
+            if (!item.id.empty() && item.room != key[1]) return fail(lineNumber, "item '" + key[2] + "' was placed in '" + item.room + "' before");
+            item.id = key[2];
+            item.room = key[1];
+            if (key[3] == "name") item.name = text;
+            else if (key[3] == "description") item.description = text;
+            else if (key[3] == "alias") item.aliases.push_back(text);
+            else return fail(lineNumber, "items only have a 'name', a 'description' and 'alias' lines");
+        } else if (key[0] == "element" && key.size() == 4) {
+            Element& element = findOrAdd(world.elements, [&](const Element& e) { return e.room == key[1] && e.name == key[2]; }, lineNumber);
+            element.room = key[1];
+            element.name = key[2];
+            if (key[3] == "alias") {
+                element.aliases.push_back(text);
+            } else {
+                char* end = nullptr;
+                unsigned long stage = std::strtoul(key[3].c_str(), &end, 10);
+                if (*end != '\0') return fail(lineNumber, "expected a stage number or 'alias'");
+                if (!element.stages.emplace(stage, text).second) return fail(lineNumber, "stage defined twice");
+            }
+        } else if (key[0] == "dialogue" && key.size() == 2) {
+            world.dialogue.emplace_back(key[1], text);
+        } else if (key[0] == "help" && key.size() == 2) {
+            world.help.emplace_back(key[1], text);
+        } else if (key[0] == "message" && key.size() == 2) {
+            if (!isMessageId(key[1])) return fail(lineNumber, "message IDs are upper case letters, digits and '_'");
+            world.messages.push_back(Message{key[1], unescape(text), lineNumber});
+        } else if (key[0] == "trigger" && key.size() == 3) {
+            Trigger& trigger = findOrAdd(world.triggers, [&](const Trigger& t) { return t.name == key[1]; }, lineNumber);
+            trigger.name = key[1];
+            std::string message;
+            if (!parseTrigger(key[2], text, trigger, lineNumber, message)) return fail(lineNumber, message);
+        } else {
+            return fail(lineNumber, "unknown key '" + line.substr(start, separator - start) + "'");
+        }
+    }
+    return true;
+}
+
+// Checks references and completeness, and fills 'roomIndex'
+bool validate(const std::string& path, const World& world, std::unordered_map<std::string, size_t>& roomIndex, std::string& error) {
+    auto fail = [&](size_t lineNumber, const std::string& message) {
+        error = path + ":" + std::to_string(lineNumber) + ": " + message;
+        return false;
+    };
+    for (size_t i = 0; i < world.rooms.size(); ++i) {
+        const Room& room = world.rooms[i];
+        if (room.name.empty() || room.description.empty()) return fail(room.line, "room '" + room.id + "' needs a name and a description");
+        roomIndex[room.id] = i;
+    }
+    if (world.rooms.empty()) return fail(1, "the world has no rooms");
+    if (world.rooms.size() >= 0xFFFF) return fail(1, "too many rooms");
+    if (!roomIndex.count(world.start)) return fail(1, "start room '" + world.start + "' is not defined");
+
+    for (const Exit& exit : world.exits) {
+        if (!roomIndex.count(exit.room)) return fail(exit.line, "unknown room '" + exit.room + "'");
+        if (!roomIndex.count(exit.target)) return fail(exit.line, "exit leads to unknown room '" + exit.target + "'");
+    }
+    size_t unplaced = 0;
+    for (const Item& item : world.items) {
+        if (item.room == "-") ++unplaced;
+        else if (!roomIndex.count(item.room)) return fail(item.line, "unknown room '" + item.room + "'");
+        if (item.name.empty() || item.description.empty()) return fail(item.line, "item '" + item.id + "' needs a name and a description");
+    }
+    if (unplaced > 1) return fail(1, "only one item can start outside the rooms (it is held back for the story)");
+    for (const Element& element : world.elements) {
+        if (!roomIndex.count(element.room)) return fail(element.line, "unknown room '" + element.room + "'");
+        size_t expected = 0;
+        for (const auto& stage : element.stages) {
+            if (stage.first != expected++) return fail(element.line, "element '" + element.name + "' skips stage " + std::to_string(expected - 1));
+        }
+    }
+
+    auto isItem = [&](const std::string& id) {
+        for (const Item& item : world.items) {
+            if (item.id == id) return true;
+        }
+        return false;
+    };
+    // An element called 'name', in 'room' unless that is "*"
+    auto isElement = [&](const std::string& room, const std::string& name) {
+        for (const Element& element : world.elements) {
+            if (element.name == name && (room == "*" || element.room == room)) return true;
+        }
+        return false;
+    };
+    for (const Trigger& trigger : world.triggers) {
+        auto where = [&](const std::string& what) { return "trigger '" + trigger.name + "' " + what; };
+        if (trigger.event.empty()) return fail(trigger.line, where("has no 'on' line"));
+        if (trigger.steps.empty()) return fail(trigger.line, where("does nothing"));
+        if (trigger.room != "*" && !roomIndex.count(trigger.room)) return fail(trigger.line, where("names unknown room '" + trigger.room + "'"));
+        if (trigger.subject != "*") {
+            bool known = trigger.event == "take" ? isItem(trigger.subject)
+                                                 : isItem(trigger.subject) || isElement(trigger.room, trigger.subject);
+            if (!known) return fail(trigger.line, where("is about unknown '" + trigger.subject + "'"));
+        }
+        if (trigger.needsCarried && (trigger.subject == "*" || !isItem(trigger.subject))) {
+            return fail(trigger.line, where("can only require carrying a specific item"));
+        }
+        if (!trigger.element.empty() && !isElement(trigger.room, trigger.element)) {
+            return fail(trigger.line, where("checks unknown element '" + trigger.element + "'"));
+        }
+        for (const TriggerStep& step : trigger.steps) {
+            if (step.action == "advance" && !isElement(trigger.room, step.text)) {
+                return fail(step.line, where("advances unknown element '" + step.text + "'"));
+            }
+            if (step.action == "spawn" && (!roomIndex.count(step.text) || unplaced == 0)) {
+                return fail(step.line, where("spawns into unknown room '" + step.text + "' or there is no held-back item"));
+            }
+        }
+    }
+    return true;
+}
+
+// Gives every narrated line its message ID: the explicit messages first, then the text of rooms, items
+// and element stages, then dialogue, help and trigger lines, numbered in the order they are written.
+// Fails if two lines end up with the same ID
+bool assignMessages(const std::string& path, World& world, std::string& error) {
+    std::unordered_set<std::string> ids;
+    auto add = [&](const std::string& id, const std::string& text, size_t line) {
+        if (!ids.insert(id).second) {
+            error = path + ":" + std::to_string(line) + ": message ID '" + id + "' is used twice";
+            return false;
+        }
+        world.catalog.push_back(Message{id, text, line});
+        return true;
+    };
+    for (const Message& message : world.messages) {
+        if (!add(message.id, message.text, message.line)) return false;
+    }
+    for (Room& room : world.rooms) {
+        room.nameMessage = "ROOM_" + idPart(room.id) + "_NAME";
+        room.descriptionMessage = "ROOM_" + idPart(room.id) + "_DESCRIPTION";
+        if (!add(room.nameMessage, room.name, room.line) || !add(room.descriptionMessage, room.description, room.line)) return false;
+    }
+    for (Item& item : world.items) {
+        item.nameMessage = "ITEM_" + idPart(item.id) + "_NAME";
+        item.descriptionMessage = "ITEM_" + idPart(item.id) + "_DESCRIPTION";
+        if (!add(item.nameMessage, item.name, item.line) || !add(item.descriptionMessage, item.description, item.line)) return false;
+    }
+    for (Element& element : world.elements) {
+        for (const auto& stage : element.stages) {
+            element.stageMessages.push_back("ELEMENT_" + idPart(element.room) + "_" + idPart(element.name) + "_" + std::to_string(stage.first));
+            if (!add(element.stageMessages.back(), stage.second, element.line)) return false;
+        }
+    }
+    std::map<std::string, size_t> perState;
+    for (const auto& d : world.dialogue) {
+        world.dialogueIds.push_back("DIALOGUE_" + d.first + "_" + std::to_string(++perState[d.first]));
+        if (!add(world.dialogueIds.back(), d.second, 1)) return false;
+    }
+    for (const auto& h : world.help) {
+        world.helpIds.push_back("HELP_" + idPart(h.first));
+        if (!add(world.helpIds.back(), h.second, 1)) return false;
+    }
+    for (Trigger& trigger : world.triggers) {
+        size_t lines = 0;
+        for (TriggerStep& step : trigger.steps) {
+            if (step.action != "say") continue;
+            step.message = "TRIGGER_" + idPart(trigger.name) + "_" + std::to_string(++lines);
+            if (!add(step.message, step.text, step.line)) return false;
+        }
+    }
+    if (world.catalog.size() >= 0xFFFF) {
+        error = path + ": too many messages";
+        return false;
+    }
+    return true;
+}
+
+// FNV-1a over the message IDs in order; a catalog only fits the build with the same fingerprint
+uint64_t messageSchema(const World& world) {
+    uint64_t hash = 14695981039346656037ull;
+    for (const Message& message : world.catalog) {
+        for (char c : message.id + "\n") {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+std::string literal(const std::string& text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '\n') {
+            quoted += "\\n";
+            continue;
+        }
+        if (c == '"' || c == '\\') quoted.push_back('\\');
+        quoted.push_back(c);
+    }
+    return quoted + "\"";
+}
+
+std::string generate(const std::string& sourcePath, const World& world, const std::unordered_map<std::string, size_t>& roomIndex) {
+    auto room = [&](const std::string& id) {
+        return id == "-" ? std::string("kNotPlaced") : std::to_string(roomIndex.at(id));
+    };
+
+    std::ostringstream out;
+    out << "// Generated by world_codegen from " << sourcePath << ". Do not edit; change the world file instead.\n"
+        << "#ifndef WORLD_TABLES_H\n#define WORLD_TABLES_H\n\n"
+        << "#include \"WorldDefinition.h\"\n#include \"Game.h\"\n\n";
+
+    out << "enum class MessageId : uint16_t {\n";
+    for (const Message& m : world.catalog) out << "    " << m.id << ",\n";
+    out << "};\n\n";
+    out << "inline constexpr uint32_t kMessageCount = " << world.catalog.size() << ";\n";
+    out << "inline constexpr uint64_t kMessageSchema = 0x" << std::hex << messageSchema(world) << std::dec << "ull;\n\n";
+    out << "// The built-in text of every message, by MessageId\n";
+    out << "inline constexpr std::string_view kWorldMessages[] = {\n";
+    for (const Message& m : world.catalog) out << "    " << literal(m.text) << ",\n";
+    out << "};\n\n";
+
+    out << "inline constexpr uint16_t kWorldStartRoom = " << roomIndex.at(world.start) << ";\n\n";
+
+    out << "inline constexpr WorldRoom kWorldRooms[] = {\n";
+    for (const Room& r : world.rooms) {
+        out << "    {" << literal(r.id) << ", MessageId::" << r.nameMessage << ", MessageId::" << r.descriptionMessage << "},\n";
+    }
+    out << "};\n\n";
+
+    out << "inline constexpr WorldExit kWorldExits[] = {\n";
+    for (const Exit& e : world.exits) {
+        out << "    {" << room(e.room) << ", " << literal(e.key) << ", " << room(e.target) << "},\n";
+    }
+    out << "};\n\n";
+
+    std::vector<std::string> aliases;
+    std::vector<std::string> stages; // Message IDs
+
+    out << "inline constexpr WorldItem kWorldItems[] = {\n";
+    for (const Item& i : world.items) {
+        out << "    {" << literal(i.id) << ", MessageId::" << i.nameMessage << ", MessageId::" << i.descriptionMessage << ",\n     "
+            << room(i.room) << ", " << aliases.size() << ", " << i.aliases.size() << "},\n";
+        aliases.insert(aliases.end(), i.aliases.begin(), i.aliases.end());
+    }
+    out << "};\n\n";
+
+    out << "inline constexpr WorldElement kWorldElements[] = {\n";
+    for (const Element& e : world.elements) {
+        out << "    {" << room(e.room) << ", " << literal(e.name) << ", " << stages.size() << ", " << e.stages.size()
+            << ", " << aliases.size() << ", " << e.aliases.size() << "},\n";
+        stages.insert(stages.end(), e.stageMessages.begin(), e.stageMessages.end());
+        aliases.insert(aliases.end(), e.aliases.begin(), e.aliases.end());
+    }
+    out << "};\n\n";
+
+    out << "inline constexpr std::string_view kWorldAliases[] = {\n";
+    for (const std::string& a : aliases) out << "    " << literal(a) << ",\n";
+    out << "};\n\n";
+
+    out << "inline constexpr MessageId kWorldStages[] = {\n";
+    for (const std::string& s : stages) out << "    MessageId::" << s << ",\n";
+    out << "};\n\n";
+
+    out << "inline constexpr WorldDialogue kWorldDialogue[] = {\n";
+    for (size_t i = 0; i < world.dialogue.size(); ++i) {
+        out << "    {GameState::" << world.dialogue[i].first << ", MessageId::" << world.dialogueIds[i] << "},\n";
+    }
+    out << "};\n\n";
+
+    out << "inline constexpr WorldHelp kWorldHelp[] = {\n";
+    for (size_t i = 0; i < world.help.size(); ++i) {
+        out << "    {" << literal(world.help[i].first) << ", MessageId::" << world.helpIds[i] << "},\n";
+    }
+    out << "};\n\n";
+
+    auto any = [](const std::string& value) { return value == "*" ? std::string() : value; };
+    auto capitalized = [](std::string name) {
+        name[0] = static_cast<char>(std::toupper(static_cast<unsigned char>(name[0])));
+        return name;
+    };
+    std::vector<const TriggerStep*> steps;
+    out << "inline constexpr WorldTrigger kWorldTriggers[] = {\n";
+    for (const Trigger& t : world.triggers) {
+        out << "    {" << literal(t.name) << ", TriggerEvent::" << capitalized(t.event) << ", " << literal(any(t.room)) << ", "
+            << literal(any(t.subject)) << ",\n     " << (t.state == "*" ? "true, GameState::INTRO" : "false, GameState::" + t.state)
+            << ", " << literal(t.element) << ", " << (t.elementStage < 0 ? 0 : t.elementStage) << ", "
+            << (t.needsCarried ? "true" : "false") << ", " << (t.needsUnspawned ? "true" : "false") << ", "
+            << steps.size() << ", " << t.steps.size() << "},\n";
+        for (const TriggerStep& step : t.steps) steps.push_back(&step);
+    }
+    out << "};\n\n";
+
+    out << "inline constexpr WorldTriggerStep kWorldTriggerSteps[] = {\n";
+    for (const TriggerStep* s : steps) {
+        std::string state = s->action == "state" ? s->text : "INTRO";
+        std::string text = s->action == "state" || s->action == "say" ? std::string() : s->text;
+        std::string message = s->action == "say" ? "MessageId::" + s->message : std::string("MessageId{}");
+        out << "    {TriggerAction::" << capitalized(s->action) << ", GameState::" << state << ", " << literal(text)
+            << ", " << s->stage << ", " << message << "},\n";
+    }
+    out << "};\n\n";
+
+    out << "#endif // WORLD_TABLES_H\n";
+    return out.str();
+}
+
+} // namespace
+
+// Writes 'contents' to 'path' unless the file already holds exactly that
+bool writeIfChanged(const std::string& path, const std::string& contents) {
+    std::ifstream existing(path, std::ios::binary);
+    std::ostringstream current;
+    current << existing.rdbuf();
+    if (existing && current.str() == contents) return true;
+
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    output << contents;
+    if (!output) {
+        std::cerr << path << ": cannot write" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Reads a locale file ('locale = <tag>' and '<MESSAGE_ID> = <text>' lines) into 'texts', indexed
+// like world.catalog. Lines it doesn't translate stay empty
+bool parseLocale(const std::string& path, const World& world, std::string& locale, std::vector<std::string>& texts,
+                 std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = path + ": cannot open";
+        return false;
+    }
+    auto fail = [&](size_t lineNumber, const std::string& message) {
+        error = path + ":" + std::to_string(lineNumber) + ": " + message;
+        return false;
+    };
+    std::unordered_map<std::string, size_t> index;
+    for (size_t i = 0; i < world.catalog.size(); ++i) index[world.catalog[i].id] = i;
+    texts.assign(world.catalog.size(), std::string());
+
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line[start] == '#') continue;
+
+        size_t separator = line.find(" = ");
+        if (separator == std::string::npos) return fail(lineNumber, "expected '<MESSAGE_ID> = <text>'");
+        std::string key = line.substr(start, separator - start);
+        std::string text = line.substr(separator + 3);
+        if (key == "locale") {
+            if (text.empty() || text.size() >= sizeof(MessageCatalog::Header::locale)) {
+                return fail(lineNumber, "locale tags are 1 to 7 characters");
+            }
+            locale = text;
+            continue;
+        }
+        auto it = index.find(key);
+        if (it == index.end()) return fail(lineNumber, "unknown message ID '" + key + "'");
+        if (!texts[it->second].empty()) return fail(lineNumber, "message '" + key + "' is translated twice");
+        texts[it->second] = unescape(text);
+    }
+    if (locale.empty()) return fail(lineNumber, "missing 'locale = <tag>' line");
+    return true;
+}
+
+std::string catalogBytes(const World& world, const std::string& locale, const std::vector<std::string>& texts) {
+    MessageCatalog::Header header = {};
+    std::memcpy(header.magic, MessageCatalog::kMagic, sizeof(header.magic));
+    header.version = MessageCatalog::kFormatVersion;
+    std::memcpy(header.locale, locale.data(), locale.size());
+    header.schema = messageSchema(world);
+    header.count = static_cast<uint32_t>(texts.size());
+
+    std::vector<uint32_t> offsets;
+    std::string text;
+    for (const std::string& line : texts) {
+        offsets.push_back(static_cast<uint32_t>(text.size()));
+        text += line;
+    }
+    offsets.push_back(static_cast<uint32_t>(text.size()));
+    header.textBytes = static_cast<uint32_t>(text.size());
+
+    std::string bytes(reinterpret_cast<const char*>(&header), sizeof(header));
+    bytes.append(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint32_t));
+    return bytes + text;
+}
+
+int main(int argc, char* argv[]) {
+    std::string mode = argc > 1 && std::strncmp(argv[1], "--", 2) == 0 ? argv[1] : "";
+    int expected = mode == "--catalog" ? 5 : (mode == "--template" ? 4 : 3);
+    if (argc != expected || (!mode.empty() && mode != "--catalog" && mode != "--template")) {
+        std::cerr << "Usage: " << argv[0] << " <world file> <output header>\n"
+                  << "       " << argv[0] << " --catalog <world file> <locale file | -> <output catalog>\n"
+                  << "       " << argv[0] << " --template <world file> <output locale file>" << std::endl;
+        return 1;
+    }
+    const char* worldPath = argv[mode.empty() ? 1 : 2];
+    World world;
+    std::unordered_map<std::string, size_t> roomIndex;
+    std::string error;
+    if (!parse(worldPath, world, error) || !validate(worldPath, world, roomIndex, error) ||
+        !assignMessages(worldPath, world, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    if (mode == "--template") {
+        std::ostringstream out;
+        out << "# Translation of the messages of " << worldPath << ". Lines left out keep the built-in text.\n"
+            << "locale = xx\n";
+        for (const Message& m : world.catalog) out << m.id << " = " << escape(m.text) << "\n";
+        return writeIfChanged(argv[3], out.str()) ? 0 : 1;
+    }
+    if (mode == "--catalog") {
+        std::string locale = "en";
+        std::vector<std::string> texts;
+        if (std::strcmp(argv[3], "-") == 0) {
+            for (const Message& m : world.catalog) texts.push_back(m.text);
+        } else if (!parseLocale(argv[3], world, locale, texts, error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+        return writeIfChanged(argv[4], catalogBytes(world, locale, texts)) ? 0 : 1;
+    }
+    return writeIfChanged(argv[2], generate(worldPath, world, roomIndex)) ? 0 : 1;
+}